@@ -0,0 +1,41 @@
+#pragma once
+// Helpers shared by the benchmarks.
+// Results are printed as CSV on stdout, with '#' comment lines for context, so runs can be diffed & plotted.
+#include "simd.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+static inline uint64_t bench_now_ns(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER        now;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+#else
+#include <time.h>
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+// Stops the optimiser from deleting work whose results are never read
+static volatile float gBenchSink;
+static inline void    bench_consume(const float* buf, int len) { gBenchSink += buf[0] + buf[len - 1]; }
+
+static inline void bench_print_header(const char* name)
+{
+    printf("# %s simd=%s width=%d\n", name, SIMD_NAME, SIMD_WIDTH);
+#if ! defined(__OPTIMIZE__) && ! defined(NDEBUG)
+    printf("# WARNING: built without optimisations, configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+}
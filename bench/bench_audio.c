@@ -0,0 +1,139 @@
+// Cost of the audio callback's DSP, timed one callback at a time.
+// Sweeps block size, device sample rate, voice count, unison stack size, and whether the modulation matrix is in use.
+// Besides the mean cost per sample, it reports the tail of the per callback times, since a single slow callback is
+// what causes a dropout.
+// Like the app, the synth runs at SYNTH_ENGINE_RATE through a BlockFifo, so the odd sizes some backends use are
+// included, and is resampled to the device's rate inside the timed callback.
+// usage: bench_audio [seconds of audio per config] [worker threads]
+#include "bench.h"
+#include "blockfifo.h"
+#include "resample.h"
+#include "synth.h"
+
+#include <stdlib.h>
+
+#define MAX_BLOCK_FRAMES 4096
+
+static const int gBlockSizes[]  = {16, 32, 64, 100, 128, 256, 441, 512, 1024, 2048, 4096};
+static const int gDeviceRates[] = {44100, 48000, 96000};
+static const int gVoiceCounts[] = {1, 8, 32, 64};
+static const int gUnison[]      = {1, 16};
+static const int gModulated[]   = {0, 1};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static Synth     gSynth;
+static BlockFifo gBlockFifo;
+static Resampler gResampler;
+static WorkPool  gPool;
+// Stereo, like the app
+#define NUM_CHANNELS 2
+
+static float    gBuffer[MAX_BLOCK_FRAMES * NUM_CHANNELS];
+static uint64_t gTimes[1 << 20];
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_us(const uint64_t* sorted, int n, double p)
+{
+    int i = (int)(p * (n - 1) + 0.5);
+    return (double)sorted[i] * 1e-3;
+}
+
+// The app's engine_render, without the MIDI
+static void engine_render(void* userdata, float* buffer, int numFrames)
+{
+    (void)userdata;
+    blockfifo_process(&gBlockFifo, &gSynth, NULL, 0, buffer, numFrames);
+}
+
+// The app's audio_cb
+static void audio_cb(float* buffer, int numFrames)
+{
+    resample_process(&gResampler, engine_render, NULL, buffer, numFrames);
+}
+
+static void bench_config(int deviceRate, int blockFrames, int numVoices, int unison, int modulated, double seconds)
+{
+    int      numBlocks  = (int)(seconds * deviceRate / blockFrames);
+    int      engineRate = SYNTH_ENGINE_RATE;
+    uint64_t total      = 0;
+
+    numBlocks = numBlocks < 16 ? 16 : numBlocks;
+    numBlocks = numBlocks > COUNT(gTimes) ? COUNT(gTimes) : numBlocks;
+
+    // Same fallback as the app's
+    if (resample_init(&gResampler, engineRate, deviceRate, NUM_CHANNELS) != 0)
+    {
+        engineRate = deviceRate;
+        resample_init(&gResampler, engineRate, engineRate, NUM_CHANNELS);
+    }
+    synth_init(&gSynth, (float)engineRate);
+    blockfifo_init(&gBlockFifo, NUM_CHANNELS);
+    gSynth.gaindB  = -12.0f;
+    gSynth.unison  = unison;
+    gSynth.workers = gPool.numWorkers > 0 ? &gPool : NULL;
+    for (int v = 0; v < numVoices; v++)
+        synth_note_on(&gSynth, (uint8_t)(36 + v), 100);
+    // Something on every destination, so the control rate path is always taken
+    if (modulated)
+    {
+        modmatrix_add(&gSynth.mod, MOD_SRC_LFO1, MOD_DST_PITCH, 0.2f);
+        modmatrix_add(&gSynth.mod, MOD_SRC_LFO2, MOD_DST_CUTOFF, 1.0f);
+        modmatrix_add(&gSynth.mod, MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, 3.0f);
+        modmatrix_add(&gSynth.mod, MOD_SRC_VELOCITY, MOD_DST_GAIN, 6.0f);
+    }
+
+    // Warm up caches & the branch predictor
+    for (int b = 0; b < 8; b++)
+        audio_cb(gBuffer, blockFrames);
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        uint64_t start = bench_now_ns();
+        audio_cb(gBuffer, blockFrames);
+        gTimes[b] = bench_now_ns() - start;
+        total     += gTimes[b];
+        bench_consume(gBuffer, blockFrames * NUM_CHANNELS);
+    }
+    qsort(gTimes, numBlocks, sizeof(*gTimes), compare_u64);
+
+    {
+        double nsPerSample = (double)total / ((double)numBlocks * blockFrames);
+        double blockUs     = 1e6 * blockFrames / deviceRate;
+        printf("%d,%d,%d,%d,%d,%d,%d,%.3f,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f\n", deviceRate, engineRate, blockFrames,
+               numVoices, unison, modulated, gPool.numWorkers, nsPerSample, 1e9 / (nsPerSample * deviceRate), blockUs,
+               percentile_us(gTimes, numBlocks, 0.5), percentile_us(gTimes, numBlocks, 0.99),
+               percentile_us(gTimes, numBlocks, 0.999), (double)gTimes[numBlocks - 1] * 1e-3);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds    = argc > 1 ? atof(argv[1]) : 1.0;
+    int    numWorkers = argc > 2 ? atoi(argv[2]) : 0;
+
+    // Same floating point mode as the app's audio thread
+    simd_flush_denormals();
+    workpool_init(&gPool, numWorkers);
+    bench_print_header("bench_audio");
+    // Per sample at the device's rate. realtime_factor is how many times faster than realtime the callback runs.
+    // block_us is the deadline
+    printf("device_rate,engine_rate,block_frames,voices,unison,modulated,workers,"
+           "ns_per_sample,realtime_factor,block_us,p50_us,p99_us,p999_us,max_us\n");
+
+    for (int s = 0; s < COUNT(gDeviceRates); s++)
+        for (int b = 0; b < COUNT(gBlockSizes); b++)
+            for (int v = 0; v < COUNT(gVoiceCounts); v++)
+                for (int u = 0; u < COUNT(gUnison); u++)
+                    for (int m = 0; m < COUNT(gModulated); m++)
+                        bench_config(gDeviceRates[s], gBlockSizes[b], gVoiceCounts[v], gUnison[u], gModulated[m],
+                                     seconds);
+    workpool_shutdown(&gPool);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Cost of one delay effect instance, stereo, for each preset & interpolation, against callback size.
+// Linear & cubic gather their taps & interpolate a control period at a time; allpass is recursive per sample.
+// 'instances' is how many stereo instances one core could run in real time at SAMPLE_RATE.
+// usage: bench_delay [seconds of audio per config]
+#include "bench.h"
+#include "delay.h"
+
+#include <stdlib.h>
+
+#define SAMPLE_RATE 48000
+#define MAX_BLOCK_FRAMES 1024
+
+static const int gBlockSizes[] = {16, 64, 256, 1024};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static Delay gDelay;
+static float gIn[2][MAX_BLOCK_FRAMES];
+static float gOut[2][MAX_BLOCK_FRAMES];
+
+static void bench_config(DelayType type, DelayInterp interp, int blockFrames, double seconds)
+{
+    const float* in[2]     = {gIn[0], gIn[1]};
+    float*       out[2]    = {gOut[0], gOut[1]};
+    int          numBlocks = (int)(seconds * SAMPLE_RATE / blockFrames);
+    uint64_t     start;
+    double       nsPerFrame;
+
+    numBlocks = numBlocks < 64 ? 64 : numBlocks;
+    if (delay_init(&gDelay, 2, SAMPLE_RATE, 1.0f) != 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    delay_set_type(&gDelay, type);
+    gDelay.interp = interp;
+    gDelay.mix    = 0.5f;
+
+    start = bench_now_ns();
+    for (int b = 0; b < numBlocks; b++)
+    {
+        delay_process(&gDelay, in, out, blockFrames);
+        bench_consume(gOut[0], blockFrames);
+    }
+    nsPerFrame = (double)(bench_now_ns() - start) / ((double)numBlocks * blockFrames);
+    delay_free(&gDelay);
+
+    printf("%s,%s,%d,%.3f,%.0f\n", DELAY_TYPE_NAMES[type], DELAY_INTERP_NAMES[interp], blockFrames, nsPerFrame,
+           1e9 / (nsPerFrame * SAMPLE_RATE));
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+
+    // Same floating point mode as the audio thread
+    simd_flush_denormals();
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < MAX_BLOCK_FRAMES; i++)
+            gIn[c][i] = (float)((i * 7919 + c * 104729) % 2001) / 1000.0f - 1.0f;
+
+    bench_print_header("bench_delay");
+    // ns_per_frame is per stereo frame
+    printf("type,interp,block_frames,ns_per_frame,instances\n");
+    for (int t = 0; t < DELAY_TYPE_COUNT; t++)
+        for (int i = 0; i < DELAY_INTERP_COUNT; i++)
+            for (int b = 0; b < COUNT(gBlockSizes); b++)
+                bench_config((DelayType)t, (DelayInterp)i, gBlockSizes[b], seconds);
+    return 0;
+}
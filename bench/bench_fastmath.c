@@ -0,0 +1,97 @@
+// Throughput of the fast math approximations against libm.
+// Inputs sweep each function's documented range. ns_per_call is the cost of one value, with the float libm call as
+// the baseline. test_fastmath checks their accuracy.
+#include "bench.h"
+#include "fastmath.h"
+
+#include <math.h>
+
+#define SWEEP_SIZE (1 << 20)
+#define BLOCK_SIZE 1024
+#define NUM_PASSES 2000
+
+static SIMD_ALIGNED float gIn[SWEEP_SIZE];
+static SIMD_ALIGNED float gOut[SWEEP_SIZE];
+
+typedef void (*Kernel)(const float* in, float* out, int n);
+
+#define DEFINE_KERNELS(NAME, LIBM, FAST)                                                                              \
+    static void NAME##_libm(const float* in, float* out, int n)                                                       \
+    {                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                   \
+            out[i] = LIBM(in[i]);                                                                                     \
+    }                                                                                                                 \
+    static void NAME##_scalar(const float* in, float* out, int n)                                                     \
+    {                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                   \
+            out[i] = FAST(in[i]);                                                                                     \
+    }                                                                                                                 \
+    static void NAME##_lanes(const float* in, float* out, int n)                                                      \
+    {                                                                                                                 \
+        for (int i = 0; i < n; i += SIMD_WIDTH)                                                                       \
+            simd_store(&out[i], FAST##_lanes(simd_load(&in[i])));                                                     \
+    }
+
+static float  libm_db_to_gain(float db) { return powf(10.0f, db / 20.0f); }
+static float  libm_gain_to_db(float g) { return 20.0f * log10f(g); }
+
+DEFINE_KERNELS(exp2, exp2f, fast_exp2)
+DEFINE_KERNELS(log2, log2f, fast_log2)
+DEFINE_KERNELS(tan, tanf, fast_tan)
+DEFINE_KERNELS(db_to_gain, libm_db_to_gain, fast_db_to_gain)
+DEFINE_KERNELS(gain_to_db, libm_gain_to_db, fast_gain_to_db)
+
+typedef struct MathFunc
+{
+    const char* name;
+    double      lo, hi;
+    int         logSweep; // sweep lo to hi as powers of 2
+    Kernel      kernels[3];
+} MathFunc;
+
+static const char* gKernelNames[3] = {"libm", "scalar", SIMD_NAME};
+
+static const MathFunc gFuncs[] = {
+    {"exp2", -126, 127, 0, {exp2_libm, exp2_scalar, exp2_lanes}},
+    {"log2", -126, 127, 1, {log2_libm, log2_scalar, log2_lanes}},
+    {"tan", 0, 0.49 * 3.141592653589793, 0, {tan_libm, tan_scalar, tan_lanes}},
+    {"db_to_gain", -120, 40, 0, {db_to_gain_libm, db_to_gain_scalar, db_to_gain_lanes}},
+    {"gain_to_db", -126, 127, 1, {gain_to_db_libm, gain_to_db_scalar, gain_to_db_lanes}},
+};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static void fill_sweep(const MathFunc* func)
+{
+    for (int i = 0; i < SWEEP_SIZE; i++)
+    {
+        double u = func->lo + (func->hi - func->lo) * i / (SWEEP_SIZE - 1);
+        gIn[i]   = (float)(func->logSweep ? exp2(u) : u);
+    }
+}
+
+static double ns_per_call(Kernel kernel)
+{
+    uint64_t start = bench_now_ns();
+    for (int p = 0; p < NUM_PASSES; p++)
+    {
+        kernel(gIn + (p % 64) * BLOCK_SIZE, gOut, BLOCK_SIZE);
+        bench_consume(gOut, BLOCK_SIZE);
+    }
+    return (double)(bench_now_ns() - start) / ((double)NUM_PASSES * BLOCK_SIZE);
+}
+
+int main()
+{
+    bench_print_header("bench_fastmath");
+    printf("function,kernel,ns_per_call\n");
+
+    for (int f = 0; f < COUNT(gFuncs); f++)
+    {
+        const MathFunc* func = &gFuncs[f];
+        fill_sweep(func);
+        for (int k = 0; k < 3; k++)
+            printf("%s,%s,%.3f\n", func->name, gKernelNames[k], ns_per_call(func->kernels[k]));
+    }
+    return 0;
+}
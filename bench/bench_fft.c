@@ -0,0 +1,116 @@
+// Throughput of the FFTs in fft.h, complex & real, for every supported size.
+// mflops counts 5 N log2 N flops per complex FFT and half that per real FFT, the usual convention.
+// test_fft checks their accuracy.
+#include "bench.h"
+#include "fft.h"
+
+#include <string.h>
+
+#define POINTS_PER_RUN (1 << 23)
+
+static SIMD_ALIGNED float gIn[2][FFT_MAX_SIZE];
+static SIMD_ALIGNED float gRe[FFT_MAX_SIZE + SIMD_WIDTH];
+static SIMD_ALIGNED float gIm[FFT_MAX_SIZE + SIMD_WIDTH];
+static SIMD_ALIGNED float gOut[FFT_MAX_SIZE];
+
+static void fill_random(int n)
+{
+    unsigned state = 0x12345678u;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            state     ^= state << 13;
+            state     ^= state >> 17;
+            state     ^= state << 5;
+            gIn[c][i] = (float)state / 4294967296.0f * 2.0f - 1.0f;
+        }
+    }
+}
+
+static int log2_int(int n)
+{
+    int bits = 0;
+    while ((1 << bits) < n)
+        bits++;
+    return bits;
+}
+
+static void report(const char* transform, int n, double ns, double flops)
+{
+    printf("%s,%d,%.1f,%.0f\n", transform, n, ns, flops / ns * 1e3);
+    fflush(stdout);
+}
+
+// Returns non zero if out of memory
+static int bench_complex(int n)
+{
+    FftPlan  plan;
+    int      runs = POINTS_PER_RUN / n;
+    uint64_t start;
+    double   ns;
+
+    if (fft_plan_init(&plan, n))
+        return 1;
+
+    memcpy(gRe, gIn[0], n * sizeof(float));
+    memcpy(gIm, gIn[1], n * sizeof(float));
+
+    // Forward & inverse in turn keep the values bounded
+    start = bench_now_ns();
+    for (int r = 0; r < runs; r++)
+    {
+        if (r & 1)
+            fft_inverse(&plan, gRe, gIm);
+        else
+            fft_forward(&plan, gRe, gIm);
+        bench_consume(gRe, n);
+    }
+    ns = (double)(bench_now_ns() - start) / runs;
+
+    fft_plan_free(&plan);
+    report("complex", n, ns, 5.0 * n * log2_int(n));
+    return 0;
+}
+
+// Returns non zero if out of memory
+static int bench_real(int n)
+{
+    FftRealPlan plan;
+    int         runs = POINTS_PER_RUN / n;
+    uint64_t    start;
+    double      ns;
+
+    if (fft_real_plan_init(&plan, n))
+        return 1;
+
+    start = bench_now_ns();
+    for (int r = 0; r < runs; r++)
+    {
+        if (r & 1)
+            fft_real_inverse(&plan, gRe, gIm, gOut);
+        else
+            fft_real_forward(&plan, gIn[0], gRe, gIm);
+        bench_consume(gRe, n / 2);
+    }
+    ns = (double)(bench_now_ns() - start) / runs;
+
+    fft_real_plan_free(&plan);
+    report("real", n, ns, 2.5 * n * log2_int(n));
+    return 0;
+}
+
+int main()
+{
+    int failed = 0;
+
+    bench_print_header("bench_fft");
+    printf("transform,size,ns_per_call,mflops\n");
+
+    fill_random(FFT_MAX_SIZE);
+    for (int n = FFT_MIN_SIZE; n <= FFT_MAX_SIZE; n *= 2)
+        failed |= bench_complex(n);
+    for (int n = FFT_MIN_SIZE; n <= FFT_MAX_SIZE; n *= 2)
+        failed |= bench_real(n);
+    return failed;
+}
@@ -0,0 +1,81 @@
+// Per sample cost of the oscillator kernels.
+// Renders the same voices through the naive square, the scalar PolyBLEP kernels and the SIMD kernels.
+#include "bench.h"
+#include "osc.h"
+
+#define BLOCK_FRAMES 128
+#define NUM_BLOCKS 20000
+
+static SIMD_ALIGNED float gOut[BLOCK_FRAMES * SIMD_WIDTH];
+
+static double bench_naive(void)
+{
+    float    phase[SIMD_WIDTH] = {0};
+    uint64_t start             = bench_now_ns();
+    for (int b = 0; b < NUM_BLOCKS; b++)
+    {
+        for (int v = 0; v < SIMD_WIDTH; v++)
+        {
+            float inc = 0.01f + v * 0.001f;
+            for (int i = 0; i < BLOCK_FRAMES; i++)
+            {
+                gOut[i]  = phase[v] >= 0.5f ? 1.0f : -1.0f;
+                phase[v] += inc;
+                phase[v] -= (int)phase[v];
+            }
+            bench_consume(gOut, BLOCK_FRAMES);
+        }
+    }
+    return (double)(bench_now_ns() - start) / ((double)NUM_BLOCKS * BLOCK_FRAMES * SIMD_WIDTH);
+}
+
+static double bench_scalar(OscShape shape)
+{
+    float    phase[SIMD_WIDTH] = {0};
+    uint64_t start             = bench_now_ns();
+    for (int b = 0; b < NUM_BLOCKS; b++)
+    {
+        for (int v = 0; v < SIMD_WIDTH; v++)
+        {
+            osc_render_scalar(shape, &phase[v], 0.01f + v * 0.001f, 0.5f, gOut, BLOCK_FRAMES);
+            bench_consume(gOut, BLOCK_FRAMES);
+        }
+    }
+    return (double)(bench_now_ns() - start) / ((double)NUM_BLOCKS * BLOCK_FRAMES * SIMD_WIDTH);
+}
+
+static double bench_lanes(OscShape shape)
+{
+    SIMD_ALIGNED float phase[SIMD_WIDTH] = {0};
+    SIMD_ALIGNED float inc[SIMD_WIDTH];
+    for (int v = 0; v < SIMD_WIDTH; v++)
+        inc[v] = 0.01f + v * 0.001f;
+
+    uint64_t start = bench_now_ns();
+    for (int b = 0; b < NUM_BLOCKS; b++)
+    {
+        osc_render_lanes(shape, phase, inc, 0.5f, gOut, BLOCK_FRAMES);
+        bench_consume(gOut, BLOCK_FRAMES * SIMD_WIDTH);
+    }
+    return (double)(bench_now_ns() - start) / ((double)NUM_BLOCKS * BLOCK_FRAMES * SIMD_WIDTH);
+}
+
+static void print_row(const char* shape, const char* kernel, double ns)
+{
+    // How many voices one core could run at 48kHz, ignoring everything else
+    printf("%s,%s,%.3f,%.0f\n", shape, kernel, ns, 1e9 / (ns * 48000.0));
+}
+
+int main()
+{
+    bench_print_header("bench_osc");
+    printf("shape,kernel,ns_per_sample,voices_per_core_48k\n");
+
+    print_row(OSC_SHAPE_NAMES[OSC_SQUARE], "naive", bench_naive());
+    for (int s = 0; s < OSC_SHAPE_COUNT; s++)
+    {
+        print_row(OSC_SHAPE_NAMES[s], "scalar", bench_scalar((OscShape)s));
+        print_row(OSC_SHAPE_NAMES[s], SIMD_NAME, bench_lanes((OscShape)s));
+    }
+    return 0;
+}
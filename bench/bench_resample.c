@@ -0,0 +1,117 @@
+// Throughput & accuracy of the polyphase resampler, stereo, for the common device rate conversions.
+// A sine is resampled and compared with the same sine generated at the output rate. snr_db is the level of the
+// sine against everything else, so it covers both aliasing & passband error.
+#include "bench.h"
+#include "resample.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_CHANNELS 2
+#define BLOCK_FRAMES 512
+#define NUM_BLOCKS 4000
+#define TONE_HZ 1000.0
+
+typedef struct Ratio
+{
+    int inRate;
+    int outRate;
+} Ratio;
+
+static const Ratio gRatios[] = {
+    {48000, 44100}, {44100, 48000}, {48000, 96000}, {96000, 48000}, {48000, 88200}, {48000, 32000},
+};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static Resampler gResampler;
+static float     gOut[BLOCK_FRAMES * NUM_CHANNELS];
+static float     gNoise[RESAMPLE_MAX_INPUT * NUM_CHANNELS];
+
+typedef struct Tone
+{
+    double   phaseInc;
+    uint64_t frame;
+} Tone;
+
+static void fill_tone(void* userdata, float* buffer, int numFrames)
+{
+    Tone* tone = userdata;
+    for (int i = 0; i < numFrames; i++, tone->frame++)
+    {
+        float x = (float)(0.5 * sin(tone->phaseInc * (double)tone->frame));
+        for (int c = 0; c < NUM_CHANNELS; c++)
+            buffer[i * NUM_CHANNELS + c] = x;
+    }
+}
+
+// Costs next to nothing, so the timings are the resampler's own
+static void fill_noise(void* userdata, float* buffer, int numFrames)
+{
+    (void)userdata;
+    memcpy(buffer, gNoise, numFrames * NUM_CHANNELS * sizeof(*buffer));
+}
+
+static double measure_snr(const Ratio* ratio)
+{
+    static const double pi = 3.141592653589793;
+
+    Tone   tone   = {2 * pi * TONE_HZ / ratio->inRate, 0};
+    double signal = 0, noise = 0;
+    // Output frame n lines up with input frame n * in / out - RESAMPLE_TAPS / 2
+    double delay = (double)(RESAMPLE_TAPS / 2) / ratio->inRate;
+
+    resample_init(&gResampler, ratio->inRate, ratio->outRate, NUM_CHANNELS);
+    for (int b = 0; b < 64; b++)
+    {
+        resample_process(&gResampler, fill_tone, &tone, gOut, BLOCK_FRAMES);
+        // Skip the filter's warm up
+        if (b == 0)
+            continue;
+        for (int i = 0; i < BLOCK_FRAMES; i++)
+        {
+            double t    = (double)(b * BLOCK_FRAMES + i) / ratio->outRate - delay;
+            double want = 0.5 * sin(2 * pi * TONE_HZ * t);
+            double err  = gOut[i * NUM_CHANNELS] - want;
+            signal      += want * want;
+            noise       += err * err;
+        }
+    }
+    return 10 * log10(signal / noise);
+}
+
+static double bench_ratio(const Ratio* ratio)
+{
+    uint64_t start;
+
+    resample_init(&gResampler, ratio->inRate, ratio->outRate, NUM_CHANNELS);
+    start = bench_now_ns();
+    for (int b = 0; b < NUM_BLOCKS; b++)
+    {
+        resample_process(&gResampler, fill_noise, NULL, gOut, BLOCK_FRAMES);
+        bench_consume(gOut, BLOCK_FRAMES * NUM_CHANNELS);
+    }
+    return (double)(bench_now_ns() - start) / ((double)NUM_BLOCKS * BLOCK_FRAMES);
+}
+
+int main()
+{
+    for (int i = 0; i < COUNT(gNoise); i++)
+        gNoise[i] = (float)rand() / RAND_MAX - 0.5f;
+
+    bench_print_header("bench_resample");
+    // realtime_factor is at the output rate
+    printf("# taps=%d channels=%d\n", RESAMPLE_TAPS, NUM_CHANNELS);
+    printf("in_rate,out_rate,up,down,ns_per_frame,realtime_factor,snr_db\n");
+
+    for (int i = 0; i < COUNT(gRatios); i++)
+    {
+        const Ratio* ratio = &gRatios[i];
+        double       ns    = bench_ratio(ratio);
+        double       snr   = measure_snr(ratio);
+        printf("%d,%d,%d,%d,%.2f,%.0f,%.1f\n", ratio->inRate, ratio->outRate, gResampler.up, gResampler.down, ns,
+               1e9 / (ns * ratio->outRate), snr);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Cost of the convolution reverb against IR length & callback size.
+// The tail either runs inline, where every REVERB_TAIL_FRAMES one callback does the large FFT, or on the reverb's
+// background thread, where callbacks only do the head. Inline shows the total cost, threaded what the audio thread
+// sees. The tail of the per callback times matters more than the mean, since one slow callback is a dropout.
+// usage: bench_reverb [seconds of audio per config]
+#include "bench.h"
+#include "reverb.h"
+
+#include <stdlib.h>
+
+#define SAMPLE_RATE 48000
+#define MAX_BLOCK_FRAMES 1024
+#define MAX_IR_SECONDS 8
+
+static const float gIrSeconds[]  = {0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f};
+static const int   gBlockSizes[] = {32, 64, 128, 256, 512, 1024};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static Reverb   gReverb;
+static float    gIr[2][MAX_IR_SECONDS * SAMPLE_RATE];
+static float    gIn[2][MAX_BLOCK_FRAMES];
+static float    gOut[2][MAX_BLOCK_FRAMES];
+static uint64_t gTimes[1 << 16];
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_config(float irSeconds, int blockFrames, int background, double seconds)
+{
+    const float* ir[2]     = {gIr[0], gIr[1]};
+    const float* in[2]     = {gIn[0], gIn[1]};
+    float*       out[2]    = {gOut[0], gOut[1]};
+    int          numBlocks = (int)(seconds * SAMPLE_RATE / blockFrames);
+    uint64_t     total     = 0;
+
+    numBlocks = numBlocks < 64 ? 64 : numBlocks;
+    numBlocks = numBlocks > COUNT(gTimes) ? COUNT(gTimes) : numBlocks;
+
+    if (reverb_init(&gReverb, ir, (int)(irSeconds * SAMPLE_RATE), 2, SAMPLE_RATE, background) != 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    gReverb.wet = 0.5f;
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        uint64_t start = bench_now_ns();
+        reverb_process(&gReverb, in, out, blockFrames);
+        gTimes[b] = bench_now_ns() - start;
+        total     += gTimes[b];
+        bench_consume(gOut[0], blockFrames);
+    }
+    reverb_free(&gReverb);
+    qsort(gTimes, numBlocks, sizeof(*gTimes), compare_u64);
+
+    {
+        double nsPerSample = (double)total / ((double)numBlocks * blockFrames);
+        printf("%.2f,%d,%s,%.3f,%.1f,%.2f,%.2f,%.2f\n", irSeconds, blockFrames, background ? "thread" : "inline",
+               nsPerSample, 1e9 / (nsPerSample * SAMPLE_RATE), 1e6 * blockFrames / SAMPLE_RATE,
+               (double)gTimes[(int)(0.99 * (numBlocks - 1))] * 1e-3, (double)gTimes[numBlocks - 1] * 1e-3);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    float* ir[2]   = {gIr[0], gIr[1]};
+
+    // Same floating point mode as the audio thread
+    simd_flush_denormals();
+    reverb_generate_ir(ir, MAX_IR_SECONDS * SAMPLE_RATE, 2, SAMPLE_RATE, 2.0f);
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < MAX_BLOCK_FRAMES; i++)
+            gIn[c][i] = (float)((i * 7919 + c * 104729) % 2001) / 1000.0f - 1.0f;
+
+    bench_print_header("bench_reverb");
+    // ns_per_sample is per stereo frame. block_us is the deadline
+    printf("ir_seconds,block_frames,tail,ns_per_sample,realtime_factor,block_us,p99_us,max_us\n");
+    for (int i = 0; i < COUNT(gIrSeconds); i++)
+        for (int b = 0; b < COUNT(gBlockSizes); b++)
+            for (int t = 0; t < 2; t++)
+                bench_config(gIrSeconds[i], gBlockSizes[b], t, seconds);
+    return 0;
+}
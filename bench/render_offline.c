@@ -0,0 +1,149 @@
+// Renders a MIDI file to WAV through the sokol_audio dummy backend, without a sound card.
+// The stream callback is pulled in a tight loop, as fast as the CPU allows, and the realtime factor is reported.
+// usage: render_offline <in.mid> <out.wav> [sample_rate] [block_frames]
+#include "bench.h"
+#include "blockfifo.h"
+#include "resample.h"
+#include "smf.h"
+#include "sokol_audio.h"
+#include "synth.h"
+#include "wav.h"
+
+#include <stdlib.h>
+
+// Let voices ring out after the last event
+#define TAIL_SECONDS 2.0
+#define MAX_BLOCK_EVENTS 1024
+
+static Synth      gSynth;
+static BlockFifo  gBlockFifo;
+static Resampler  gResampler;
+static SmfFile    gSmf;
+static int        gNextEvent;
+static uint64_t   gFrame;
+static SynthEvent gEvents[MAX_BLOCK_EVENTS];
+
+// Renders numFrames at the engine's rate
+static void engine_render(void* userdata, float* buffer, int numFrames)
+{
+    (void)userdata;
+
+    // Events are scheduled on the engine's clock, which is ahead of the output by what the FIFO holds
+    uint64_t blockEnd  = gFrame + blockfifo_frames_to_render(&gBlockFifo, numFrames);
+    int      numEvents = 0;
+
+    while (gNextEvent < gSmf.numEvents && numEvents < MAX_BLOCK_EVENTS)
+    {
+        const SmfEvent* e     = &gSmf.events[gNextEvent];
+        uint64_t        frame = (uint64_t)(e->seconds * gSynth.sampleRate + 0.5);
+        if (frame >= blockEnd)
+            break;
+        // Only late when a block holds more than MAX_BLOCK_EVENTS
+        gEvents[numEvents].frame  = frame > gFrame ? (int)(frame - gFrame) : 0;
+        gEvents[numEvents].status = e->status;
+        gEvents[numEvents].data1  = e->data1;
+        gEvents[numEvents].data2  = e->data2;
+        numEvents++;
+        gNextEvent++;
+    }
+
+    blockfifo_process(&gBlockFifo, &gSynth, gEvents, numEvents, buffer, numFrames);
+    gFrame = blockEnd;
+}
+
+static void render_cb(float* buffer, int num_frames, int num_channels)
+{
+    (void)num_channels;
+    simd_flush_denormals();
+    resample_process(&gResampler, engine_render, NULL, buffer, num_frames);
+}
+
+int main(int argc, char** argv)
+{
+    WavWriter wav;
+    float*    buffer;
+    uint64_t  totalFrames;
+    uint64_t  renderNs = 0;
+    int       sampleRate, blockFrames, err;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <in.mid> <out.wav> [sample_rate] [block_frames]\n", argv[0]);
+        return 1;
+    }
+    sampleRate  = argc > 3 ? atoi(argv[3]) : 48000;
+    blockFrames = argc > 4 ? atoi(argv[4]) : 512;
+    if (sampleRate <= 0 || blockFrames <= 0)
+    {
+        fprintf(stderr, "sample_rate & block_frames must be positive\n");
+        return 1;
+    }
+
+    err = smf_load(&gSmf, argv[1]);
+    if (err != SMF_OK)
+    {
+        fprintf(stderr, "Failed reading %s (error %d)\n", argv[1], err);
+        return 1;
+    }
+
+    saudio_setup(&(saudio_desc){
+        .sample_rate   = sampleRate,
+        .buffer_frames = blockFrames,
+        .packet_frames = blockFrames,
+        .num_channels  = 2,
+        .stream_cb     = render_cb,
+    });
+    if (! saudio_isvalid())
+    {
+        fprintf(stderr, "Failed initialising sokol_audio\n");
+        return 1;
+    }
+    // Like the app, the synth runs at its own rate and is converted to the output's
+    if (resample_init(&gResampler, SYNTH_ENGINE_RATE, saudio_sample_rate(), saudio_channels()) != 0)
+    {
+        fprintf(stderr, "Can't convert from %d to %dHz\n", SYNTH_ENGINE_RATE, saudio_sample_rate());
+        return 1;
+    }
+    synth_init(&gSynth, (float)SYNTH_ENGINE_RATE);
+    blockfifo_init(&gBlockFifo, saudio_channels());
+    gSynth.gaindB = -12.0f;
+
+    if (wav_open(&wav, argv[2], saudio_sample_rate(), saudio_channels()) != 0)
+    {
+        fprintf(stderr, "Failed opening %s\n", argv[2]);
+        return 1;
+    }
+
+    buffer      = malloc((size_t)blockFrames * saudio_channels() * sizeof(*buffer));
+    totalFrames = (uint64_t)((gSmf.lengthSeconds + TAIL_SECONDS) * saudio_sample_rate());
+    // gFrame counts at the engine's rate, so the output is counted separately
+    for (uint64_t written = 0; written < totalFrames;)
+    {
+        int      numFrames = totalFrames - written < (uint64_t)blockFrames ? (int)(totalFrames - written) : blockFrames;
+        uint64_t start     = bench_now_ns();
+        // Only the DSP is timed, not the disk
+        saudio_dummy_pull(buffer, numFrames);
+        renderNs += bench_now_ns() - start;
+        if (wav_write(&wav, buffer, numFrames) != 0)
+        {
+            fprintf(stderr, "Failed writing %s\n", argv[2]);
+            return 1;
+        }
+        written += numFrames;
+    }
+    wav_close(&wav);
+    saudio_shutdown();
+
+    bench_print_header("render_offline");
+    printf("file,sample_rate,block_frames,events,audio_seconds,render_seconds,realtime_factor\n");
+    {
+        double audioSeconds  = (double)totalFrames / saudio_sample_rate();
+        double renderSeconds = (double)renderNs * 1e-9;
+        printf("%s,%d,%d,%d,%.3f,%.3f,%.1f\n", argv[1], sampleRate, blockFrames, gSmf.numEvents, audioSeconds,
+               renderSeconds, renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0);
+    }
+
+    free(buffer);
+    smf_free(&gSmf);
+    return 0;
+}
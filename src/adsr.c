@@ -0,0 +1,101 @@
+#include "adsr.h"
+
+#include <math.h>
+#include <string.h>
+
+// How far past the end of each stage its target is, as a fraction of full scale. A large overshoot makes the
+// attack close to linear, a small one makes decay & release close to a true exponential
+#define ADSR_ATTACK_OVERSHOOT 0.3f
+#define ADSR_DECAY_OVERSHOOT 0.0001f
+
+// Coefficient that covers 1 + overshoot in 'seconds', ending up 'overshoot' from the target
+static float adsr_coef(float seconds, float overshoot, float sampleRate)
+{
+    float numFrames = seconds * sampleRate;
+    if (numFrames < 1.0f)
+        return 0.0f;
+    return expf(-logf((1.0f + overshoot) / overshoot) / numFrames);
+}
+
+AdsrCoeffs adsr_coeffs(const AdsrParams* params, float sampleRate)
+{
+    AdsrCoeffs c;
+
+    c.attackCoef  = adsr_coef(params->attack, ADSR_ATTACK_OVERSHOOT, sampleRate);
+    c.attackBase  = (1.0f + ADSR_ATTACK_OVERSHOOT) * (1.0f - c.attackCoef);
+    c.decayCoef   = adsr_coef(params->decay, ADSR_DECAY_OVERSHOOT, sampleRate);
+    c.decayBase   = (params->sustain - ADSR_DECAY_OVERSHOOT) * (1.0f - c.decayCoef);
+    c.releaseCoef = adsr_coef(params->release, ADSR_DECAY_OVERSHOOT, sampleRate);
+    c.releaseBase = -ADSR_DECAY_OVERSHOOT * (1.0f - c.releaseCoef);
+    return c;
+}
+
+void adsr_bank_init(AdsrBank* bank) { memset(bank, 0, sizeof(*bank)); }
+
+void adsr_bank_copy_lane(AdsrBank* bank, int dst, int src)
+{
+    bank->level[dst] = bank->level[src];
+    bank->coef[dst]  = bank->coef[src];
+    bank->base[dst]  = bank->base[src];
+    bank->stage[dst] = bank->stage[src];
+}
+
+void adsr_bank_reset_lane(AdsrBank* bank, int lane)
+{
+    bank->level[lane] = 0.0f;
+    bank->coef[lane]  = 0.0f;
+    bank->base[lane]  = 0.0f;
+    bank->stage[lane] = ADSR_IDLE;
+}
+
+void adsr_note_on(AdsrBank* bank, int lane, const AdsrCoeffs* c)
+{
+    bank->coef[lane]  = c->attackCoef;
+    bank->base[lane]  = c->attackBase;
+    bank->stage[lane] = ADSR_ATTACK;
+}
+
+void adsr_note_off(AdsrBank* bank, int lane, const AdsrCoeffs* c)
+{
+    bank->coef[lane]  = c->releaseCoef;
+    bank->base[lane]  = c->releaseBase;
+    bank->stage[lane] = ADSR_RELEASE;
+}
+
+void adsr_retarget_decay(AdsrBank* bank, int lane, const AdsrCoeffs* c)
+{
+    if (adsr_stage(bank, lane) != ADSR_DECAY)
+        return;
+    bank->coef[lane] = c->decayCoef;
+    bank->base[lane] = c->decayBase;
+}
+
+void adsr_process_lanes(AdsrBank* bank, const AdsrCoeffs* c, int lane, float* buf, int numFrames)
+{
+    const simd_f zero      = simd_set1(0.0f);
+    const simd_f one       = simd_set1(1.0f);
+    const simd_f decayCoef = simd_set1(c->decayCoef);
+    const simd_f decayBase = simd_set1(c->decayBase);
+    const simd_f decay     = simd_set1((float)ADSR_DECAY);
+    simd_f       level     = simd_load(&bank->level[lane]);
+    simd_f       coef      = simd_load(&bank->coef[lane]);
+    simd_f       base      = simd_load(&bank->base[lane]);
+    simd_f       stage     = simd_load(&bank->stage[lane]);
+
+    for (int i = 0; i < numFrames; i++, buf += SIMD_WIDTH)
+    {
+        // Only the attack reaches full scale. Lanes that get there move on to decay
+        simd_m top;
+        level = simd_fmadd(level, coef, base);
+        top   = simd_cmpge(level, one);
+        coef  = simd_select(top, decayCoef, coef);
+        base  = simd_select(top, decayBase, base);
+        stage = simd_select(top, decay, stage);
+        level = simd_max(simd_min(level, one), zero);
+        simd_store(buf, simd_mul(simd_load(buf), level));
+    }
+    simd_store(&bank->level[lane], level);
+    simd_store(&bank->coef[lane], coef);
+    simd_store(&bank->base[lane], base);
+    simd_store(&bank->stage[lane], stage);
+}
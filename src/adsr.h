@@ -0,0 +1,72 @@
+#pragma once
+#include "simd.h"
+
+// Exponential ADSR envelopes, one per SIMD lane.
+// Each stage is a one pole filter heading for a target a little past where the stage ends:
+// level = level * coef + base. That's one multiply-add per sample, with no exp() in the loop.
+// Overshooting the target makes each stage end in a finite time. Attack hands over to decay with a per lane
+// compare & select instead of a branch, decay settles on the sustain level by itself, and release clamps at 0.
+// https://www.earlevel.com/main/2013/06/03/envelope-generators-adsr-code/
+
+#define ADSR_MAX_LANES 64
+
+// Times in seconds, from silence to full scale
+typedef struct AdsrParams
+{
+    float attack;
+    float decay;
+    float sustain; // 0-1
+    float release;
+} AdsrParams;
+
+// Recurrence for each stage
+typedef struct AdsrCoeffs
+{
+    float attackCoef, attackBase;
+    float decayCoef, decayBase;
+    float releaseCoef, releaseBase;
+} AdsrCoeffs;
+
+AdsrCoeffs adsr_coeffs(const AdsrParams* params, float sampleRate);
+
+// Decay carries on into sustain: it settles on the sustain level by itself
+typedef enum AdsrStage
+{
+    ADSR_IDLE,
+    ADSR_ATTACK,
+    ADSR_DECAY,
+    ADSR_RELEASE,
+} AdsrStage;
+
+typedef struct AdsrBank
+{
+    SIMD_ALIGNED float level[ADSR_MAX_LANES];
+    SIMD_ALIGNED float coef[ADSR_MAX_LANES];
+    SIMD_ALIGNED float base[ADSR_MAX_LANES];
+    // AdsrStage of each lane, as a float so attack can hand over to decay with a select. Coefficients can't tell
+    // the stages apart: with a sustain of 0, decay & release of the same length have the same ones
+    SIMD_ALIGNED float stage[ADSR_MAX_LANES];
+} AdsrBank;
+
+// All lanes start finished
+void adsr_bank_init(AdsrBank* bank);
+void adsr_bank_copy_lane(AdsrBank* bank, int dst, int src);
+void adsr_bank_reset_lane(AdsrBank* bank, int lane);
+
+// Starts the attack from wherever the lane's level is
+void adsr_note_on(AdsrBank* bank, int lane, const AdsrCoeffs* c);
+void adsr_note_off(AdsrBank* bank, int lane, const AdsrCoeffs* c);
+// Points lanes in decay or sustain at a new sustain level. Other lanes carry on with the coefficients they have
+void adsr_retarget_decay(AdsrBank* bank, int lane, const AdsrCoeffs* c);
+
+static inline AdsrStage adsr_stage(const AdsrBank* bank, int lane) { return (AdsrStage)bank->stage[lane]; }
+
+// Silent and heading nowhere, either released or decayed to a sustain of 0
+static inline int adsr_is_finished(const AdsrBank* bank, int lane)
+{
+    return bank->level[lane] <= 0.0f && bank->base[lane] <= 0.0f;
+}
+
+// Multiplies lanes [lane, lane + SIMD_WIDTH) of 'buf' by their envelopes. 'buf' is lane interleaved,
+// SIMD_WIDTH lanes wide
+void adsr_process_lanes(AdsrBank* bank, const AdsrCoeffs* c, int lane, float* buf, int numFrames);
@@ -0,0 +1,114 @@
+#include "analyzer.h"
+#include "fastmath.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+int analyzer_init(Analyzer* an, float sampleRate)
+{
+    static const double pi = 3.14159265358979323846;
+
+    memset(an, 0, sizeof(*an));
+    an->sampleRate = sampleRate;
+    for (int i = 0; i < ANALYZER_FFT_SIZE; i++)
+        an->window[i] = (float)(0.5 - 0.5 * cos(2.0 * pi * i / ANALYZER_FFT_SIZE));
+    for (int k = 0; k < ANALYZER_NUM_BINS; k++)
+        an->db[k] = ANALYZER_MIN_DB;
+    return fft_real_plan_init(&an->fft, ANALYZER_FFT_SIZE);
+}
+
+void analyzer_free(Analyzer* an) { fft_real_plan_free(&an->fft); }
+
+void analyzer_push(Analyzer* an, const float* frames, int numFrames, int numChannels)
+{
+    const float scale = 1.0f / (float)numChannels;
+
+    // Only the last ANALYZER_FFT_SIZE frames can be seen
+    if (numFrames > ANALYZER_FFT_SIZE)
+    {
+        frames    += (numFrames - ANALYZER_FFT_SIZE) * numChannels;
+        numFrames = ANALYZER_FFT_SIZE;
+    }
+    for (int i = 0; i < numFrames; i++, frames += numChannels)
+    {
+        float sum = 0;
+        for (int c = 0; c < numChannels; c++)
+            sum += frames[c];
+        an->history[an->historyPos] = sum * scale;
+        an->historyPos              = (an->historyPos + 1) & (ANALYZER_FFT_SIZE - 1);
+    }
+    an->numFresh += numFrames;
+}
+
+void analyzer_update(Analyzer* an, float seconds)
+{
+    const int   first = ANALYZER_FFT_SIZE - an->historyPos;
+    // A full scale sine's bin is N / 4: the window sums to N / 2, shared with the negative frequency
+    const float norm  = 16.0f / ((float)ANALYZER_FFT_SIZE * ANALYZER_FFT_SIZE);
+
+    simd_f fall  = simd_set1(ANALYZER_FALL_DB_PER_SECOND * seconds);
+    simd_f minDb = simd_set1(ANALYZER_MIN_DB);
+
+    if (an->numFresh > 0)
+    {
+        // Oldest first
+        for (int i = 0; i < ANALYZER_FFT_SIZE; i++)
+        {
+            int j           = i < first ? an->historyPos + i : i - first;
+            an->windowed[i] = an->history[j] * an->window[i];
+        }
+        fft_real_forward(&an->fft, an->windowed, an->re, an->im);
+    }
+    for (int k = 0; k < ANALYZER_NUM_BINS; k += SIMD_WIDTH)
+    {
+        simd_f shown = simd_sub(simd_load(&an->db[k]), fall);
+        if (an->numFresh > 0)
+        {
+            simd_f re    = simd_load(&an->re[k]);
+            simd_f im    = simd_load(&an->im[k]);
+            simd_f power = simd_mul(simd_fmadd(re, re, simd_mul(im, im)), simd_set1(norm));
+            // Power, so half the dB of an amplitude. The offset keeps silence out of log2(0)
+            simd_f db = simd_mul(fast_gain_to_db_lanes(simd_add(power, simd_set1(1e-12f))), simd_set1(0.5f));
+            shown     = simd_max(shown, db);
+        }
+        simd_store(&an->db[k], simd_max(shown, minDb));
+    }
+    an->numFresh = 0;
+}
+
+void analyzer_plot(const Analyzer* an, float* points, int numPoints, float x, float y, float w, float h)
+{
+    const float binHz   = an->sampleRate / ANALYZER_FFT_SIZE;
+    const float octaves = fast_log2(0.5f * an->sampleRate / ANALYZER_MIN_HZ);
+
+    assert(numPoints >= 2 && numPoints <= ANALYZER_MAX_POINTS);
+    for (int p = 0; p < numPoints; p++)
+    {
+        // Bins from this column to the next
+        float from = ANALYZER_MIN_HZ * exp2f(octaves * (float)p / (float)(numPoints - 1)) / binHz;
+        float to   = ANALYZER_MIN_HZ * exp2f(octaves * (float)(p + 1) / (float)(numPoints - 1)) / binHz;
+        int   k0   = (int)from;
+        int   k1   = (int)to < ANALYZER_NUM_BINS - 1 ? (int)to : ANALYZER_NUM_BINS - 1;
+        float db;
+
+        if (k1 <= k0 + 1)
+        {
+            k0 = k0 < ANALYZER_NUM_BINS - 2 ? k0 : ANALYZER_NUM_BINS - 2;
+            db = an->db[k0] + (an->db[k0 + 1] - an->db[k0]) * (from - (float)k0);
+        }
+        else
+        {
+            db = an->db[k0];
+            for (int k = k0 + 1; k < k1; k++)
+                db = an->db[k] > db ? an->db[k] : db;
+        }
+        points[2 * p]     = x + w * (float)p / (float)(numPoints - 1);
+        points[2 * p + 1] = y + h * (db < 0 ? db / ANALYZER_MIN_DB : 0.0f);
+    }
+}
+
+float analyzer_hz_to_x(const Analyzer* an, float hz)
+{
+    return fast_log2(hz / ANALYZER_MIN_HZ) / fast_log2(0.5f * an->sampleRate / ANALYZER_MIN_HZ);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "fft.h"
+
+// Spectrum analyzer for the UI thread, fed with output tapped from the audio thread.
+// Keeps the last ANALYZER_FFT_SIZE samples of a mono mix. Each update Hann windows them, runs a real FFT and
+// converts the bins to dB, where a full scale sine reads 0dB. Like a meter, the display jumps up at once and falls
+// at ANALYZER_FALL_DB_PER_SECOND, so it stays readable at frame rate.
+// Plots use a log frequency axis with one point per pixel column. Where a column covers several bins it shows the
+// loudest; where a bin covers several columns, they interpolate between bins.
+
+#define ANALYZER_FFT_SIZE 4096
+#define ANALYZER_NUM_BINS (ANALYZER_FFT_SIZE / 2 + 1)
+#define ANALYZER_MIN_HZ 20.0f
+#define ANALYZER_MIN_DB -90.0f
+#define ANALYZER_FALL_DB_PER_SECOND 40.0f
+#define ANALYZER_MAX_POINTS 2048
+
+typedef struct Analyzer
+{
+    float       sampleRate;
+    FftRealPlan fft;
+    // Mono history, a ring. 'historyPos' is the oldest sample
+    int                historyPos;
+    int                numFresh; // samples pushed since the last update
+    SIMD_ALIGNED float history[ANALYZER_FFT_SIZE];
+    SIMD_ALIGNED float window[ANALYZER_FFT_SIZE];
+    SIMD_ALIGNED float windowed[ANALYZER_FFT_SIZE];
+    // Bins 0 to ANALYZER_FFT_SIZE / 2, rounded up to whole vectors
+    SIMD_ALIGNED float re[ANALYZER_FFT_SIZE / 2 + SIMD_WIDTH];
+    SIMD_ALIGNED float im[ANALYZER_FFT_SIZE / 2 + SIMD_WIDTH];
+    SIMD_ALIGNED float db[ANALYZER_FFT_SIZE / 2 + SIMD_WIDTH]; // what's displayed
+} Analyzer;
+
+// Returns 0 on success, non zero if out of memory
+int   analyzer_init(Analyzer* an, float sampleRate);
+void  analyzer_free(Analyzer* an);
+// Adds numFrames interleaved frames of numChannels
+void  analyzer_push(Analyzer* an, const float* frames, int numFrames, int numChannels);
+// Analyses the newest samples, if any arrived, & lets the display fall for 'seconds'
+void  analyzer_update(Analyzer* an, float seconds);
+// Writes numPoints x, y pairs spanning the rectangle, ANALYZER_MIN_HZ to Nyquist left to right and
+// ANALYZER_MIN_DB to 0dB bottom to top. numPoints is at most ANALYZER_MAX_POINTS
+void  analyzer_plot(const Analyzer* an, float* points, int numPoints, float x, float y, float w, float h);
+// Where a frequency is along the plot's x axis, 0 to 1. For grid lines
+float analyzer_hz_to_x(const Analyzer* an, float hz);
@@ -0,0 +1,65 @@
+#include "blockfifo.h"
+
+#include <assert.h>
+#include <string.h>
+
+void blockfifo_init(BlockFifo* fifo, int numChannels)
+{
+    assert(numChannels >= 1 && numChannels <= SYNTH_MAX_OUTPUT_CHANNELS);
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->numChannels = numChannels;
+}
+
+void blockfifo_reset(BlockFifo* fifo) { fifo->numBuffered = 0; }
+
+int blockfifo_frames_to_render(const BlockFifo* fifo, int numFrames)
+{
+    int missing = numFrames - fifo->numBuffered;
+    return missing > 0 ? (missing + SYNTH_BLOCK_FRAMES - 1) / SYNTH_BLOCK_FRAMES * SYNTH_BLOCK_FRAMES : 0;
+}
+
+void blockfifo_process(BlockFifo* fifo, Synth* synth, const SynthEvent* events, int numEvents, float* buffer,
+                       int numFrames)
+{
+    const int numChannels = fifo->numChannels;
+    const int numCopied   = numFrames < fifo->numBuffered ? numFrames : fifo->numBuffered;
+    int       blockStart  = 0;
+    int       e           = 0;
+
+    memcpy(buffer, fifo->buffer + (SYNTH_BLOCK_FRAMES - fifo->numBuffered) * numChannels,
+           numCopied * numChannels * sizeof(*buffer));
+    fifo->numBuffered -= numCopied;
+    buffer            += numCopied * numChannels;
+    numFrames         -= numCopied;
+
+    for (; numFrames > 0; blockStart += SYNTH_BLOCK_FRAMES)
+    {
+        const int blockEnd       = blockStart + SYNTH_BLOCK_FRAMES;
+        int       numBlockEvents = 0;
+
+        // Events that don't fit are taken by the next block, which plays them on its first frame
+        for (; e < numEvents && numBlockEvents < BLOCKFIFO_MAX_EVENTS && events[e].frame < blockEnd; e++)
+        {
+            fifo->events[numBlockEvents]       = events[e];
+            fifo->events[numBlockEvents].frame -= blockStart;
+            numBlockEvents++;
+        }
+
+        if (numFrames >= SYNTH_BLOCK_FRAMES)
+        {
+            synth_process(synth, fifo->events, numBlockEvents, buffer, SYNTH_BLOCK_FRAMES, numChannels);
+            buffer    += SYNTH_BLOCK_FRAMES * numChannels;
+            numFrames -= SYNTH_BLOCK_FRAMES;
+        }
+        else
+        {
+            synth_process(synth, fifo->events, numBlockEvents, fifo->buffer, SYNTH_BLOCK_FRAMES, numChannels);
+            memcpy(buffer, fifo->buffer, numFrames * numChannels * sizeof(*buffer));
+            fifo->numBuffered = SYNTH_BLOCK_FRAMES - numFrames;
+            numFrames         = 0;
+        }
+    }
+
+    for (; e < numEvents; e++)
+        synth_handle_event(synth, &events[e]);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "synth.h"
+
+// Runs the synth in fixed blocks of SYNTH_BLOCK_FRAMES, whatever buffer size the audio backend asks for.
+// Whole blocks are rendered straight into the output. When the output ends part way into a block, the rest of that
+// block is kept here and handed out first by the next call, so the engine runs less than a block ahead of the
+// backend. That doesn't add latency to events: their offsets are on the engine's clock, counted from the first frame
+// rendered by this call, so the caller schedules them the same way as without a FIFO.
+
+// Events passed to synth_process() for one block
+#define BLOCKFIFO_MAX_EVENTS 256
+
+typedef struct BlockFifo
+{
+    int numChannels;
+    // Frames at the end of 'buffer' not handed out yet
+    int numBuffered;
+    // One block, interleaved
+    SIMD_ALIGNED float buffer[SYNTH_BLOCK_FRAMES * SYNTH_MAX_OUTPUT_CHANNELS];
+    SynthEvent         events[BLOCKFIFO_MAX_EVENTS];
+} BlockFifo;
+
+void blockfifo_init(BlockFifo* fifo, int numChannels);
+// Drops the buffered frames
+void blockfifo_reset(BlockFifo* fifo);
+// Frames the engine has to render to fill the next numFrames. A multiple of SYNTH_BLOCK_FRAMES
+int blockfifo_frames_to_render(const BlockFifo* fifo, int numFrames);
+// Fills numFrames of the interleaved 'buffer'. Event offsets are in [0, blockfifo_frames_to_render(numFrames)),
+// sorted. Later events are handled after the last frame rendered
+void blockfifo_process(BlockFifo* fifo, Synth* synth, const SynthEvent* events, int numEvents, float* buffer,
+                       int numFrames);
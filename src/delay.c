@@ -0,0 +1,297 @@
+#include "delay.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char* const DELAY_INTERP_NAMES[DELAY_INTERP_COUNT] = {"linear", "cubic", "allpass"};
+const char* const DELAY_TYPE_NAMES[DELAY_TYPE_COUNT]     = {"Echo", "Chorus", "Flanger"};
+
+// Frame offsets within a control period
+static SIMD_ALIGNED const float gPeriodFrames[DELAY_CONTROL_FRAMES] = {0, 1, 2,  3,  4,  5,  6,  7,
+                                                                      8, 9, 10, 11, 12, 13, 14, 15};
+
+int delay_init(Delay* delay, int numChannels, float sampleRate, float maxSeconds)
+{
+    unsigned size = 1;
+
+    memset(delay, 0, sizeof(*delay));
+    numChannels        = numChannels < DELAY_MAX_CHANNELS ? numChannels : DELAY_MAX_CHANNELS;
+    delay->numChannels = numChannels;
+    delay->sampleRate  = sampleRate;
+    delay->rampFrames  = (int)(sampleRate * 0.01f);
+
+    while (size < (unsigned)(maxSeconds * sampleRate) + DELAY_MIN_FRAMES)
+        size *= 2;
+    delay->memory = calloc(1, numChannels * size * sizeof(float) + 32);
+    if (! delay->memory)
+        return 1;
+    for (int c = 0; c < numChannels; c++)
+        delay->buffers[c] = (float*)(((uintptr_t)delay->memory + 31) & ~(uintptr_t)31) + c * size;
+    delay->mask = size - 1;
+
+    delay_set_type(delay, DELAY_CHORUS);
+    delay_reset(delay);
+    return 0;
+}
+
+void delay_free(Delay* delay)
+{
+    free(delay->memory);
+    delay->memory = NULL;
+}
+
+void delay_reset(Delay* delay)
+{
+    for (int c = 0; c < delay->numChannels; c++)
+    {
+        memset(delay->buffers[c], 0, (delay->mask + 1) * sizeof(float));
+        delay->allpassOut[c] = 0;
+    }
+    delay->writePos   = 0;
+    delay->controlPos = 0;
+    delay->lfoPhase   = 0;
+    // The next delay_process() starts at the parameters it's given, without ramps
+    delay->lastTimeMs = NAN;
+}
+
+void delay_set_type(Delay* delay, DelayType type)
+{
+    switch (type)
+    {
+    case DELAY_ECHO:
+        // Long & unmodulated. The allpass keeps repeats bright
+        delay->timeMs      = 350.0f;
+        delay->depthMs     = 0.0f;
+        delay->rateHz      = 0.0f;
+        delay->stereoPhase = 0.0f;
+        delay->feedback    = 0.45f;
+        delay->interp      = DELAY_ALLPASS;
+        break;
+    case DELAY_CHORUS:
+        delay->timeMs      = 14.0f;
+        delay->depthMs     = 4.0f;
+        delay->rateHz      = 0.6f;
+        delay->stereoPhase = 0.25f;
+        delay->feedback    = 0.0f;
+        delay->interp      = DELAY_LINEAR;
+        break;
+    case DELAY_FLANGER:
+        // Short enough that the comb's notches sweep through the audible range
+        delay->timeMs      = 2.5f;
+        delay->depthMs     = 2.0f;
+        delay->rateHz      = 0.2f;
+        delay->stereoPhase = 0.25f;
+        delay->feedback    = 0.6f;
+        delay->interp      = DELAY_CUBIC;
+        break;
+    default:
+        assert(0);
+    }
+}
+
+// Delay of a channel at the end of the current control period, in frames
+static float delay_target(const Delay* delay, int channel)
+{
+    const float maxFrames = (float)(delay->mask + 1 - DELAY_MIN_FRAMES);
+
+    float phase = delay->lfoPhase + (float)channel * delay->stereoPhase;
+    float lfo   = sinf(6.283185307f * (phase - floorf(phase)));
+    float d     = delay->timeRamp.current + delay->depthMs * 0.001f * delay->sampleRate * lfo;
+    d           = d > (float)DELAY_MIN_FRAMES ? d : (float)DELAY_MIN_FRAMES;
+    return d < maxFrames ? d : maxFrames;
+}
+
+static void delay_next_period(Delay* delay)
+{
+    smoothed_skip(&delay->timeRamp, DELAY_CONTROL_FRAMES);
+    delay->lfoPhase += delay->rateHz * DELAY_CONTROL_FRAMES / delay->sampleRate;
+    delay->lfoPhase -= floorf(delay->lfoPhase);
+    for (int c = 0; c < delay->numChannels; c++)
+    {
+        delay->delayFrom[c] = delay->delayTo[c];
+        delay->delayTo[c]   = delay_target(delay, c);
+    }
+}
+
+static void delay_update_params(Delay* delay)
+{
+    const float timeFrames = delay->timeMs * 0.001f * delay->sampleRate;
+    float       feedback   = delay->feedback;
+
+    feedback = feedback < 0.95f ? feedback : 0.95f;
+    feedback = feedback > -0.95f ? feedback : -0.95f;
+    if (isnan(delay->lastTimeMs))
+    {
+        delay->lastTimeMs   = delay->timeMs;
+        delay->lastFeedback = delay->feedback;
+        delay->lastMix      = delay->mix;
+        smoothed_reset(&delay->timeRamp, timeFrames);
+        smoothed_reset(&delay->feedbackRamp, feedback);
+        smoothed_reset(&delay->mixRamp, delay->mix);
+        for (int c = 0; c < delay->numChannels; c++)
+        {
+            delay->delayTo[c]   = delay_target(delay, c);
+            delay->delayFrom[c] = delay->delayTo[c];
+        }
+        return;
+    }
+    if (param_changed(&delay->lastTimeMs, delay->timeMs))
+        smoothed_set_target(&delay->timeRamp, timeFrames, (int)(DELAY_GLIDE_SECONDS * delay->sampleRate));
+    if (param_changed(&delay->lastFeedback, delay->feedback))
+        smoothed_set_target(&delay->feedbackRamp, feedback, delay->rampFrames);
+    if (param_changed(&delay->lastMix, delay->mix))
+        smoothed_set_target(&delay->mixRamp, delay->mix, delay->rampFrames);
+}
+
+// Read positions of numLanes frames behind 'writePos', for a delay of 'start' frames growing by 'step' per frame.
+// Each is split into a whole frame offset, which is negative, & a fraction
+SIMD_INLINE void delay_read_positions(float start, float step, float* offsets, float* fracs, int numLanes)
+{
+    simd_f vstart = simd_set1(start);
+    simd_f vstep  = simd_set1(step);
+
+    for (int i = 0; i < numLanes; i += SIMD_WIDTH)
+    {
+        simd_f t = simd_load(&gPeriodFrames[i]);
+        simd_f r = simd_sub(t, simd_fmadd(vstep, t, vstart));
+        simd_f f = simd_floor(r);
+        simd_store(&offsets[i], f);
+        simd_store(&fracs[i], simd_sub(r, f));
+    }
+}
+
+static void delay_read_linear(const Delay* delay, const float* buf, float start, float step, float* wet, int numLanes)
+{
+    SIMD_ALIGNED float offsets[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float fracs[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float x0[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float x1[DELAY_CONTROL_FRAMES];
+
+    delay_read_positions(start, step, offsets, fracs, numLanes);
+    for (int i = 0; i < numLanes; i++)
+    {
+        unsigned k = delay->writePos + (unsigned)(int)offsets[i];
+        x0[i]      = buf[k & delay->mask];
+        x1[i]      = buf[(k + 1) & delay->mask];
+    }
+    for (int i = 0; i < numLanes; i += SIMD_WIDTH)
+    {
+        simd_f a = simd_load(&x0[i]);
+        simd_f b = simd_load(&x1[i]);
+        simd_store(&wet[i], simd_fmadd(simd_load(&fracs[i]), simd_sub(b, a), a));
+    }
+}
+
+static void delay_read_cubic(const Delay* delay, const float* buf, float start, float step, float* wet, int numLanes)
+{
+    SIMD_ALIGNED float offsets[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float fracs[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float taps[4][DELAY_CONTROL_FRAMES];
+
+    delay_read_positions(start, step, offsets, fracs, numLanes);
+    for (int i = 0; i < numLanes; i++)
+    {
+        unsigned k = delay->writePos + (unsigned)(int)offsets[i];
+        taps[0][i] = buf[(k - 1) & delay->mask];
+        taps[1][i] = buf[k & delay->mask];
+        taps[2][i] = buf[(k + 1) & delay->mask];
+        taps[3][i] = buf[(k + 2) & delay->mask];
+    }
+    // Catmull-Rom through the middle two taps
+    for (int i = 0; i < numLanes; i += SIMD_WIDTH)
+    {
+        simd_f xm1 = simd_load(&taps[0][i]);
+        simd_f x0  = simd_load(&taps[1][i]);
+        simd_f x1  = simd_load(&taps[2][i]);
+        simd_f x2  = simd_load(&taps[3][i]);
+        simd_f f   = simd_load(&fracs[i]);
+        simd_f c1  = simd_mul(simd_set1(0.5f), simd_sub(x1, xm1));
+        simd_f c2  = simd_sub(simd_fmadd(simd_set1(2.0f), x1, xm1),
+                              simd_fmadd(simd_set1(2.5f), x0, simd_mul(simd_set1(0.5f), x2)));
+        simd_f c3  = simd_fmadd(simd_set1(0.5f), simd_sub(x2, xm1), simd_mul(simd_set1(1.5f), simd_sub(x0, x1)));
+        simd_f y   = simd_fmadd(simd_fmadd(simd_fmadd(c3, f, c2), f, c1), f, x0);
+        simd_store(&wet[i], y);
+    }
+}
+
+static void delay_read_allpass(Delay* delay, int channel, float start, float step, float* wet, int numFrames)
+{
+    SIMD_ALIGNED float whole[DELAY_CONTROL_FRAMES];
+    SIMD_ALIGNED float coeffs[DELAY_CONTROL_FRAMES];
+    const float*       buf    = delay->buffers[channel];
+    float              y      = delay->allpassOut[channel];
+    simd_f             vstart = simd_set1(start);
+    simd_f             vstep  = simd_set1(step);
+
+    // A whole delay plus a fraction of 0.5 to 1.5, where the allpass' delay is flattest
+    for (int i = 0; i < numFrames; i += SIMD_WIDTH)
+    {
+        simd_f d    = simd_fmadd(vstep, simd_load(&gPeriodFrames[i]), vstart);
+        simd_f n    = simd_floor(simd_sub(d, simd_set1(0.5f)));
+        simd_f frac = simd_sub(d, n);
+        simd_store(&whole[i], n);
+        simd_store(&coeffs[i], simd_div(simd_sub(simd_set1(1.0f), frac), simd_add(simd_set1(1.0f), frac)));
+    }
+    for (int i = 0; i < numFrames; i++)
+    {
+        unsigned k = delay->writePos + (unsigned)i - (unsigned)(int)whole[i];
+        float    a = coeffs[i];
+        y          = a * (buf[k & delay->mask] - y) + buf[(k - 1) & delay->mask];
+        wet[i]     = y;
+    }
+    delay->allpassOut[channel] = y;
+}
+
+void delay_process(Delay* delay, const float* const* in, float* const* out, int numFrames)
+{
+    delay_update_params(delay);
+
+    // Up to the end of the current control period at a time
+    for (int done = 0; done < numFrames;)
+    {
+        SIMD_ALIGNED float wet[DELAY_CONTROL_FRAMES];
+        float              mix[DELAY_CONTROL_FRAMES];
+        float              feedback[DELAY_CONTROL_FRAMES];
+        int                n = DELAY_CONTROL_FRAMES - delay->controlPos;
+        n                    = n < numFrames - done ? n : numFrames - done;
+        // Reads are whole vectors. Lanes past n are thrown away
+        int numLanes = (n + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+        smoothed_render(&delay->mixRamp, mix, n);
+        smoothed_render(&delay->feedbackRamp, feedback, n);
+        for (int c = 0; c < delay->numChannels; c++)
+        {
+            float*       buf   = delay->buffers[c];
+            const float* x     = in[c] + done;
+            float*       y     = out[c] + done;
+            float        step  = (delay->delayTo[c] - delay->delayFrom[c]) / DELAY_CONTROL_FRAMES;
+            float        start = delay->delayFrom[c] + step * (float)delay->controlPos;
+
+            if (delay->interp == DELAY_LINEAR)
+                delay_read_linear(delay, buf, start, step, wet, numLanes);
+            else if (delay->interp == DELAY_CUBIC)
+                delay_read_cubic(delay, buf, start, step, wet, numLanes);
+            else
+                delay_read_allpass(delay, c, start, step, wet, n);
+
+            for (int i = 0; i < n; i++)
+            {
+                float dry                                = x[i];
+                y[i]                                     = dry + mix[i] * wet[i];
+                buf[(delay->writePos + i) & delay->mask] = dry + feedback[i] * wet[i];
+            }
+        }
+
+        delay->writePos   += n;
+        delay->controlPos += n;
+        done              += n;
+        if (delay->controlPos == DELAY_CONTROL_FRAMES)
+        {
+            delay->controlPos = 0;
+            delay_next_period(delay);
+        }
+    }
+}
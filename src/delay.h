@@ -0,0 +1,81 @@
+#pragma once
+#include "param.h"
+#include "simd.h"
+
+// Modulated delay line: echo, chorus & flanger are presets of the same effect.
+// Each channel has a circular buffer of a power of two frames, so wrapping is a mask. The delay time is worked out
+// every DELAY_CONTROL_FRAMES from the centre time & a sine LFO, then ramped linearly per sample in between.
+// Fractional reads are gathered for a whole control period, then interpolated SIMD_WIDTH frames at a time.
+// Linear & cubic (Catmull-Rom) interpolation are plain SIMD. Allpass interpolation keeps the full bandwidth,
+// which matters for long feedback echoes, but it's recursive, so only its coefficients are worked out in SIMD.
+// Delays are kept at least DELAY_MIN_FRAMES, so a period's reads never reach the frames it's writing.
+// The dry signal passes straight through & the wet signal is added on top, like the reverb.
+
+#define DELAY_MAX_CHANNELS 2
+#define DELAY_CONTROL_FRAMES 16
+#define DELAY_MIN_FRAMES (DELAY_CONTROL_FRAMES + 4)
+#define DELAY_GLIDE_SECONDS 0.25f
+
+typedef enum DelayInterp
+{
+    DELAY_LINEAR,
+    DELAY_CUBIC,
+    DELAY_ALLPASS,
+    DELAY_INTERP_COUNT,
+} DelayInterp;
+
+typedef enum DelayType
+{
+    DELAY_ECHO,
+    DELAY_CHORUS,
+    DELAY_FLANGER,
+    DELAY_TYPE_COUNT,
+} DelayType;
+
+extern const char* const DELAY_INTERP_NAMES[DELAY_INTERP_COUNT];
+extern const char* const DELAY_TYPE_NAMES[DELAY_TYPE_COUNT];
+
+typedef struct Delay
+{
+    int   numChannels;
+    float sampleRate;
+    // Set before each delay_process(), or all but 'mix' at once with delay_set_type()
+    float       timeMs;      // centre delay
+    float       depthMs;     // LFO swing either side of the centre
+    float       rateHz;      // LFO rate
+    float       stereoPhase; // LFO phase of the second channel, 0-1
+    float       feedback;    // -0.95 to 0.95
+    float       mix;         // wet gain
+    DelayInterp interp;
+    // Changes ramp, like the synth's parameters. The centre time glides over DELAY_GLIDE_SECONDS
+    float         lastTimeMs;
+    float         lastFeedback;
+    float         lastMix;
+    SmoothedValue timeRamp; // frames
+    SmoothedValue feedbackRamp;
+    SmoothedValue mixRamp;
+    int           rampFrames;
+    // Delay in frames at the start & end of the current control period, & how far into it we are
+    float delayFrom[DELAY_MAX_CHANNELS];
+    float delayTo[DELAY_MAX_CHANNELS];
+    int   controlPos;
+    float lfoPhase; // 0-1, at the end of the current period
+    // Last output of each channel's allpass
+    float allpassOut[DELAY_MAX_CHANNELS];
+
+    float*   buffers[DELAY_MAX_CHANNELS]; // mask + 1 frames each
+    unsigned mask;
+    unsigned writePos; // frames ever written, wraps with the mask
+    void*    memory;
+} Delay;
+
+// Allocates buffers for delays of up to maxSeconds, centre plus depth.
+// Returns 0 on success, non zero if out of memory
+int  delay_init(Delay* delay, int numChannels, float sampleRate, float maxSeconds);
+void delay_free(Delay* delay);
+void delay_reset(Delay* delay);
+// Sets everything but the mix to the preset
+void delay_set_type(Delay* delay, DelayType type);
+
+// Adds the delay to numChannels planar channels of any length
+void delay_process(Delay* delay, const float* const* in, float* const* out, int numFrames);
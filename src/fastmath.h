@@ -0,0 +1,136 @@
+#pragma once
+#include "simd.h"
+
+// Fast approximations of the libm calls on the audio thread, for parameters modulated per sample.
+// Each function has a scalar version and a _lanes version for SIMD_WIDTH values, evaluating the same polynomials.
+// Max error against libm, measured by bench_fastmath, which fails if any of these are exceeded.
+// The logs are absolute where the result is below 1 and relative above, like float rounding itself:
+//   fast_exp2        x in [-126, 127]            relative 3e-7
+//   fast_log2        x positive & normal         5e-7
+//   fast_tan         x in [0, 0.49 pi]           relative 2e-6
+//   fast_db_to_gain  db in [-120, 40]            relative 1e-6
+//   fast_gain_to_db  gain positive & normal      3e-6 dB
+// Out of range inputs are clamped by fast_exp2, but nothing handles NaN, infinities, or zero & negative logs.
+// The scalar fast_exp2 & fast_db_to_gain are no faster than libm's exp2f, which is table based, so scalar code calls
+// exp2f. They're kept as the reference for the _lanes versions, which are several times faster.
+
+// Polynomial coefficients, lowest order first. Near minimax for the ranges below
+// 2^f, f in [0, 1)
+static const float gFastExp2Poly[6] = {9.999999252e-01f, 6.931530709e-01f, 2.401536272e-01f,
+                                       5.582630179e-02f, 8.989348589e-03f, 1.877576664e-03f};
+// log2(1 + t) / t, t in [0, 1)
+static const float gFastLog2Poly[7] = {1.442667826e+00f,  -7.205854031e-01f, 4.735529390e-01f, -3.259004269e-01f,
+                                       1.942917785e-01f, -7.955568561e-02f, 1.552927785e-02f};
+// (tan(y) - y) / y^3 as a polynomial in y^2, y in [0, pi / 4]
+static const float gFastTanPoly[5] = {3.333515853e-01f, 1.329234120e-01f, 5.690452803e-02f, 1.298597834e-02f,
+                                      2.011911641e-02f};
+
+#define FAST_LOG2_10_OVER_20 0.16609640474436813f // dB to log2
+#define FAST_20_LOG10_2 6.020599913279624f        // log2 to dB
+#define FAST_PI_2 1.5707963267948966f
+#define FAST_PI_4 0.7853981633974483f
+
+static inline float fast_exp2(float x)
+{
+    union
+    {
+        float        f;
+        unsigned int u;
+    } p;
+    float n, f;
+
+    x   = x < -126.0f ? -126.0f : x > 127.0f ? 127.0f : x;
+    n   = (float)(int)x;
+    n   = n > x ? n - 1.0f : n;
+    f   = x - n;
+    p.f = gFastExp2Poly[5];
+    for (int i = 4; i >= 0; i--)
+        p.f = p.f * f + gFastExp2Poly[i];
+    p.u += (unsigned int)(int)n << 23;
+    return p.f;
+}
+
+static inline float fast_log2(float x)
+{
+    union
+    {
+        float        f;
+        unsigned int u;
+    } m = {x};
+    float e = (float)((int)(m.u >> 23) - 127);
+    float t, p;
+
+    m.u = (m.u & 0x007fffff) | 0x3f800000;
+    t   = m.f - 1.0f;
+    p   = gFastLog2Poly[6];
+    for (int i = 5; i >= 0; i--)
+        p = p * t + gFastLog2Poly[i];
+    return e + t * p;
+}
+
+// x in [0, pi / 2)
+static inline float fast_tan(float x)
+{
+    // tan(x) = 1 / tan(pi / 2 - x) keeps the polynomial on [0, pi / 4]
+    int   big = x >= FAST_PI_4;
+    float y   = big ? FAST_PI_2 - x : x;
+    float y2  = y * y;
+    float r   = gFastTanPoly[4];
+    float t;
+
+    for (int i = 3; i >= 0; i--)
+        r = r * y2 + gFastTanPoly[i];
+    t = y + y * y2 * r;
+    return big ? 1.0f / t : t;
+}
+
+static inline float fast_db_to_gain(float db) { return fast_exp2(db * FAST_LOG2_10_OVER_20); }
+static inline float fast_gain_to_db(float gain) { return fast_log2(gain) * FAST_20_LOG10_2; }
+
+SIMD_INLINE simd_f fast_exp2_lanes(simd_f x)
+{
+    simd_f n, f, p;
+
+    x = simd_min(simd_max(x, simd_set1(-126.0f)), simd_set1(127.0f));
+    n = simd_floor(x);
+    f = simd_sub(x, n);
+    p = simd_set1(gFastExp2Poly[5]);
+    for (int i = 4; i >= 0; i--)
+        p = simd_fmadd(p, f, simd_set1(gFastExp2Poly[i]));
+    return simd_ldexp(p, n);
+}
+
+SIMD_INLINE simd_f fast_log2_lanes(simd_f x)
+{
+    simd_f e;
+    simd_f t = simd_sub(simd_mantissa(x, &e), simd_set1(1.0f));
+    simd_f p = simd_set1(gFastLog2Poly[6]);
+
+    for (int i = 5; i >= 0; i--)
+        p = simd_fmadd(p, t, simd_set1(gFastLog2Poly[i]));
+    return simd_fmadd(t, p, e);
+}
+
+SIMD_INLINE simd_f fast_tan_lanes(simd_f x)
+{
+    simd_m big = simd_cmpge(x, simd_set1(FAST_PI_4));
+    simd_f y   = simd_select(big, simd_sub(simd_set1(FAST_PI_2), x), x);
+    simd_f y2  = simd_mul(y, y);
+    simd_f r   = simd_set1(gFastTanPoly[4]);
+    simd_f t;
+
+    for (int i = 3; i >= 0; i--)
+        r = simd_fmadd(r, y2, simd_set1(gFastTanPoly[i]));
+    t = simd_fmadd(simd_mul(y, y2), r, y);
+    return simd_select(big, simd_div(simd_set1(1.0f), t), t);
+}
+
+SIMD_INLINE simd_f fast_db_to_gain_lanes(simd_f db)
+{
+    return fast_exp2_lanes(simd_mul(db, simd_set1(FAST_LOG2_10_OVER_20)));
+}
+
+SIMD_INLINE simd_f fast_gain_to_db_lanes(simd_f gain)
+{
+    return simd_mul(fast_log2_lanes(gain), simd_set1(FAST_20_LOG10_2));
+}
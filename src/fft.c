@@ -0,0 +1,515 @@
+#include "fft.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Carves a plan's arrays out of one allocation. With no base, only counts the bytes needed
+typedef struct FftArena
+{
+    uint8_t* base;
+    size_t   used;
+} FftArena;
+
+static float* fft_take_floats(FftArena* arena, int count)
+{
+    float* p    = arena->base ? (float*)(arena->base + arena->used) : NULL;
+    arena->used += (count * sizeof(float) + 31) & ~(size_t)31;
+    return p;
+}
+
+static int fft_arena_alloc(FftArena* arena, void** memory)
+{
+    *memory = calloc(1, arena->used + 32);
+    if (! *memory)
+        return 1;
+    arena->base = (uint8_t*)(((uintptr_t)*memory + 31) & ~(uintptr_t)31);
+    arena->used = 0;
+    return 0;
+}
+
+static void fft_layout(FftPlan* plan, FftArena* arena)
+{
+    int n = plan->size;
+    int s = 1;
+
+    plan->numStages = 0;
+    // Radix 4 while it divides, leaving radix 2 for the last stage, whose twiddles are all 1
+    while (n > 1)
+    {
+        FftStage* stage = &plan->stages[plan->numStages++];
+        stage->radix    = n % 4 == 0 ? 4 : 2;
+        stage->stride   = s;
+        stage->count    = n / stage->radix;
+        stage->twRe     = fft_take_floats(arena, (stage->radix - 1) * stage->count);
+        stage->twIm     = fft_take_floats(arena, (stage->radix - 1) * stage->count);
+        n               /= stage->radix;
+        s               *= stage->radix;
+    }
+    plan->workRe = fft_take_floats(arena, plan->size);
+    plan->workIm = fft_take_floats(arena, plan->size);
+}
+
+static void fft_fill_twiddles(FftPlan* plan)
+{
+    static const double pi = 3.14159265358979323846;
+
+    for (int i = 0; i < plan->numStages; i++)
+    {
+        const FftStage* stage = &plan->stages[i];
+        const int       n     = stage->radix * stage->count;
+        for (int j = 1; j < stage->radix; j++)
+        {
+            for (int p = 0; p < stage->count; p++)
+            {
+                double angle = -2.0 * pi * j * p / n;
+                ((float*)stage->twRe)[(j - 1) * stage->count + p] = (float)cos(angle);
+                ((float*)stage->twIm)[(j - 1) * stage->count + p] = (float)sin(angle);
+            }
+        }
+    }
+}
+
+int fft_plan_init(FftPlan* plan, int size)
+{
+    FftArena arena = {0};
+
+    assert(size >= FFT_MIN_SIZE && size <= FFT_MAX_SIZE && (size & (size - 1)) == 0);
+    memset(plan, 0, sizeof(*plan));
+    plan->size = size;
+    fft_layout(plan, &arena);
+    if (fft_arena_alloc(&arena, &plan->memory))
+        return 1;
+    fft_layout(plan, &arena);
+    fft_fill_twiddles(plan);
+    return 0;
+}
+
+void fft_plan_free(FftPlan* plan)
+{
+    free(plan->memory);
+    plan->memory = NULL;
+}
+
+// SIMD_WIDTH complex numbers
+typedef struct FftLanes
+{
+    simd_f re, im;
+} FftLanes;
+
+SIMD_INLINE FftLanes fft_load(const float* re, const float* im, int i)
+{
+    FftLanes z = {simd_load(re + i), simd_load(im + i)};
+    return z;
+}
+
+SIMD_INLINE void fft_store(float* re, float* im, int i, FftLanes z)
+{
+    simd_store(re + i, z.re);
+    simd_store(im + i, z.im);
+}
+
+SIMD_INLINE FftLanes fft_add(FftLanes a, FftLanes b)
+{
+    FftLanes z = {simd_add(a.re, b.re), simd_add(a.im, b.im)};
+    return z;
+}
+
+SIMD_INLINE FftLanes fft_sub(FftLanes a, FftLanes b)
+{
+    FftLanes z = {simd_sub(a.re, b.re), simd_sub(a.im, b.im)};
+    return z;
+}
+
+SIMD_INLINE FftLanes fft_mul(FftLanes a, FftLanes b)
+{
+    FftLanes z = {simd_sub(simd_mul(a.re, b.re), simd_mul(a.im, b.im)), simd_fmadd(a.re, b.im, simd_mul(a.im, b.re))};
+    return z;
+}
+
+SIMD_INLINE FftLanes fft_mul_neg_i(FftLanes a)
+{
+    FftLanes z = {a.im, simd_sub(simd_set1(0.0f), a.re)};
+    return z;
+}
+
+// Decimation in frequency: y[k] = twiddle^k * sum over j of x[j] * (-i)^(j * k)
+SIMD_INLINE void fft_radix4(FftLanes* y, FftLanes a, FftLanes b, FftLanes c, FftLanes d, const FftLanes* w)
+{
+    FftLanes apc  = fft_add(a, c);
+    FftLanes amc  = fft_sub(a, c);
+    FftLanes bpd  = fft_add(b, d);
+    FftLanes jbmd = fft_mul_neg_i(fft_sub(b, d));
+
+    y[0] = fft_add(apc, bpd);
+    y[1] = fft_mul(fft_add(amc, jbmd), w[0]);
+    y[2] = fft_mul(fft_sub(apc, bpd), w[1]);
+    y[3] = fft_mul(fft_sub(amc, jbmd), w[2]);
+}
+
+// Butterfly p reads points p + j * count and writes 4 * p + k, each a run of 'stride' consecutive values.
+// With stride a multiple of SIMD_WIDTH, the runs are vectors and each butterfly shares one twiddle
+static void fft_radix4_strided(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    const int s = stage->stride;
+    const int m = stage->count;
+
+    for (int p = 0; p < m; p++)
+    {
+        FftLanes w[3];
+        for (int j = 0; j < 3; j++)
+        {
+            w[j].re = simd_set1(stage->twRe[j * m + p]);
+            w[j].im = simd_set1(stage->twIm[j * m + p]);
+        }
+        for (int q = p * s; q < (p + 1) * s; q += SIMD_WIDTH)
+        {
+            FftLanes y[4];
+            int      out = q + 3 * p * s;
+            fft_radix4(y, fft_load(xr, xi, q), fft_load(xr, xi, q + s * m), fft_load(xr, xi, q + 2 * s * m),
+                       fft_load(xr, xi, q + 3 * s * m), w);
+            for (int k = 0; k < 4; k++)
+                fft_store(yr, yi, out + k * s, y[k]);
+        }
+    }
+}
+
+// The last stage of odd powers of two. One butterfly, so no twiddles
+static void fft_radix2_strided(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    const int s = stage->stride;
+
+    assert(stage->count == 1);
+    for (int q = 0; q < s; q += SIMD_WIDTH)
+    {
+        FftLanes a = fft_load(xr, xi, q);
+        FftLanes b = fft_load(xr, xi, q + s);
+        fft_store(yr, yi, q, fft_add(a, b));
+        fft_store(yr, yi, q + s, fft_sub(a, b));
+    }
+}
+
+// Stride 1: lanes are consecutive butterflies. Lane l of y[k] belongs at 4 * (p + l) + k, so the outputs are
+// interleaved like interleave_4() does
+static void fft_radix4_first(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    const int m = stage->count;
+
+    for (int p = 0; p < m; p += SIMD_WIDTH)
+    {
+        FftLanes w[3], y[4];
+        for (int j = 0; j < 3; j++)
+            w[j] = fft_load(stage->twRe, stage->twIm, j * m + p);
+        fft_radix4(y, fft_load(xr, xi, p), fft_load(xr, xi, p + m), fft_load(xr, xi, p + 2 * m),
+                   fft_load(xr, xi, p + 3 * m), w);
+
+        simd_f a[4], b[4];
+        simd_zip(y[0].re, y[2].re, &a[0], &a[1]);
+        simd_zip(y[1].re, y[3].re, &a[2], &a[3]);
+        simd_zip(a[0], a[2], &b[0], &b[1]);
+        simd_zip(a[1], a[3], &b[2], &b[3]);
+        for (int k = 0; k < 4; k++)
+            simd_store(yr + 4 * p + k * SIMD_WIDTH, b[k]);
+        simd_zip(y[0].im, y[2].im, &a[0], &a[1]);
+        simd_zip(y[1].im, y[3].im, &a[2], &a[3]);
+        simd_zip(a[0], a[2], &b[0], &b[1]);
+        simd_zip(a[1], a[3], &b[2], &b[3]);
+        for (int k = 0; k < 4; k++)
+            simd_store(yi + 4 * p + k * SIMD_WIDTH, b[k]);
+    }
+}
+
+// Stride SIMD_WIDTH / 2 (4 with AVX2): each vector holds half a run from two consecutive butterflies, and the
+// outputs are put back together a half at a time
+static void fft_radix4_halves(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    const int s = stage->stride;
+    const int m = stage->count;
+
+    for (int p = 0; p < m; p += 2)
+    {
+        FftLanes w[3], y[4];
+        int      q = p * s;
+        for (int j = 0; j < 3; j++)
+        {
+            simd_f unused;
+            simd_zip_halves(simd_set1(stage->twRe[j * m + p]), simd_set1(stage->twRe[j * m + p + 1]), &w[j].re,
+                            &unused);
+            simd_zip_halves(simd_set1(stage->twIm[j * m + p]), simd_set1(stage->twIm[j * m + p + 1]), &w[j].im,
+                            &unused);
+        }
+        fft_radix4(y, fft_load(xr, xi, q), fft_load(xr, xi, q + s * m), fft_load(xr, xi, q + 2 * s * m),
+                   fft_load(xr, xi, q + 3 * s * m), w);
+
+        FftLanes z[4];
+        simd_zip_halves(y[0].re, y[1].re, &z[0].re, &z[2].re);
+        simd_zip_halves(y[0].im, y[1].im, &z[0].im, &z[2].im);
+        simd_zip_halves(y[2].re, y[3].re, &z[1].re, &z[3].re);
+        simd_zip_halves(y[2].im, y[3].im, &z[1].im, &z[3].im);
+        for (int k = 0; k < 4; k++)
+            fft_store(yr, yi, 4 * q + k * SIMD_WIDTH, z[k]);
+    }
+}
+
+// Any stage, one butterfly at a time
+static void fft_stage_scalar(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    const int s = stage->stride;
+    const int m = stage->count;
+    const int r = stage->radix;
+
+    for (int p = 0; p < m; p++)
+    {
+        for (int q = 0; q < s; q++)
+        {
+            float ar[4], ai[4];
+            for (int j = 0; j < r; j++)
+            {
+                ar[j] = xr[q + s * (p + j * m)];
+                ai[j] = xi[q + s * (p + j * m)];
+            }
+            float br[4], bi[4];
+            if (r == 4)
+            {
+                // As fft_radix4()
+                float apcr = ar[0] + ar[2], apci = ai[0] + ai[2];
+                float amcr = ar[0] - ar[2], amci = ai[0] - ai[2];
+                float bpdr = ar[1] + ar[3], bpdi = ai[1] + ai[3];
+                float jbmr = ai[1] - ai[3], jbmi = ar[3] - ar[1];
+                br[0] = apcr + bpdr, bi[0] = apci + bpdi;
+                br[1] = amcr + jbmr, bi[1] = amci + jbmi;
+                br[2] = apcr - bpdr, bi[2] = apci - bpdi;
+                br[3] = amcr - jbmr, bi[3] = amci - jbmi;
+            }
+            else
+            {
+                br[0] = ar[0] + ar[1], bi[0] = ai[0] + ai[1];
+                br[1] = ar[0] - ar[1], bi[1] = ai[0] - ai[1];
+            }
+            yr[q + s * r * p] = br[0];
+            yi[q + s * r * p] = bi[0];
+            for (int k = 1; k < r; k++)
+            {
+                float wr = stage->twRe[(k - 1) * m + p];
+                float wi = stage->twIm[(k - 1) * m + p];
+                yr[q + s * (r * p + k)] = br[k] * wr - bi[k] * wi;
+                yi[q + s * (r * p + k)] = br[k] * wi + bi[k] * wr;
+            }
+        }
+    }
+}
+
+static void fft_run_stage(const FftStage* stage, const float* xr, const float* xi, float* yr, float* yi)
+{
+    if (stage->stride % SIMD_WIDTH == 0)
+    {
+        if (stage->radix == 4)
+            fft_radix4_strided(stage, xr, xi, yr, yi);
+        else
+            fft_radix2_strided(stage, xr, xi, yr, yi);
+    }
+    else if (stage->stride == 1 && stage->radix == 4 && stage->count % SIMD_WIDTH == 0)
+    {
+        fft_radix4_first(stage, xr, xi, yr, yi);
+    }
+    else if (2 * stage->stride == SIMD_WIDTH && stage->radix == 4 && stage->count % 2 == 0)
+    {
+        fft_radix4_halves(stage, xr, xi, yr, yi);
+    }
+    else
+    {
+        fft_stage_scalar(stage, xr, xi, yr, yi);
+    }
+}
+
+void fft_forward(FftPlan* plan, float* re, float* im)
+{
+    float* xr = re;
+    float* xi = im;
+    float* yr = plan->workRe;
+    float* yi = plan->workIm;
+
+    // Each stage goes from one buffer to the other
+    for (int i = 0; i < plan->numStages; i++)
+    {
+        float* t;
+        fft_run_stage(&plan->stages[i], xr, xi, yr, yi);
+        t = xr, xr = yr, yr = t;
+        t = xi, xi = yi, yi = t;
+    }
+    if (xr != re)
+    {
+        memcpy(re, xr, plan->size * sizeof(float));
+        memcpy(im, xi, plan->size * sizeof(float));
+    }
+}
+
+// Swapping the real & imaginary parts conjugates the input & the output, which turns the forward transform around
+void fft_inverse(FftPlan* plan, float* re, float* im) { fft_forward(plan, im, re); }
+
+static void fft_real_layout(FftRealPlan* plan, FftArena* arena)
+{
+    fft_layout(&plan->half, arena);
+    plan->twRe   = fft_take_floats(arena, plan->size / 4 + 1);
+    plan->twIm   = fft_take_floats(arena, plan->size / 4 + 1);
+    plan->workRe = fft_take_floats(arena, plan->size / 2);
+    plan->workIm = fft_take_floats(arena, plan->size / 2);
+}
+
+int fft_real_plan_init(FftRealPlan* plan, int size)
+{
+    static const double pi = 3.14159265358979323846;
+
+    FftArena arena = {0};
+
+    assert(size >= FFT_MIN_SIZE && size <= FFT_MAX_SIZE && (size & (size - 1)) == 0);
+    memset(plan, 0, sizeof(*plan));
+    plan->size      = size;
+    plan->half.size = size / 2;
+    fft_real_layout(plan, &arena);
+    if (fft_arena_alloc(&arena, &plan->memory))
+        return 1;
+    fft_real_layout(plan, &arena);
+    fft_fill_twiddles(&plan->half);
+    for (int k = 0; k <= size / 4; k++)
+    {
+        plan->twRe[k] = (float)cos(-2.0 * pi * k / size);
+        plan->twIm[k] = (float)sin(-2.0 * pi * k / size);
+    }
+    return 0;
+}
+
+void fft_real_plan_free(FftRealPlan* plan)
+{
+    // The half size plan lives in the same allocation
+    free(plan->memory);
+    plan->memory = NULL;
+}
+
+// The complex FFT Z of z[n] = x[2n] + i x[2n + 1] holds the spectra of the even & odd samples:
+//   E[k] = (Z[k] + conj(Z[M - k])) / 2, O[k] = (Z[k] - conj(Z[M - k])) / 2i
+// and X[k] = E[k] + w^k O[k], X[M - k] = conj(E[k] - w^k O[k]), with M = N / 2 & w = exp(-2 pi i / N).
+// Bins k & M - k only depend on each other, so the pass works in place
+static void fft_real_split_bin(float* re, float* im, int k, int M, float wr, float wi)
+{
+    const int j   = M - k;
+    float     er  = 0.5f * (re[k] + re[j]);
+    float     ei  = 0.5f * (im[k] - im[j]);
+    float     odr = 0.5f * (im[k] + im[j]);
+    float     odi = 0.5f * (re[j] - re[k]);
+    float     tr  = odr * wr - odi * wi;
+    float     ti  = odr * wi + odi * wr;
+
+    re[k] = er + tr;
+    im[k] = ei + ti;
+    re[j] = er - tr;
+    im[j] = ti - ei;
+}
+
+// Inverse of the above, doubled: Z[k] = E[k] + i O[k], with E[k] = X[k] + conj(X[M - k]) and
+// O[k] = (X[k] - conj(X[M - k])) conj(w^k)
+static void fft_real_merge_bin(const float* re, const float* im, float* zr, float* zi, int k, int M, float wr,
+                               float wi)
+{
+    const int j   = M - k;
+    float     er  = re[k] + re[j];
+    float     ei  = im[k] - im[j];
+    float     dr  = re[k] - re[j];
+    float     di  = im[k] + im[j];
+    float     odr = dr * wr + di * wi;
+    float     odi = di * wr - dr * wi;
+
+    zr[k] = er - odi;
+    zi[k] = ei + odr;
+    zr[j] = er + odi;
+    zi[j] = odr - ei;
+}
+
+void fft_real_forward(FftRealPlan* plan, const float* in, float* re, float* im)
+{
+    const int M = plan->size / 2;
+    int       k = 1;
+
+    // Even samples to the real part, odd samples to the imaginary part
+    for (int i = 0; i < M; i += SIMD_WIDTH)
+    {
+        simd_f even, odd;
+        simd_unzip(simd_load(in + 2 * i), simd_load(in + 2 * i + SIMD_WIDTH), &even, &odd);
+        simd_store(re + i, even);
+        simd_store(im + i, odd);
+    }
+    fft_forward(&plan->half, re, im);
+
+    // Bin M is bin 0 of the periodic half size spectrum
+    re[M] = re[0] - im[0];
+    re[0] = re[0] + im[0];
+    im[0] = im[M] = 0;
+    // Bins k & M - k, a vector of each. M - k runs backwards, so it's reversed on the way in & out
+    for (; k + SIMD_WIDTH <= M / 2; k += SIMD_WIDTH)
+    {
+        const int j    = M - k - SIMD_WIDTH + 1;
+        simd_f    half = simd_set1(0.5f);
+        simd_f    ar   = simd_loadu(re + k);
+        simd_f    ai   = simd_loadu(im + k);
+        simd_f    br   = simd_reverse(simd_loadu(re + j));
+        simd_f    bi   = simd_reverse(simd_loadu(im + j));
+        simd_f    wr   = simd_loadu(plan->twRe + k);
+        simd_f    wi   = simd_loadu(plan->twIm + k);
+        simd_f    er   = simd_mul(half, simd_add(ar, br));
+        simd_f    ei   = simd_mul(half, simd_sub(ai, bi));
+        simd_f    odr  = simd_mul(half, simd_add(ai, bi));
+        simd_f    odi  = simd_mul(half, simd_sub(br, ar));
+        simd_f    tr   = simd_sub(simd_mul(odr, wr), simd_mul(odi, wi));
+        simd_f    ti   = simd_fmadd(odr, wi, simd_mul(odi, wr));
+        simd_storeu(re + k, simd_add(er, tr));
+        simd_storeu(im + k, simd_add(ei, ti));
+        simd_storeu(re + j, simd_reverse(simd_sub(er, tr)));
+        simd_storeu(im + j, simd_reverse(simd_sub(ti, ei)));
+    }
+    for (; k <= M / 2; k++)
+        fft_real_split_bin(re, im, k, M, plan->twRe[k], plan->twIm[k]);
+}
+
+void fft_real_inverse(FftRealPlan* plan, const float* re, const float* im, float* out)
+{
+    const int M  = plan->size / 2;
+    float*    zr = plan->workRe;
+    float*    zi = plan->workIm;
+    int       k  = 1;
+
+    zr[0] = re[0] + re[M];
+    zi[0] = re[0] - re[M];
+    for (; k + SIMD_WIDTH <= M / 2; k += SIMD_WIDTH)
+    {
+        const int j   = M - k - SIMD_WIDTH + 1;
+        simd_f    ar  = simd_loadu(re + k);
+        simd_f    ai  = simd_loadu(im + k);
+        simd_f    br  = simd_reverse(simd_loadu(re + j));
+        simd_f    bi  = simd_reverse(simd_loadu(im + j));
+        simd_f    wr  = simd_loadu(plan->twRe + k);
+        simd_f    wi  = simd_loadu(plan->twIm + k);
+        simd_f    er  = simd_add(ar, br);
+        simd_f    ei  = simd_sub(ai, bi);
+        simd_f    dr  = simd_sub(ar, br);
+        simd_f    di  = simd_add(ai, bi);
+        simd_f    odr = simd_fmadd(dr, wr, simd_mul(di, wi));
+        simd_f    odi = simd_sub(simd_mul(di, wr), simd_mul(dr, wi));
+        simd_storeu(zr + k, simd_sub(er, odi));
+        simd_storeu(zi + k, simd_add(ei, odr));
+        simd_storeu(zr + j, simd_reverse(simd_add(er, odi)));
+        simd_storeu(zi + j, simd_reverse(simd_sub(odr, ei)));
+    }
+    for (; k <= M / 2; k++)
+        fft_real_merge_bin(re, im, zr, zi, k, M, plan->twRe[k], plan->twIm[k]);
+
+    fft_inverse(&plan->half, zr, zi);
+    for (int i = 0; i < M; i += SIMD_WIDTH)
+    {
+        simd_f lo, hi;
+        simd_zip(simd_load(zr + i), simd_load(zi + i), &lo, &hi);
+        simd_store(out + 2 * i, lo);
+        simd_store(out + 2 * i + SIMD_WIDTH, hi);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "simd.h"
+
+// Power of two FFTs, complex & real, from FFT_MIN_SIZE to FFT_MAX_SIZE points.
+// Complex data is split: real & imaginary parts in separate arrays. All arrays must be SIMD aligned.
+// Transforms are Stockham autosort, radix 4 with one radix 2 stage for odd powers of two, so results come out in
+// natural order with no bit reversal pass. Stages whose stride is a multiple of SIMD_WIDTH run SIMD_WIDTH butterflies
+// per instruction. The first stage, of stride 1, vectorises across butterflies instead and puts its outputs in
+// place with zips. With AVX2 the second stage, of stride 4, puts two butterflies in each vector. Stages too small
+// for either fall back to plain C.
+// A real FFT of N points is a complex FFT of N / 2 points plus one pass to separate the spectrum.
+// Plans hold the twiddles & work buffers, allocated by the init functions. Running a plan doesn't allocate or lock,
+// so it can run on the audio thread, but one plan can only run one transform at a time.
+// Forward transforms use exp(-2 pi i k n / N). Inverses aren't scaled: forward then inverse multiplies by N.
+
+#define FFT_MIN_SIZE 32
+#define FFT_MAX_SIZE 65536
+#define FFT_MAX_STAGES 16
+
+typedef struct FftStage
+{
+    int          radix;
+    int          stride; // consecutive points each butterfly input covers
+    int          count;  // butterflies per stride
+    const float* twRe;   // (radix - 1) * count twiddles, radix - 1 runs of count
+    const float* twIm;
+} FftStage;
+
+typedef struct FftPlan
+{
+    int      size;
+    int      numStages;
+    FftStage stages[FFT_MAX_STAGES];
+    float*   workRe; // size
+    float*   workIm;
+    void*    memory;
+} FftPlan;
+
+typedef struct FftRealPlan
+{
+    int     size;
+    FftPlan half; // complex, size / 2
+    float*  twRe; // size / 4 + 1, exp(-2 pi i k / size)
+    float*  twIm;
+    float*  workRe; // size / 2
+    float*  workIm;
+    void*   memory;
+} FftRealPlan;
+
+// Returns 0 on success, non zero if out of memory
+int  fft_plan_init(FftPlan* plan, int size);
+void fft_plan_free(FftPlan* plan);
+// In place, size points
+void fft_forward(FftPlan* plan, float* re, float* im);
+void fft_inverse(FftPlan* plan, float* re, float* im);
+
+// Returns 0 on success, non zero if out of memory
+int  fft_real_plan_init(FftRealPlan* plan, int size);
+void fft_real_plan_free(FftRealPlan* plan);
+// size samples to bins 0 to size / 2, so 're' & 'im' hold size / 2 + 1 values
+void fft_real_forward(FftRealPlan* plan, const float* in, float* re, float* im);
+// Bins 0 to size / 2 to size samples. The imaginary parts of bins 0 & size / 2 are ignored
+void fft_real_inverse(FftRealPlan* plan, const float* re, const float* im, float* out);
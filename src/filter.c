@@ -0,0 +1,262 @@
+#include "filter.h"
+#include "fastmath.h"
+
+#include <assert.h>
+#include <string.h>
+
+void svf_bank_init(SVFBank* bank, int numLanes)
+{
+    assert(numLanes > 0 && numLanes <= SVF_MAX_LANES);
+    assert(numLanes % SIMD_WIDTH == 0);
+    memset(bank, 0, sizeof(*bank));
+    bank->numLanes = numLanes;
+}
+
+void svf_bank_reset(SVFBank* bank)
+{
+    memset(bank->ic1eq, 0, sizeof(bank->ic1eq));
+    memset(bank->ic2eq, 0, sizeof(bank->ic2eq));
+}
+
+void svf_bank_reset_lane(SVFBank* bank, int lane)
+{
+    bank->ic1eq[lane] = 0;
+    bank->ic2eq[lane] = 0;
+}
+
+void svf_bank_copy_lane(SVFBank* bank, int dst, int src)
+{
+    bank->a1[dst]      = bank->a1[src];
+    bank->a2[dst]      = bank->a2[src];
+    bank->a3[dst]      = bank->a3[src];
+    bank->k[dst]       = bank->k[src];
+    bank->target1[dst] = bank->target1[src];
+    bank->target2[dst] = bank->target2[src];
+    bank->target3[dst] = bank->target3[src];
+    bank->ic1eq[dst]   = bank->ic1eq[src];
+    bank->ic2eq[dst]   = bank->ic2eq[src];
+}
+
+SVFCoeffs svf_coeffs(float cutoffHz, float Q, float sampleRate)
+{
+    static const float pi = 3.141592653589793f;
+
+    SVFCoeffs c;
+    // tan() blows up at Nyquist
+    float maxHz = sampleRate * 0.49f;
+    float Hz    = cutoffHz < maxHz ? cutoffHz : maxHz;
+    float g     = fast_tan(pi * Hz / sampleRate);
+
+    c.k  = 1.0f / Q;
+    c.a1 = 1.0f / (1.0f + g * (g + c.k));
+    c.a2 = g * c.a1;
+    c.a3 = g * c.a2;
+    return c;
+}
+
+void svf_bank_glide_lane(SVFBank* bank, int lane, SVFCoeffs c)
+{
+    bank->target1[lane] = c.a1;
+    bank->target2[lane] = c.a2;
+    bank->target3[lane] = c.a3;
+    bank->k[lane]       = c.k;
+}
+
+void svf_bank_set_lane(SVFBank* bank, int lane, SVFCoeffs c)
+{
+    svf_bank_glide_lane(bank, lane, c);
+    bank->a1[lane] = c.a1;
+    bank->a2[lane] = c.a2;
+    bank->a3[lane] = c.a3;
+}
+
+void svf_bank_glide_all(SVFBank* bank, SVFCoeffs c)
+{
+    for (int i = 0; i < bank->numLanes; i++)
+        svf_bank_glide_lane(bank, i, c);
+}
+
+void svf_bank_set_all(SVFBank* bank, SVFCoeffs c)
+{
+    for (int i = 0; i < bank->numLanes; i++)
+        svf_bank_set_lane(bank, i, c);
+}
+
+void svf_bank_glide_cutoffs(SVFBank* bank, int lane, simd_f cutoffHz, float Q, float sampleRate)
+{
+    static const float pi = 3.141592653589793f;
+
+    simd_f one = simd_set1(1.0f);
+    simd_f k   = simd_set1(1.0f / Q);
+    simd_f Hz  = simd_min(cutoffHz, simd_set1(sampleRate * 0.49f));
+    simd_f g   = fast_tan_lanes(simd_mul(Hz, simd_set1(pi / sampleRate)));
+    simd_f a1  = simd_div(one, simd_fmadd(g, simd_add(g, k), one));
+    simd_f a2  = simd_mul(g, a1);
+
+    simd_store(&bank->target1[lane], a1);
+    simd_store(&bank->target2[lane], a2);
+    simd_store(&bank->target3[lane], simd_mul(g, a2));
+    simd_store(&bank->k[lane], k);
+}
+
+typedef struct SVFLanes
+{
+    simd_f a1, a2, a3;
+    // Per sample glide
+    simd_f d1, d2, d3;
+    simd_f ic1eq, ic2eq;
+    // Output = m0 * input + m1 * band + m2 * low
+    simd_f m0, m1, m2;
+} SVFLanes;
+
+SIMD_INLINE SVFLanes svf_lanes_load(const SVFBank* bank, SVFMode mode, int lane, int numFrames)
+{
+    SVFLanes l;
+    simd_f   zero   = simd_set1(0.0f);
+    simd_f   one    = simd_set1(1.0f);
+    simd_f   invLen = simd_set1(numFrames > 0 ? 1.0f / (float)numFrames : 0.0f);
+
+    l.a1    = simd_load(&bank->a1[lane]);
+    l.a2    = simd_load(&bank->a2[lane]);
+    l.a3    = simd_load(&bank->a3[lane]);
+    l.d1    = simd_mul(simd_sub(simd_load(&bank->target1[lane]), l.a1), invLen);
+    l.d2    = simd_mul(simd_sub(simd_load(&bank->target2[lane]), l.a2), invLen);
+    l.d3    = simd_mul(simd_sub(simd_load(&bank->target3[lane]), l.a3), invLen);
+    l.ic1eq = simd_load(&bank->ic1eq[lane]);
+    l.ic2eq = simd_load(&bank->ic2eq[lane]);
+    switch (mode)
+    {
+    case SVF_LOWPASS:
+        l.m0 = zero, l.m1 = zero, l.m2 = one;
+        break;
+    case SVF_BANDPASS:
+        l.m0 = zero, l.m1 = one, l.m2 = zero;
+        break;
+    case SVF_HIGHPASS:
+    default:
+        // high = v0 - k * v1 - v2
+        l.m0 = one, l.m1 = simd_sub(zero, simd_load(&bank->k[lane])), l.m2 = simd_set1(-1.0f);
+        break;
+    }
+    return l;
+}
+
+// Stores the state. The glide has finished, so the coefficients snap to their targets
+SIMD_INLINE void svf_lanes_store(SVFBank* bank, const SVFLanes* l, int lane)
+{
+    simd_store(&bank->ic1eq[lane], l->ic1eq);
+    simd_store(&bank->ic2eq[lane], l->ic2eq);
+    simd_store(&bank->a1[lane], simd_load(&bank->target1[lane]));
+    simd_store(&bank->a2[lane], simd_load(&bank->target2[lane]));
+    simd_store(&bank->a3[lane], simd_load(&bank->target3[lane]));
+}
+
+SIMD_INLINE simd_f svf_lanes_tick(SVFLanes* l, simd_f v0)
+{
+    simd_f two = simd_set1(2.0f);
+    simd_f v3  = simd_sub(v0, l->ic2eq);
+    simd_f v1  = simd_fmadd(l->a2, v3, simd_mul(l->a1, l->ic1eq));
+    simd_f v2  = simd_add(l->ic2eq, simd_fmadd(l->a3, v3, simd_mul(l->a2, l->ic1eq)));
+    l->ic1eq   = simd_sub(simd_mul(two, v1), l->ic1eq);
+    l->ic2eq   = simd_sub(simd_mul(two, v2), l->ic2eq);
+    l->a1      = simd_add(l->a1, l->d1);
+    l->a2      = simd_add(l->a2, l->d2);
+    l->a3      = simd_add(l->a3, l->d3);
+    return simd_fmadd(l->m0, v0, simd_fmadd(l->m1, v1, simd_mul(l->m2, v2)));
+}
+
+void svf_bank_process(SVFBank* bank, SVFMode mode, int lane0, int numLanes, float* buf, int numFrames)
+{
+    int g = 0;
+
+    assert(numLanes % SIMD_WIDTH == 0);
+    assert(lane0 + numLanes <= bank->numLanes);
+
+    // Each filter is one long dependency chain. Running two independent groups side by side hides the latency
+    for (; g + 2 * SIMD_WIDTH <= numLanes; g += 2 * SIMD_WIDTH)
+    {
+        SVFLanes a = svf_lanes_load(bank, mode, lane0 + g, numFrames);
+        SVFLanes b = svf_lanes_load(bank, mode, lane0 + g + SIMD_WIDTH, numFrames);
+        float*   p = buf + g;
+        for (int i = 0; i < numFrames; i++, p += numLanes)
+        {
+            simd_f ya = svf_lanes_tick(&a, simd_load(p));
+            simd_f yb = svf_lanes_tick(&b, simd_load(p + SIMD_WIDTH));
+            simd_store(p, ya);
+            simd_store(p + SIMD_WIDTH, yb);
+        }
+        svf_lanes_store(bank, &a, lane0 + g);
+        svf_lanes_store(bank, &b, lane0 + g + SIMD_WIDTH);
+    }
+    for (; g < numLanes; g += SIMD_WIDTH)
+    {
+        SVFLanes a = svf_lanes_load(bank, mode, lane0 + g, numFrames);
+        float*   p = buf + g;
+        for (int i = 0; i < numFrames; i++, p += numLanes)
+            simd_store(p, svf_lanes_tick(&a, simd_load(p)));
+        svf_lanes_store(bank, &a, lane0 + g);
+    }
+}
+
+void crossover_init(Crossover* xover, int numChannels)
+{
+    int numLanes = (numChannels + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    svf_bank_init(&xover->split, numLanes);
+    svf_bank_init(&xover->low, numLanes);
+    svf_bank_init(&xover->high, numLanes);
+}
+
+// LR4 is two cascaded butterworths
+SVFCoeffs crossover_coeffs(float cutoffHz, float sampleRate)
+{
+    return svf_coeffs(cutoffHz, 0.7071067811865475f, sampleRate);
+}
+
+void crossover_set(Crossover* xover, SVFCoeffs c)
+{
+    svf_bank_set_all(&xover->split, c);
+    svf_bank_set_all(&xover->low, c);
+    svf_bank_set_all(&xover->high, c);
+}
+
+void crossover_glide(Crossover* xover, SVFCoeffs c)
+{
+    svf_bank_glide_all(&xover->split, c);
+    svf_bank_glide_all(&xover->low, c);
+    svf_bank_glide_all(&xover->high, c);
+}
+
+void crossover_process(Crossover* xover, float* buf, int numFrames)
+{
+    const int numLanes = xover->split.numLanes;
+    for (int g = 0; g < numLanes; g += SIMD_WIDTH)
+    {
+        SVFLanes split = svf_lanes_load(&xover->split, SVF_LOWPASS, g, numFrames);
+        SVFLanes low   = svf_lanes_load(&xover->low, SVF_LOWPASS, g, numFrames);
+        SVFLanes high  = svf_lanes_load(&xover->high, SVF_HIGHPASS, g, numFrames);
+        simd_f   k     = simd_load(&xover->split.k[g]);
+        float*   p     = buf + g;
+
+        for (int i = 0; i < numFrames; i++, p += numLanes)
+        {
+            // Same as svf_lanes_tick(), but keeping both the low & high outputs
+            simd_f two  = simd_set1(2.0f);
+            simd_f v0   = simd_load(p);
+            simd_f v3   = simd_sub(v0, split.ic2eq);
+            simd_f v1   = simd_fmadd(split.a2, v3, simd_mul(split.a1, split.ic1eq));
+            simd_f v2   = simd_add(split.ic2eq, simd_fmadd(split.a3, v3, simd_mul(split.a2, split.ic1eq)));
+            split.ic1eq = simd_sub(simd_mul(two, v1), split.ic1eq);
+            split.ic2eq = simd_sub(simd_mul(two, v2), split.ic2eq);
+            split.a1    = simd_add(split.a1, split.d1);
+            split.a2    = simd_add(split.a2, split.d2);
+            split.a3    = simd_add(split.a3, split.d3);
+
+            simd_f lowBand  = svf_lanes_tick(&low, v2);
+            simd_f highBand = svf_lanes_tick(&high, simd_sub(simd_sub(v0, simd_mul(k, v1)), v2));
+            simd_store(p, simd_add(lowBand, highBand));
+        }
+        svf_lanes_store(&xover->split, &split, g);
+        svf_lanes_store(&xover->low, &low, g);
+        svf_lanes_store(&xover->high, &high, g);
+    }
+}
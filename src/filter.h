@@ -0,0 +1,77 @@
+#pragma once
+#include "simd.h"
+
+// Banks of state variable filters, one independent channel/voice per SIMD lane.
+// Andrew Simper's trapezoidal SVF: https://cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
+// Buffers are lane interleaved: buf[frame * numLanes + lane], where numLanes is a multiple of SIMD_WIDTH.
+// Banks wider than one register process two groups per loop, so 8 (SSE2/NEON) or 16 (AVX2) lanes per iteration.
+// Coefficients glide linearly from their current to their target value over each call to svf_bank_process(),
+// so callers can change them once per block without zipper noise.
+
+#define SVF_MAX_LANES 64
+
+typedef enum SVFMode
+{
+    SVF_LOWPASS,
+    SVF_BANDPASS,
+    SVF_HIGHPASS,
+} SVFMode;
+
+typedef struct SVFCoeffs
+{
+    float a1, a2, a3, k;
+} SVFCoeffs;
+
+SVFCoeffs svf_coeffs(float cutoffHz, float Q, float sampleRate);
+
+typedef struct SVFBank
+{
+    int numLanes;
+    // Coefficients per lane
+    SIMD_ALIGNED float a1[SVF_MAX_LANES];
+    SIMD_ALIGNED float a2[SVF_MAX_LANES];
+    SIMD_ALIGNED float a3[SVF_MAX_LANES];
+    SIMD_ALIGNED float k[SVF_MAX_LANES];
+    // Values the coefficients reach at the end of the next svf_bank_process()
+    SIMD_ALIGNED float target1[SVF_MAX_LANES];
+    SIMD_ALIGNED float target2[SVF_MAX_LANES];
+    SIMD_ALIGNED float target3[SVF_MAX_LANES];
+    // State per lane
+    SIMD_ALIGNED float ic1eq[SVF_MAX_LANES];
+    SIMD_ALIGNED float ic2eq[SVF_MAX_LANES];
+} SVFBank;
+
+void svf_bank_init(SVFBank* bank, int numLanes);
+void svf_bank_reset(SVFBank* bank);
+void svf_bank_reset_lane(SVFBank* bank, int lane);
+// Copies coefficients & state. Used when voices are moved between slots
+void svf_bank_copy_lane(SVFBank* bank, int dst, int src);
+
+// Sets coefficients immediately
+void svf_bank_set_lane(SVFBank* bank, int lane, SVFCoeffs c);
+void svf_bank_set_all(SVFBank* bank, SVFCoeffs c);
+// Sets coefficients to glide to during the next svf_bank_process(). k is not smoothed and changes immediately
+void svf_bank_glide_lane(SVFBank* bank, int lane, SVFCoeffs c);
+void svf_bank_glide_all(SVFBank* bank, SVFCoeffs c);
+// Glides lanes [lane, lane + SIMD_WIDTH) to a cutoff each. Used for modulation, where every voice has its own
+void svf_bank_glide_cutoffs(SVFBank* bank, int lane, simd_f cutoffHz, float Q, float sampleRate);
+
+// Filters lanes [lane0, lane0 + numLanes) in place. 'buf' holds numLanes interleaved channels
+void svf_bank_process(SVFBank* bank, SVFMode mode, int lane0, int numLanes, float* buf, int numFrames);
+
+// Linkwitz-Riley (LR4) crossover. Splits each channel at the cutoff and sums the bands back together,
+// giving an allpass response. The low & high band of the first stage come from the same filter state
+typedef struct Crossover
+{
+    SVFBank split;
+    SVFBank low;
+    SVFBank high;
+} Crossover;
+
+void crossover_init(Crossover* xover, int numChannels);
+// Butterworth coefficients for the crossover's cutoff
+SVFCoeffs crossover_coeffs(float cutoffHz, float sampleRate);
+void      crossover_set(Crossover* xover, SVFCoeffs c);
+void      crossover_glide(Crossover* xover, SVFCoeffs c);
+// 'buf' holds numChannels interleaved channels, numChannels rounded up to a multiple of SIMD_WIDTH
+void crossover_process(Crossover* xover, float* buf, int numFrames);
@@ -0,0 +1,152 @@
+#include "graph.h"
+
+#include <assert.h>
+#include <string.h>
+
+void graph_init(Graph* graph) { memset(graph, 0, sizeof(*graph)); }
+
+int graph_add_node(Graph* graph, const char* name, GraphProcess process, void* userdata, int numInputs,
+                   int numOutputs)
+{
+    GraphNode* node;
+
+    assert(numInputs >= 0 && numInputs <= GRAPH_MAX_PORTS);
+    assert(numOutputs >= 0 && numOutputs <= GRAPH_MAX_PORTS);
+    if (graph->numNodes == GRAPH_MAX_NODES)
+        return GRAPH_NONE;
+
+    node             = &graph->nodes[graph->numNodes];
+    node->name       = name;
+    node->process    = process;
+    node->userdata   = userdata;
+    node->numInputs  = numInputs;
+    node->numOutputs = numOutputs;
+    for (int i = 0; i < GRAPH_MAX_PORTS; i++)
+    {
+        node->srcNode[i] = GRAPH_NONE;
+        node->srcPort[i] = 0;
+    }
+    graph->compiled = 0;
+    return graph->numNodes++;
+}
+
+int graph_connect(Graph* graph, int srcNode, int srcPort, int dstNode, int dstPort)
+{
+    if (srcNode < 0 || srcNode >= graph->numNodes || dstNode < 0 || dstNode >= graph->numNodes)
+        return 1;
+    if (srcPort < 0 || srcPort >= graph->nodes[srcNode].numOutputs || dstPort < 0 ||
+        dstPort >= graph->nodes[dstNode].numInputs)
+        return 1;
+    graph->nodes[dstNode].srcNode[dstPort] = (int8_t)srcNode;
+    graph->nodes[dstNode].srcPort[dstPort] = (int8_t)srcPort;
+    graph->compiled                        = 0;
+    return 0;
+}
+
+// Kahn's algorithm, taking the lowest numbered ready node each time so the order only depends on the connections.
+// Fills graph->order and each node's position in it. Returns non zero on a cycle
+static int graph_sort(Graph* graph, int* position)
+{
+    int waiting[GRAPH_MAX_NODES];
+
+    for (int n = 0; n < graph->numNodes; n++)
+    {
+        waiting[n]  = 0;
+        position[n] = -1;
+        for (int i = 0; i < graph->nodes[n].numInputs; i++)
+            waiting[n] += graph->nodes[n].srcNode[i] != GRAPH_NONE;
+    }
+
+    for (int p = 0; p < graph->numNodes; p++)
+    {
+        int next = 0;
+        while (next < graph->numNodes && (position[next] >= 0 || waiting[next] > 0))
+            next++;
+        if (next == graph->numNodes)
+            return 1;
+
+        position[next]  = p;
+        graph->order[p] = (uint8_t)next;
+        for (int n = 0; n < graph->numNodes; n++)
+            for (int i = 0; i < graph->nodes[n].numInputs; i++)
+                waiting[n] -= graph->nodes[n].srcNode[i] == next;
+    }
+    return 0;
+}
+
+int graph_compile(Graph* graph)
+{
+    int position[GRAPH_MAX_NODES];
+    // Position of the last node reading each output
+    int lastRead[GRAPH_MAX_NODES][GRAPH_MAX_PORTS];
+    // Position each buffer is free after
+    int freeAfter[GRAPH_MAX_BUFFERS];
+
+    graph->compiled   = 0;
+    graph->numBuffers = 0;
+    if (graph_sort(graph, position) != 0)
+        return 1;
+
+    for (int n = 0; n < graph->numNodes; n++)
+        for (int k = 0; k < GRAPH_MAX_PORTS; k++)
+            lastRead[n][k] = -1;
+    for (int n = 0; n < graph->numNodes; n++)
+    {
+        const GraphNode* node = &graph->nodes[n];
+        for (int i = 0; i < node->numInputs; i++)
+        {
+            int* last;
+            if (node->srcNode[i] == GRAPH_NONE)
+                continue;
+            last  = &lastRead[node->srcNode[i]][node->srcPort[i]];
+            *last = *last > position[n] ? *last : position[n];
+        }
+    }
+
+    for (int p = 0; p < graph->numNodes; p++)
+    {
+        GraphNode* node = &graph->nodes[graph->order[p]];
+
+        // Everything feeding this node has run, so its inputs are already assigned
+        for (int i = 0; i < node->numInputs; i++)
+        {
+            if (node->srcNode[i] == GRAPH_NONE)
+                node->inputs[i] = graph->silence;
+            else
+                node->inputs[i] = graph->nodes[node->srcNode[i]].outputs[node->srcPort[i]];
+        }
+
+        for (int k = 0; k < node->numOutputs; k++)
+        {
+            int last = lastRead[graph->order[p]][k];
+            int best = -1;
+
+            // The most recently freed buffer is the most likely to still be in cache
+            for (int b = 0; b < graph->numBuffers; b++)
+                if (freeAfter[b] < p && (best < 0 || freeAfter[b] > freeAfter[best]))
+                    best = b;
+            if (best < 0)
+            {
+                if (graph->numBuffers == GRAPH_MAX_BUFFERS)
+                    return 2;
+                best = graph->numBuffers++;
+            }
+            // Nothing reads it, so it's an output of the graph and has to last until the end
+            freeAfter[best]  = last >= 0 ? last : graph->numNodes;
+            node->outputs[k] = graph->buffers[best];
+        }
+    }
+    graph->compiled = 1;
+    return 0;
+}
+
+void graph_run(Graph* graph, int numFrames)
+{
+    assert(graph->compiled);
+    assert(numFrames <= GRAPH_MAX_FRAMES);
+    for (int p = 0; p < graph->numNodes; p++)
+    {
+        GraphNode* node = &graph->nodes[graph->order[p]];
+        node->process(node->userdata, node->inputs, node->outputs, numFrames);
+    }
+}
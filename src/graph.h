@@ -0,0 +1,70 @@
+#pragma once
+#include "simd.h"
+
+#include <stdint.h>
+
+// Fixed audio processing graph. Nodes have planar mono ports, one buffer of up to GRAPH_MAX_FRAMES per port.
+// graph_compile() sorts the nodes so each runs after everything feeding it, then hands out buffers by liveness:
+// a buffer is taken when its output is written and returned after the last node reading it has run, so a long
+// chain only touches a few buffers, which stay in L1. Freed buffers are reused newest first, while still warm.
+// All buffers are part of the Graph. Compiling is cheap but not constant time, so do it before rendering.
+// graph_run() never allocates or locks.
+// Outputs nothing reads stay valid until the end of graph_run(). They are the graph's outputs.
+
+#ifndef GRAPH_MAX_FRAMES
+#define GRAPH_MAX_FRAMES 64
+#endif
+#define GRAPH_MAX_NODES 32
+#define GRAPH_MAX_PORTS 8
+#define GRAPH_MAX_BUFFERS 16
+// Source of an unconnected input, which reads silence
+#define GRAPH_NONE -1
+
+// 'inputs' & 'outputs' never overlap
+typedef void (*GraphProcess)(void* userdata, const float* const* inputs, float* const* outputs, int numFrames);
+
+typedef struct GraphNode
+{
+    const char*  name;
+    GraphProcess process;
+    void*        userdata;
+    int          numInputs;
+    int          numOutputs;
+    // Node & output port feeding each input
+    int8_t srcNode[GRAPH_MAX_PORTS];
+    int8_t srcPort[GRAPH_MAX_PORTS];
+    // Set by graph_compile()
+    const float* inputs[GRAPH_MAX_PORTS];
+    float*       outputs[GRAPH_MAX_PORTS];
+} GraphNode;
+
+typedef struct Graph
+{
+    int       numNodes;
+    GraphNode nodes[GRAPH_MAX_NODES];
+    // Set by graph_compile(). Nodes in the order they run, and how many buffers they share
+    uint8_t order[GRAPH_MAX_NODES];
+    int     numBuffers;
+    int     compiled;
+
+    SIMD_ALIGNED float silence[GRAPH_MAX_FRAMES];
+    SIMD_ALIGNED float buffers[GRAPH_MAX_BUFFERS][GRAPH_MAX_FRAMES];
+} Graph;
+
+void graph_init(Graph* graph);
+// Returns the node's index, or GRAPH_NONE if the graph is full. Adding nodes or connections uncompiles the graph
+int graph_add_node(Graph* graph, const char* name, GraphProcess process, void* userdata, int numInputs,
+                   int numOutputs);
+// Returns 0 on success, non zero if either port doesn't exist
+int graph_connect(Graph* graph, int srcNode, int srcPort, int dstNode, int dstPort);
+// Returns 0 on success, non zero if the connections have a cycle or need more than GRAPH_MAX_BUFFERS buffers
+int graph_compile(Graph* graph);
+
+// Runs every node once. numFrames <= GRAPH_MAX_FRAMES
+void graph_run(Graph* graph, int numFrames);
+
+// Buffer written by a node's output port. Only valid once compiled
+static inline const float* graph_output(const Graph* graph, int node, int port)
+{
+    return graph->nodes[node].outputs[port];
+}
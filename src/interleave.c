@@ -0,0 +1,93 @@
+#include "interleave.h"
+#include "simd.h"
+
+// Each zip doubles the channels per vector. After log2(channels) rounds of zips, vector k holds frames
+// [k * W / channels, (k + 1) * W / channels) fully interleaved. Pairing channel c with c + channels / 2 in
+// every round is what puts them back in order
+
+static void interleave_2(const float* const* in, float* out, int numFrames)
+{
+    int i = 0;
+    for (; i + SIMD_WIDTH <= numFrames; i += SIMD_WIDTH, out += 2 * SIMD_WIDTH)
+    {
+        simd_f lo, hi;
+        simd_zip(simd_load(in[0] + i), simd_load(in[1] + i), &lo, &hi);
+        simd_storeu(out, lo);
+        simd_storeu(out + SIMD_WIDTH, hi);
+    }
+    for (; i < numFrames; i++, out += 2)
+    {
+        out[0] = in[0][i];
+        out[1] = in[1][i];
+    }
+}
+
+static void interleave_4(const float* const* in, float* out, int numFrames)
+{
+    int i = 0;
+    for (; i + SIMD_WIDTH <= numFrames; i += SIMD_WIDTH, out += 4 * SIMD_WIDTH)
+    {
+        simd_f a[4], b[4];
+        simd_zip(simd_load(in[0] + i), simd_load(in[2] + i), &a[0], &a[1]);
+        simd_zip(simd_load(in[1] + i), simd_load(in[3] + i), &a[2], &a[3]);
+        simd_zip(a[0], a[2], &b[0], &b[1]);
+        simd_zip(a[1], a[3], &b[2], &b[3]);
+        for (int k = 0; k < 4; k++)
+            simd_storeu(out + k * SIMD_WIDTH, b[k]);
+    }
+    for (; i < numFrames; i++, out += 4)
+        for (int c = 0; c < 4; c++)
+            out[c] = in[c][i];
+}
+
+static void interleave_8(const float* const* in, float* out, int numFrames)
+{
+    int i = 0;
+    for (; i + SIMD_WIDTH <= numFrames; i += SIMD_WIDTH, out += 8 * SIMD_WIDTH)
+    {
+        simd_f a[8], b[8], c[8];
+        // Round 1 pairs channels 4 apart, round 2 pairs 2 apart, round 3 neighbours
+        for (int k = 0; k < 4; k++)
+            simd_zip(simd_load(in[k] + i), simd_load(in[k + 4] + i), &a[2 * k], &a[2 * k + 1]);
+        // a[2k], a[2k+1] hold channels k & k+4. Zip (0,4) with (2,6), and (1,5) with (3,7)
+        simd_zip(a[0], a[4], &b[0], &b[1]);
+        simd_zip(a[1], a[5], &b[2], &b[3]);
+        simd_zip(a[2], a[6], &b[4], &b[5]);
+        simd_zip(a[3], a[7], &b[6], &b[7]);
+        // b[0..3] hold channels 0 2 4 6, b[4..7] channels 1 3 5 7
+        simd_zip(b[0], b[4], &c[0], &c[1]);
+        simd_zip(b[1], b[5], &c[2], &c[3]);
+        simd_zip(b[2], b[6], &c[4], &c[5]);
+        simd_zip(b[3], b[7], &c[6], &c[7]);
+        for (int k = 0; k < 8; k++)
+            simd_storeu(out + k * SIMD_WIDTH, c[k]);
+    }
+    for (; i < numFrames; i++, out += 8)
+        for (int c = 0; c < 8; c++)
+            out[c] = in[c][i];
+}
+
+void interleave(const float* const* planar, int numChannels, float* out, int numFrames)
+{
+    switch (numChannels)
+    {
+    case 1:
+        for (int i = 0; i < numFrames; i++)
+            out[i] = planar[0][i];
+        break;
+    case 2:
+        interleave_2(planar, out, numFrames);
+        break;
+    case 4:
+        interleave_4(planar, out, numFrames);
+        break;
+    case 8:
+        interleave_8(planar, out, numFrames);
+        break;
+    default:
+        for (int i = 0; i < numFrames; i++)
+            for (int c = 0; c < numChannels; c++)
+                *out++ = planar[c][i];
+        break;
+    }
+}
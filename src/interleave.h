@@ -0,0 +1,7 @@
+#pragma once
+
+// Planar <-> interleaved conversion for the audio backend.
+// 2, 4 & 8 channels are interleaved with SIMD shuffles, other counts fall back to a plain loop.
+// Planar buffers must be SIMD aligned. The interleaved buffer can have any alignment
+
+void interleave(const float* const* planar, int numChannels, float* out, int numFrames);
@@ -0,0 +1,80 @@
+#include "midisched.h"
+
+#include <string.h>
+
+void midisched_init(MidiScheduler* sched, float sampleRate)
+{
+    memset(sched, 0, sizeof(*sched));
+    sched->framesPerMs = sampleRate / 1000.0;
+}
+
+void midisched_push(MidiScheduler* sched, uint8_t status, uint8_t data1, uint8_t data2, uint32_t timestampMs)
+{
+    int64_t frame;
+    int64_t maxAhead;
+    int     i;
+
+    if (! sched->anchored || (int32_t)(timestampMs - sched->lastMs) > MIDISCHED_REANCHOR_MS)
+    {
+        sched->anchored    = 1;
+        sched->anchorMs    = timestampMs;
+        sched->anchorFrame = sched->blockStart;
+    }
+    sched->lastMs = timestampMs;
+
+    frame = (int64_t)sched->anchorFrame + (int64_t)((int32_t)(timestampMs - sched->anchorMs) * sched->framesPerMs);
+
+    // Late. Add just enough latency to play it now, later messages keep their spacing
+    if (frame < (int64_t)sched->blockStart)
+    {
+        sched->anchorFrame += sched->blockStart - frame;
+        frame              = sched->blockStart;
+    }
+    // Messages are never older than one block. Any further ahead means the two clocks have drifted apart
+    maxAhead = 2 * (int64_t)sched->lastBlockFrames + (int64_t)sched->framesPerMs;
+    if (sched->lastBlockFrames != 0 && frame > (int64_t)sched->blockStart + maxAhead)
+    {
+        sched->anchorFrame -= frame - (sched->blockStart + maxAhead);
+        frame              = sched->blockStart + maxAhead;
+    }
+
+    // Dropping is the only option when full. 256 messages in a block is far beyond what a MIDI cable can carry
+    if (sched->numPending == MIDISCHED_MAX_PENDING)
+        return;
+
+    // Messages mostly arrive in order, so this rarely moves anything
+    i = sched->numPending;
+    while (i > 0 && sched->pending[i - 1].frame > (uint64_t)frame)
+    {
+        sched->pending[i] = sched->pending[i - 1];
+        i--;
+    }
+    sched->pending[i].frame  = (uint64_t)frame;
+    sched->pending[i].status = status;
+    sched->pending[i].data1  = data1;
+    sched->pending[i].data2  = data2;
+    sched->numPending++;
+}
+
+int midisched_pop_block(MidiScheduler* sched, int numFrames, SynthEvent* events, int maxEvents)
+{
+    const uint64_t blockEnd  = sched->blockStart + numFrames;
+    int            numEvents = 0;
+
+    while (numEvents < sched->numPending && numEvents < maxEvents && sched->pending[numEvents].frame < blockEnd)
+    {
+        const MidiSchedEvent* src = &sched->pending[numEvents];
+        SynthEvent*           dst = &events[numEvents];
+        dst->frame                = (int)(src->frame - sched->blockStart);
+        dst->status               = src->status;
+        dst->data1                = src->data1;
+        dst->data2                = src->data2;
+        numEvents++;
+    }
+    sched->numPending -= numEvents;
+    memmove(sched->pending, sched->pending + numEvents, sched->numPending * sizeof(*sched->pending));
+
+    sched->blockStart      = blockEnd;
+    sched->lastBlockFrames = numFrames;
+    return numEvents;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "synth.h"
+
+#include <stdint.h>
+
+// Turns MIDI timestamps into sample offsets inside the audio block.
+// The audio thread only learns about messages at the start of each callback, all of them received some time during
+// the previous block. Instead of starting them all on sample 0, messages are mapped from the MIDI driver's clock
+// (milliseconds) onto the audio clock (frames) and played back with a constant latency, keeping their spacing.
+// The latency grows to the smallest value that keeps every message on time, and is reset after a pause in playing.
+
+#define MIDISCHED_MAX_PENDING 256
+// After this much silence, the next message re-anchors the MIDI clock to the audio clock
+#define MIDISCHED_REANCHOR_MS 1000
+
+typedef struct MidiSchedEvent
+{
+    uint64_t frame; // absolute frame, counted from midisched_init()
+    uint8_t  status;
+    uint8_t  data1;
+    uint8_t  data2;
+} MidiSchedEvent;
+
+typedef struct MidiScheduler
+{
+    double   framesPerMs;
+    uint64_t blockStart;
+    int      lastBlockFrames;
+
+    int      anchored;
+    uint32_t anchorMs;
+    uint64_t anchorFrame; // audio frame matching anchorMs
+    uint32_t lastMs;
+
+    // Sorted by frame
+    int            numPending;
+    MidiSchedEvent pending[MIDISCHED_MAX_PENDING];
+} MidiScheduler;
+
+void midisched_init(MidiScheduler* sched, float sampleRate);
+// Queues a message read at the start of this callback
+void midisched_push(MidiScheduler* sched, uint8_t status, uint8_t data1, uint8_t data2, uint32_t timestampMs);
+// Moves the messages due in the next numFrames into 'events' as block offsets, then advances to the next block.
+// Returns the number of events written
+int midisched_pop_block(MidiScheduler* sched, int numFrames, SynthEvent* events, int maxEvents);
@@ -0,0 +1,94 @@
+#include "modulation.h"
+
+#include <math.h>
+#include <string.h>
+
+const char* const MOD_SOURCE_NAMES[MOD_SRC_COUNT] = {"LFO 1", "LFO 2", "Envelope", "Velocity", "Mod wheel"};
+const char* const MOD_DEST_NAMES[MOD_DST_COUNT]   = {"Pitch", "Cutoff", "Gain"};
+
+float lfo_advance(Lfo* lfo, int numFrames, float sampleRate)
+{
+    static const float pi = 3.141592653589793f;
+
+    float t = lfo->phase + lfo->rateHz * (float)numFrames / sampleRate;
+    t       -= (float)(int)t;
+    lfo->phase = t;
+
+    switch (lfo->shape)
+    {
+    case LFO_SINE:
+        // Only called once per control period, so libm is fine here
+        return sinf(2.0f * pi * t);
+    case LFO_TRIANGLE:
+        return 1.0f - 4.0f * fabsf(t - 0.5f);
+    case LFO_SQUARE:
+    default:
+        return t < 0.5f ? 1.0f : -1.0f;
+    }
+}
+
+void modenv_advance(const ModEnvelope* env, float* level, uint8_t* stage, float seconds)
+{
+    float x = *level;
+
+    switch (*stage)
+    {
+    case MOD_ENV_ATTACK:
+        x += env->attack > 0 ? seconds / env->attack : 1.0f;
+        if (x >= 1.0f)
+        {
+            x      = 1.0f;
+            *stage = MOD_ENV_DECAY;
+        }
+        break;
+    case MOD_ENV_DECAY:
+        x -= env->decay > 0 ? seconds / env->decay : 1.0f;
+        if (x <= env->sustain)
+        {
+            x      = env->sustain;
+            *stage = MOD_ENV_SUSTAIN;
+        }
+        break;
+    case MOD_ENV_SUSTAIN:
+        x = env->sustain;
+        break;
+    case MOD_ENV_RELEASE:
+        x -= env->release > 0 ? seconds / env->release : 1.0f;
+        if (x <= 0.0f)
+        {
+            x      = 0.0f;
+            *stage = MOD_ENV_IDLE;
+        }
+        break;
+    case MOD_ENV_IDLE:
+    default:
+        x = 0.0f;
+        break;
+    }
+    *level = x;
+}
+
+void modmatrix_clear(ModMatrix* matrix) { memset(matrix, 0, sizeof(*matrix)); }
+
+int modmatrix_add(ModMatrix* matrix, ModSource source, ModDest dest, float amount)
+{
+    ModSlot* slot;
+
+    if (amount == 0.0f)
+        return 0;
+    if (matrix->numSlots == MOD_MAX_SLOTS)
+        return 1;
+    slot         = &matrix->slots[matrix->numSlots++];
+    slot->source = source;
+    slot->dest   = dest;
+    slot->amount = amount;
+    return 0;
+}
+
+void modmatrix_remove(ModMatrix* matrix, int index)
+{
+    matrix->numSlots--;
+    memmove(&matrix->slots[index], &matrix->slots[index + 1], (matrix->numSlots - index) * sizeof(ModSlot));
+    // Zeroed like modmatrix_clear leaves it, so matrices holding the same routes compare equal
+    memset(&matrix->slots[matrix->numSlots], 0, sizeof(ModSlot));
+}
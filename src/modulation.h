@@ -0,0 +1,105 @@
+#pragma once
+#include "simd.h"
+
+#include <stdint.h>
+
+// Control rate modulation: LFOs, an ADSR envelope per voice, and the matrix routing them to voice parameters.
+// Nothing here runs per sample. The synth reads the sources once per control period and ramps its destinations
+// linearly across it, so modulation costs a handful of operations per voice every SYNTH_CONTROL_FRAMES.
+// Global sources (LFOs, mod wheel) are the same for every voice. Per voice sources (envelope, velocity) have a
+// value per lane.
+
+typedef enum ModSource
+{
+    MOD_SRC_LFO1,     // -1 to 1
+    MOD_SRC_LFO2,     // -1 to 1
+    MOD_SRC_ENVELOPE, // 0-1
+    MOD_SRC_VELOCITY, // 0-1
+    MOD_SRC_MODWHEEL, // 0-1
+    MOD_SRC_COUNT,
+} ModSource;
+
+typedef enum ModDest
+{
+    MOD_DST_PITCH,  // semitones
+    MOD_DST_CUTOFF, // octaves
+    MOD_DST_GAIN,   // dB
+    MOD_DST_COUNT,
+} ModDest;
+
+extern const char* const MOD_SOURCE_NAMES[MOD_SRC_COUNT];
+extern const char* const MOD_DEST_NAMES[MOD_DST_COUNT];
+
+#define MOD_NUM_LFOS 2
+#define MOD_MAX_SLOTS 8
+
+typedef enum LfoShape
+{
+    LFO_SINE,
+    LFO_TRIANGLE,
+    LFO_SQUARE,
+    LFO_SHAPE_COUNT,
+} LfoShape;
+
+typedef struct Lfo
+{
+    LfoShape shape;
+    float    rateHz;
+    float    phase; // 0-1
+} Lfo;
+
+// Advances by numFrames and returns the value reached, -1 to 1
+float lfo_advance(Lfo* lfo, int numFrames, float sampleRate);
+
+typedef enum ModEnvStage
+{
+    MOD_ENV_ATTACK,
+    MOD_ENV_DECAY,
+    MOD_ENV_SUSTAIN,
+    MOD_ENV_RELEASE,
+    MOD_ENV_IDLE,
+} ModEnvStage;
+
+// Linear ADSR. Times in seconds, from silence to full scale. The state lives with each voice
+typedef struct ModEnvelope
+{
+    float attack;
+    float decay;
+    float sustain; // 0-1
+    float release;
+} ModEnvelope;
+
+// Advances one voice's envelope by 'seconds', updating its level & stage
+void modenv_advance(const ModEnvelope* env, float* level, uint8_t* stage, float seconds);
+
+// Amount is in the destination's units at full scale source
+typedef struct ModSlot
+{
+    ModSource source;
+    ModDest   dest;
+    float     amount;
+} ModSlot;
+
+typedef struct ModMatrix
+{
+    int     numSlots;
+    ModSlot slots[MOD_MAX_SLOTS];
+} ModMatrix;
+
+void modmatrix_clear(ModMatrix* matrix);
+// Returns 0 on success, non zero if all slots are taken. Slots with no amount are skipped
+int modmatrix_add(ModMatrix* matrix, ModSource source, ModDest dest, float amount);
+// Removes slot 'index', keeping the others in order
+void modmatrix_remove(ModMatrix* matrix, int index);
+
+// Sums the slots into 'dests' for SIMD_WIDTH voices. sources[s] holds each lane's value of source s
+SIMD_INLINE void modmatrix_eval_lanes(const ModMatrix* matrix, const simd_f* sources, simd_f* dests)
+{
+    for (int d = 0; d < MOD_DST_COUNT; d++)
+        dests[d] = simd_set1(0.0f);
+    for (int i = 0; i < matrix->numSlots; i++)
+    {
+        const ModSlot* slot = &matrix->slots[i];
+        dests[slot->dest]   = simd_fmadd(sources[slot->source], simd_set1(slot->amount), dests[slot->dest]);
+    }
+}
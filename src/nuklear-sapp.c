@@ -25,7 +25,15 @@
 #include "thread.h"
 #define MINIMIDI_IMPL
 #define MINIMIDI_USE_GLOBAL
+#include "analyzer.h"
+#include "blockfifo.h"
 #include "minimidi.h"
+#include "midisched.h"
+#include "paramstore.h"
+#include "resample.h"
+#include "scope.h"
+#include "spscring.h"
+#include "synth.h"
 
 #ifdef _WIN32
 // void Sleep(unsigned long ms);
@@ -38,19 +46,16 @@
 #endif
 
 #include <math.h>
+#include <stdlib.h>
 
-static int draw_demo_ui(struct nk_context* ctx);
+static int  draw_demo_ui(struct nk_context* ctx);
+static void draw_spectrum(struct nk_context* ctx);
+static void draw_scope(struct nk_context* ctx);
 
 // Midi stuff
 thread_atomic_int_t gExitThreads = {.i = 0};
 thread_ptr_t        gMidiThread  = NULL;
 
-enum MidiEventType
-{
-    MIDI_NOTE_OFF = 0x80,
-    MIDI_NOTE_ON  = 0x90,
-};
-
 // Midi thread...
 static int midi_cb(void* userdata)
 {
@@ -141,125 +146,193 @@ enum
     AUDIO_OFF,
     AUDIO_ON
 };
-static int gAudioBypass = AUDIO_ON;
-// -60-0dB
-static float gGaindB = -12.0f;
-// oscillator phase, 0-1
-static float gPhase = 0.0f;
+static ParamInt gAudioBypass;
+
+// Presets, one per MIDI program: saved ones from PRESETS_PATH, or the factory ones. Owned by the UI thread
+#define PRESETS_PATH "presets/%d.preset"
+#define NUM_PROGRAMS 128
+static SynthPreset gBank[NUM_PROGRAMS];
+static int         gProgram;
+// Owned by the UI thread. Edits made in a frame reach the audio thread together, as a whole patch built by the UI
+// thread in the triple buffer's back buffer. The audio thread swaps it in at the start of a block
+static SynthPreset       gUIPreset;
+static SynthPreset       gPublishedPreset;
+static SynthPatch        gPatchBuffers[3];
+static ParamTripleBuffer gPatches;
+// Program Change from MIDI, for the UI thread to switch to. -1 if none
+static ParamInt gProgramChange;
+
+// Written by the audio thread for display
+static ParamInt gLastNote;
+static ParamInt gNumVoices;
+// Output tapped for display, interleaved. Written by the audio thread, drained by frame()
+#define TAP_RING_SIZE (1 << 15)
+static float    gTapStorage[TAP_RING_SIZE];
+static SpscRing gTapRing;
+// Owned by the UI thread
+static Analyzer gAnalyzer;
+static int      gAnalyzerReady;
+static Scope    gScope;
+
+// Renders voices on other cores when there are enough of them
+static WorkPool gWorkPool;
+
+// Owned by the audio thread, initialised on the first callback
+static Synth         gSynth = {.lastNote = 0xff};
+static MidiScheduler gMidiScheduler;
+static SynthEvent    gEvents[MIDISCHED_MAX_PENDING];
+static BlockFifo     gBlockFifo; // fixed size synth blocks, whatever size the backend asks for
+static Resampler     gResampler; // engine rate to device rate
+// Set up by init(), before the audio thread starts. Skipped if it couldn't be allocated
+#define ROOM_IR_SECONDS 2.5f
+#define ROOM_RT60 1.8f
+static Reverb gReverb;
+static int    gReverbReady;
+// Long enough for the echo preset
+#define DELAY_MAX_SECONDS 1.0f
+static Delay gDelay;
+static int   gDelayReady;
+// Samples named after their root note, e.g. samples/60.wav, each playing up to halfway to the next
+#define SAMPLES_PATH "samples/%d.wav"
+static Sampler gSampler;
+static int     gSamplerReady;
+
+// Renders numFrames at the engine's rate
+static void engine_render(void* userdata, float* buffer, int numFrames)
+{
+    (void)userdata;
 
-static float gCrossover = 0.5f;
+    // The scheduler follows the engine's clock, which runs up to a block ahead of the backend
+    int numRendered = blockfifo_frames_to_render(&gBlockFifo, numFrames);
+    int numEvents   = midisched_pop_block(&gMidiScheduler, numRendered, gEvents, MIDISCHED_MAX_PENDING);
 
-// If 0-127 if playing, 255 (0xff) if inactive
-static uint8_t      gCurrentMidiNote = 0xff;
-static inline float gain_to_db(float g) { return log10f(g) * 20; }
-static inline float db_to_gain(float db) { return pow(10, db / 20); }
-static inline float norm_to_hz(float norm) { return 20 * exp2f(norm * 10); }
+    // Check if playing
+    if (param_int_load(&gAudioBypass) == AUDIO_OFF)
+    {
+        for (int i = 0; i < numEvents; i++)
+            synth_handle_event(&gSynth, &gEvents[i]);
+        memset(buffer, 0, numFrames * gBlockFifo.numChannels * sizeof(*buffer));
+        blockfifo_reset(&gBlockFifo);
+    }
+    else
+    {
+        // The front buffer is ours until the next acquire, graph buffers included
+        SynthPatch* patch = (SynthPatch*)param_triple_acquire(&gPatches);
 
-static float stage1_ic1eq = 0;
-static float stage1_ic2eq = 0;
-static float stage2_ic1eq = 0;
-static float stage2_ic2eq = 0;
+        // Only the source values are passed on. The synth works out what changed
+        synth_set_patch(&gSynth, patch);
+        blockfifo_process(&gBlockFifo, &gSynth, gEvents, numEvents, buffer, numFrames);
+    }
+}
 
 // Audio thread...
 static void audio_cb(float* buffer, int num_frames, int num_channels)
 {
-    assert(1 == num_channels);
     if (thread_atomic_int_load(&gExitThreads) == 1)
         return;
+    // The backend owns this thread and may change its floating point mode
+    simd_flush_denormals();
 
-    MiniMIDI*       mm  = minimidi_get_global();
-    MiniMIDIMessage msg = minimidi_read_message(mm);
-    while (msg.timestampMs != 0)
+    // The backend may not give us the sample rate we asked for, so we wait until it's running
+    if (gSynth.sampleRate == 0)
     {
-        if ((msg.status & 0xf0) == MIDI_NOTE_ON)
-        {
-            uint8_t channel  = msg.status & 0x0f;
-            uint8_t midiNote = msg.data1;
-            uint8_t velocity = msg.data2;
-            // ignore channel & velocity
-            gCurrentMidiNote = midiNote;
-        }
-        else if ((msg.status & 0xf0) == MIDI_NOTE_OFF)
+        int engineRate = SYNTH_ENGINE_RATE;
+        if (resample_init(&gResampler, engineRate, saudio_sample_rate(), num_channels) != 0)
         {
-            uint8_t channel  = msg.status & 0x0f;
-            uint8_t midiNote = msg.data1;
-            uint8_t velocity = msg.data2;
-            // ignore channel & velocity
-            if (midiNote == gCurrentMidiNote)
-                gCurrentMidiNote = 0xff;
+            // No table for this ratio. Run the synth at the device's rate instead
+            engineRate = saudio_sample_rate();
+            resample_init(&gResampler, engineRate, engineRate, num_channels);
         }
-        msg = minimidi_read_message(mm);
+        synth_init(&gSynth, (float)engineRate);
+        gSynth.workers = &gWorkPool;
+        if (gReverbReady)
+            synth_set_reverb(&gSynth, &gReverb);
+        if (gDelayReady)
+            synth_set_delay(&gSynth, &gDelay);
+        if (gSamplerReady)
+            synth_set_sampler(&gSynth, &gSampler);
+        midisched_init(&gMidiScheduler, (float)engineRate);
+        blockfifo_init(&gBlockFifo, num_channels);
     }
 
-    // Check if playing
-    if (gCurrentMidiNote == 0xff || gAudioBypass == AUDIO_OFF)
+    MiniMIDI*       mm  = minimidi_get_global();
+    MiniMIDIMessage msg = minimidi_read_message(mm);
+    while (msg.timestampMs != 0)
     {
-        memset(buffer, 0, num_frames * sizeof(*buffer));
-        return;
+        // Building the new patch is left to the UI thread
+        if ((msg.status & 0xf0) == MIDI_PROGRAM_CHANGE)
+            param_int_store(&gProgramChange, msg.data1);
+        else
+            midisched_push(&gMidiScheduler, msg.status, msg.data1, msg.data2, msg.timestampMs);
+        msg = minimidi_read_message(mm);
     }
 
-    float Hz    = exp2f(((float)gCurrentMidiNote - 69.0f) * 0.0833333f) * 440.0f;
-    float phase = gPhase;
-    float inc   = Hz / (float)saudio_sample_rate();
-    float vol   = db_to_gain(gGaindB);
+    resample_process(&gResampler, engine_render, NULL, buffer, num_frames);
+    // One copy of the block. If the UI falls behind, blocks are dropped instead of waited for
+    spsc_ring_write(&gTapRing, buffer, num_frames * num_channels);
+
+    param_int_store(&gLastNote, gSynth.lastNote);
+    param_int_store(&gNumVoices, gSynth.voices.numActive);
+}
+
+// App stuff
+
+static void load_bank(void)
+{
+    char path[64];
 
-    for (int i = 0; i < num_frames; i++)
+    for (int i = 0; i < NUM_PROGRAMS; i++)
     {
-        float sample = phase >= 0.5f ? 1.0f : -1.0f;
-        // float sample = sinf(phase * 2 * 3.14159265f);
-        // buffer[i] = vol * sinf(phase * 2 * 3.14159265f);
-        buffer[i] = vol * sample;
-        phase     += inc;
-        phase     -= (int)phase;
+        snprintf(path, sizeof(path), PRESETS_PATH, i);
+        if (preset_load(&gBank[i], path) != 0)
+            preset_factory(&gBank[i], i < PRESET_NUM_FACTORY ? i : 0);
     }
-    gPhase = phase;
-
-    // Crossover
-    static float pi         = 3.141592653589793;
-    static float inv_sqrt_2 = 0.7071067811865475f; // butterworth
-    float        cutoff     = norm_to_hz(gCrossover);
-
-    float g  = tanf(pi * cutoff / saudio_sample_rate());
-    float k  = 2 * inv_sqrt_2;
-    float a0 = 1.0f / ((1 + g) * (1 + g) - g * k);
-    float a1 = k * a0;
-    float a2 = (1 + g) * a0;
-    float a3 = g * a2;
-    float a4 = 1 / (1 + g);
-    float a5 = g * a4;
-
-    float ic1eq = stage1_ic1eq;
-    float ic2eq = stage1_ic2eq;
-    float ic3eq = stage2_ic1eq;
-    float ic4eq = stage2_ic2eq;
-    for (int i = 0; i < num_frames; i++)
-    {
-        float v0 = buffer[i];
-        float v1 = a1 * ic2eq + a2 * ic1eq + a3 * v0;
-        float v2 = a4 * ic2eq + a5 * v1;
+}
 
-        float v3 = a1 * ic2eq + a2 * ic1eq + a3 * v2;
-        float v4 = a4 * ic2eq + a5 * v1;
+// Unsaved edits to the current preset are dropped
+static void select_program(int program)
+{
+    gProgram  = program;
+    gUIPreset = gBank[program];
+}
 
-        ic1eq = 2 * (v1 - k * v2) - ic1eq;
-        ic2eq = 2 * v2 - ic2eq;
+static void save_program(void)
+{
+    char path[64];
 
-        ic3eq = 2 * (v3 - k * v4) - ic3eq;
-        ic4eq = 2 * v4 - ic4eq;
+    snprintf(path, sizeof(path), PRESETS_PATH, gProgram);
+    gBank[gProgram] = gUIPreset;
+    if (preset_save(&gUIPreset, path) != 0)
+        print("Failed saving preset to %s\n", path);
+}
 
-        float low  = v4;
-        float high = v0 - v4;
+// Returns the number of samples loaded
+static int load_samples(Sampler* sampler)
+{
+    int  roots[128];
+    int  numRoots = 0;
+    char path[64];
 
-        buffer[i] = low + high;
+    for (int note = 0; note < 128; note++)
+    {
+        snprintf(path, sizeof(path), SAMPLES_PATH, note);
+        FILE* file = fopen(path, "rb");
+        if (file)
+        {
+            roots[numRoots++] = note;
+            fclose(file);
+        }
     }
-    stage1_ic1eq = ic1eq;
-    stage1_ic2eq = ic2eq;
-    stage2_ic1eq = ic3eq;
-    stage2_ic2eq = ic4eq;
+    for (int i = 0; i < numRoots; i++)
+    {
+        int low  = i == 0 ? 0 : (roots[i - 1] + roots[i]) / 2 + 1;
+        int high = i == numRoots - 1 ? 127 : (roots[i] + roots[i + 1]) / 2;
+        snprintf(path, sizeof(path), SAMPLES_PATH, roots[i]);
+        sampler_add_sample(sampler, path, roots[i], low, high);
+    }
+    return sampler->numSamples;
 }
 
-// App stuff
-
 void init(void)
 {
     // init midi thread
@@ -267,11 +340,54 @@ void init(void)
     // start midi thread
     gMidiThread = thread_create(midi_cb, NULL, 0);
 
-    // init sokol-audio with default params (monophonic)
+    // The audio thread reads these from its first callback
+    load_bank();
+    gUIPreset        = gBank[0];
+    gPublishedPreset = gUIPreset;
+    // Patches point into themselves, so each buffer is built in place
+    param_triple_init(&gPatches, gPatchBuffers, sizeof(SynthPatch));
+    for (int i = 0; i < 3; i++)
+        synth_patch_build(&gSynth, &gPatchBuffers[i], &gUIPreset);
+    param_int_store(&gProgramChange, -1);
+    param_int_store(&gAudioBypass, AUDIO_ON);
+    param_int_store(&gLastNote, 0xff);
+    spsc_ring_init(&gTapRing, gTapStorage, TAP_RING_SIZE);
+
+    // Leave a core for the audio thread & one for everything else
+    int numWorkers = workpool_num_cores() - 2;
+    workpool_init(&gWorkPool, numWorkers < 3 ? numWorkers : 3);
+
+    // Synthetic room, its tail convolved on a background thread
+    {
+        const int numFrames = (int)(ROOM_IR_SECONDS * SYNTH_ENGINE_RATE);
+        float*    ir[2]     = {malloc(numFrames * sizeof(float)), malloc(numFrames * sizeof(float))};
+        if (ir[0] && ir[1])
+        {
+            reverb_generate_ir(ir, numFrames, 2, (float)SYNTH_ENGINE_RATE, ROOM_RT60);
+            gReverbReady =
+                reverb_init(&gReverb, (const float* const*)ir, numFrames, 2, (float)SYNTH_ENGINE_RATE, 1) == 0;
+        }
+        free(ir[0]);
+        free(ir[1]);
+    }
+
+    gDelayReady = delay_init(&gDelay, 2, (float)SYNTH_ENGINE_RATE, DELAY_MAX_SECONDS) == 0;
+
+    // Notes without a sample keep playing the oscillators
+    if (sampler_init(&gSampler, (float)SYNTH_ENGINE_RATE) == 0)
+        gSamplerReady = load_samples(&gSampler) > 0;
+
+    // init sokol-audio with default params (stereo output)
     saudio_setup(&(saudio_desc){
-        .stream_cb   = audio_cb,
-        .logger.func = slog_func,
+        .sample_rate  = SYNTH_ENGINE_RATE,
+        .num_channels = 2,
+        .stream_cb    = audio_cb,
+        .logger.func  = slog_func,
     });
+    // Idle workers stay awake for about one callback, so the next one doesn't have to wake them
+    workpool_set_spin(&gWorkPool, (int)(1e6 * saudio_buffer_frames() / saudio_sample_rate()));
+    gAnalyzerReady = analyzer_init(&gAnalyzer, (float)saudio_sample_rate()) == 0;
+    scope_init(&gScope);
 
     // setup sokol-gfx, sokol-time and sokol-nuklear
     sg_setup(&(sg_desc){
@@ -288,12 +404,44 @@ void init(void)
     });
 }
 
+// Moves everything the audio thread tapped since the last frame into the analyzer & scope
+static void drain_tap(void)
+{
+    static float chunk[4096];
+    const int    numChannels = saudio_channels();
+    // Blocks are written whole, so reading whole frames keeps the channels in step
+    const int maxRead = (int)(sizeof(chunk) / sizeof(chunk[0])) / numChannels * numChannels;
+    int       numRead;
+
+    while ((numRead = spsc_ring_read(&gTapRing, chunk, maxRead)) > 0)
+    {
+        if (gAnalyzerReady)
+            analyzer_push(&gAnalyzer, chunk, numRead / numChannels, numChannels);
+        scope_push(&gScope, chunk, numRead / numChannels, numChannels);
+    }
+    if (gAnalyzerReady)
+        analyzer_update(&gAnalyzer, (float)sapp_frame_duration());
+}
+
 void frame(void)
 {
     struct nk_context* ctx = snk_new_frame();
 
+    drain_tap();
+    int program = param_int_swap(&gProgramChange, -1);
+    if (program >= 0)
+        select_program(program);
     // see big function at end of file
     draw_demo_ui(ctx);
+    draw_spectrum(ctx);
+    draw_scope(ctx);
+    // Edits made this frame reach the audio thread together. The graph is compiled here, not on the audio thread
+    if (memcmp(&gUIPreset, &gPublishedPreset, sizeof(gUIPreset)) != 0)
+    {
+        gPublishedPreset = gUIPreset;
+        synth_patch_build(&gSynth, param_triple_back(&gPatches), &gUIPreset);
+        param_triple_commit(&gPatches);
+    }
 
     // the sokol_gfx draw pass
     const sg_pass_action pass_action = {
@@ -309,6 +457,11 @@ void cleanup(void)
 {
     thread_atomic_int_store(&gExitThreads, 1);
     saudio_shutdown();
+    workpool_shutdown(&gWorkPool);
+    reverb_free(&gReverb);
+    delay_free(&gDelay);
+    sampler_free(&gSampler);
+    analyzer_free(&gAnalyzer);
     thread_join(gMidiThread);
 
     // __dbgui_shutdown();
@@ -334,18 +487,132 @@ struct sapp_desc create_sapp_desc()
         .cleanup_cb                  = cleanup,
         .event_cb                    = input,
         .enable_clipboard            = true,
-        .width                       = 720,
-        .height                      = 480,
-        .window_title                = "Sine Synthesiser (Mono)",
+        .width                       = 1100,
+        .height                      = 1080,
+        .window_title                = "Sine Synthesiser (Poly)",
         .ios_keyboard_resizes_canvas = true,
         .icon.sokol_default          = true,
         .logger.func                 = slog_func,
     };
 }
 
+// Audio thread headroom. Load is callback time / the time the audio it rendered lasts
+static void draw_load_meter(struct nk_context* ctx)
+{
+    saudio_load_stats stats = saudio_query_load();
+    char              text[48];
+    nk_size           percent = (nk_size)(stats.last_load * 100.0f);
+    uint32_t          maxBin  = 1;
+
+    nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
+    {
+        nk_layout_row_push(ctx, 70);
+        nk_label(ctx, "DSP:", NK_TEXT_LEFT);
+        nk_layout_row_push(ctx, 200);
+        nk_progress(ctx, &percent, 100, nk_false);
+
+        snprintf(text, sizeof(text), "%.0f%%", stats.last_load * 100.0f);
+        nk_layout_row_push(ctx, 70);
+        nk_label(ctx, text, NK_TEXT_LEFT);
+    }
+    nk_layout_row_end(ctx);
+
+    nk_layout_row_begin(ctx, NK_STATIC, 30, 2);
+    {
+        snprintf(text, sizeof(text), "Peak: %.0f%%  Late: %u", stats.peak_load * 100.0f, stats.num_xruns);
+        nk_layout_row_push(ctx, 270);
+        nk_label(ctx, text, NK_TEXT_LEFT);
+        nk_layout_row_push(ctx, 70);
+        if (nk_button_label(ctx, "Reset"))
+            saudio_reset_load_peak();
+    }
+    nk_layout_row_end(ctx);
+
+    // Histogram of callback loads in 10% steps. The last column is late callbacks
+    for (int i = 0; i < SAUDIO_LOAD_HISTOGRAM_BINS; i++)
+        maxBin = stats.histogram[i] > maxBin ? stats.histogram[i] : maxBin;
+    nk_layout_row_dynamic(ctx, 60, 1);
+    if (nk_chart_begin(ctx, NK_CHART_COLUMN, SAUDIO_LOAD_HISTOGRAM_BINS, 0, (float)maxBin))
+    {
+        for (int i = 0; i < SAUDIO_LOAD_HISTOGRAM_BINS; i++)
+            nk_chart_push(ctx, (float)stats.histogram[i]);
+        nk_chart_end(ctx);
+    }
+}
+
+// Label, slider & value, laid out like the Volume & Cutoff rows
+static void draw_param_slider(struct nk_context* ctx, const char* label, float* value, float min, float max,
+                            const char* format)
+{
+    nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
+    {
+        nk_layout_row_push(ctx, 70);
+        nk_label(ctx, label, NK_TEXT_LEFT);
+        nk_layout_row_push(ctx, 200);
+        nk_slider_float(ctx, min, value, max, 0.00000001f);
+
+        char text[16];
+        snprintf(text, sizeof(text), format, *value);
+        nk_layout_row_push(ctx, 70);
+        nk_label(ctx, text, NK_TEXT_LEFT);
+    }
+    nk_layout_row_end(ctx);
+}
+
+// Slider for one route of the preset's mod matrix. The route is only in the matrix while its amount isn't 0, so an
+// unmodulated preset keeps the synth's fast path. It snaps to 0 near the middle of the range. A new route is dropped
+// if the matrix is full
+static void draw_mod_slider(struct nk_context* ctx, const char* label, ModSource source, ModDest dest, float max,
+                            const char* format)
+{
+    ModMatrix* mod    = &gUIPreset.mod;
+    int        slot   = 0;
+    float      amount = 0.0f;
+
+    while (slot < mod->numSlots && (mod->slots[slot].source != source || mod->slots[slot].dest != dest))
+        slot++;
+    if (slot < mod->numSlots)
+        amount = mod->slots[slot].amount;
+    draw_param_slider(ctx, label, &amount, -max, max, format);
+    if (fabsf(amount) < max * 0.02f)
+        amount = 0.0f;
+
+    if (slot == mod->numSlots)
+        modmatrix_add(mod, source, dest, amount);
+    else if (amount == 0.0f)
+        modmatrix_remove(mod, slot);
+    else
+        mod->slots[slot].amount = amount;
+}
+
+// Program number & name, stepping through the bank, & saving over the current program
+static void draw_preset_row(struct nk_context* ctx)
+{
+    char text[48];
+
+    nk_layout_row_begin(ctx, NK_STATIC, 30, 4);
+    {
+        nk_layout_row_push(ctx, 30);
+        if (nk_button_label(ctx, "<"))
+            select_program((gProgram + NUM_PROGRAMS - 1) % NUM_PROGRAMS);
+
+        snprintf(text, sizeof(text), "%d %s", gProgram, gUIPreset.name);
+        nk_layout_row_push(ctx, 200);
+        nk_label(ctx, text, NK_TEXT_CENTERED);
+
+        nk_layout_row_push(ctx, 30);
+        if (nk_button_label(ctx, ">"))
+            select_program((gProgram + 1) % NUM_PROGRAMS);
+        nk_layout_row_push(ctx, 70);
+        if (nk_button_label(ctx, "Save"))
+            save_program();
+    }
+    nk_layout_row_end(ctx);
+}
+
 static int draw_demo_ui(struct nk_context* ctx)
 {
-    if (nk_begin(ctx, "Show", nk_rect(50, 50, 380, 220), NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_CLOSABLE))
+    if (nk_begin(ctx, "Show", nk_rect(50, 50, 380, 1010), NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_CLOSABLE))
     {
         /* fixed widget pixel width */
         nk_layout_row_static(ctx, 30, 80, 1);
@@ -355,11 +622,35 @@ static int draw_demo_ui(struct nk_context* ctx)
         }
 
         /* fixed widget window ratio width */
+        int bypass = param_int_load(&gAudioBypass);
         nk_layout_row_dynamic(ctx, 30, 2);
-        if (nk_option_label(ctx, "Audio Off", gAudioBypass == AUDIO_OFF))
-            gAudioBypass = AUDIO_OFF;
-        if (nk_option_label(ctx, "Audio On", gAudioBypass == AUDIO_ON))
-            gAudioBypass = AUDIO_ON;
+        if (nk_option_label(ctx, "Audio Off", bypass == AUDIO_OFF))
+            param_int_store(&gAudioBypass, AUDIO_OFF);
+        if (nk_option_label(ctx, "Audio On", bypass == AUDIO_ON))
+            param_int_store(&gAudioBypass, AUDIO_ON);
+
+        draw_preset_row(ctx);
+
+        nk_layout_row_dynamic(ctx, 30, OSC_SHAPE_COUNT);
+        for (int i = 0; i < OSC_SHAPE_COUNT; i++)
+            if (nk_option_label(ctx, OSC_SHAPE_NAMES[i], (int)gUIPreset.shape == i))
+                gUIPreset.shape = (OscShape)i;
+
+        nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
+        {
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, "Unison:", NK_TEXT_LEFT);
+            nk_layout_row_push(ctx, 200);
+            nk_slider_int(ctx, 1, &gUIPreset.unison, SYNTH_MAX_UNISON, 1);
+
+            char text[16];
+            snprintf(text, sizeof(text), "%d", gUIPreset.unison);
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, text, NK_TEXT_LEFT);
+        }
+        nk_layout_row_end(ctx);
+        draw_param_slider(ctx, "Detune:", &gUIPreset.detune, 0.0f, PRESET_DETUNE_MAX, "%.0fct");
+        draw_param_slider(ctx, "Width:", &gUIPreset.unisonWidth, 0.0f, 1.0f, "%.2f");
 
         /* custom widget pixel width */
         nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
@@ -367,10 +658,27 @@ static int draw_demo_ui(struct nk_context* ctx)
             nk_layout_row_push(ctx, 70);
             nk_label(ctx, "Volume:", NK_TEXT_LEFT);
             nk_layout_row_push(ctx, 200);
-            nk_slider_float(ctx, -60, &gGaindB, 0.0f, 0.00000001f);
+            nk_slider_float(ctx, PRESET_GAIN_DB_MIN, &gUIPreset.gaindB, PRESET_GAIN_DB_MAX, 0.00000001f);
 
             char text[16];
-            snprintf(text, sizeof(text), "%.2fdB", gGaindB);
+            snprintf(text, sizeof(text), "%.2fdB", gUIPreset.gaindB);
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, text, NK_TEXT_LEFT);
+        }
+        nk_layout_row_end(ctx);
+
+        draw_load_meter(ctx);
+
+        nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
+        {
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, "Cutoff:", NK_TEXT_LEFT);
+            nk_layout_row_push(ctx, 200);
+            nk_slider_float(ctx, 0, &gUIPreset.cutoff, 1.0f, 0.00000001f);
+
+            char  text[16];
+            float Hz = norm_to_hz(gUIPreset.cutoff);
+            snprintf(text, sizeof(text), "%.2fHz", Hz);
             nk_layout_row_push(ctx, 70);
             nk_label(ctx, text, NK_TEXT_LEFT);
         }
@@ -381,21 +689,41 @@ static int draw_demo_ui(struct nk_context* ctx)
             nk_layout_row_push(ctx, 70);
             nk_label(ctx, "Cross:", NK_TEXT_LEFT);
             nk_layout_row_push(ctx, 200);
-            nk_slider_float(ctx, 0, &gCrossover, 1.0f, 0.00000001f);
+            nk_slider_float(ctx, 0, &gUIPreset.crossover, 1.0f, 0.00000001f);
 
             char  text[16];
-            float Hz = norm_to_hz(gCrossover);
+            float Hz = norm_to_hz(gUIPreset.crossover);
             snprintf(text, sizeof(text), "%.2fHz", Hz);
             nk_layout_row_push(ctx, 70);
             nk_label(ctx, text, NK_TEXT_LEFT);
         }
         nk_layout_row_end(ctx);
 
-        nk_layout_row_begin(ctx, NK_STATIC, 30, 1);
+        nk_layout_row_dynamic(ctx, 30, 2);
+        nk_checkbox_flags_label(ctx, "Reverb on", &gUIPreset.effects, PRESET_REVERB);
+        nk_checkbox_flags_label(ctx, "Delay on", &gUIPreset.effects, PRESET_DELAY);
+        draw_param_slider(ctx, "Reverb:", &gUIPreset.reverbWet, 0.0f, 1.0f, "%.2f");
+        draw_param_slider(ctx, "Delay:", &gUIPreset.delayMix, 0.0f, 1.0f, "%.2f");
+        nk_layout_row_dynamic(ctx, 30, DELAY_TYPE_COUNT);
+        for (int i = 0; i < DELAY_TYPE_COUNT; i++)
+            if (nk_option_label(ctx, DELAY_TYPE_NAMES[i], (int)gUIPreset.delayType == i))
+                gUIPreset.delayType = (DelayType)i;
+        draw_param_slider(ctx, "Attack:", &gUIPreset.ampEnvelope.attack, 0.0f, PRESET_ATTACK_MAX, "%.3fs");
+        draw_param_slider(ctx, "Decay:", &gUIPreset.ampEnvelope.decay, 0.0f, PRESET_DECAY_MAX, "%.3fs");
+        draw_param_slider(ctx, "Sustain:", &gUIPreset.ampEnvelope.sustain, 0.0f, 1.0f, "%.2f");
+        draw_param_slider(ctx, "Release:", &gUIPreset.ampEnvelope.release, 0.0f, PRESET_RELEASE_MAX, "%.3fs");
+        draw_param_slider(ctx, "LFO rate:", &gUIPreset.lfos[0].rateHz, PRESET_LFO_RATE_MIN, PRESET_LFO_RATE_MAX,
+                          "%.2fHz");
+        draw_mod_slider(ctx, "Vibrato:", MOD_SRC_LFO1, MOD_DST_PITCH, PRESET_MOD_PITCH_MAX, "%.2fst");
+        draw_mod_slider(ctx, "LFO cut:", MOD_SRC_LFO1, MOD_DST_CUTOFF, PRESET_MOD_CUTOFF_MAX, "%.2foct");
+        draw_mod_slider(ctx, "Env cut:", MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, PRESET_MOD_CUTOFF_MAX, "%.2foct");
+        draw_mod_slider(ctx, "Wheel cut:", MOD_SRC_MODWHEEL, MOD_DST_CUTOFF, PRESET_MOD_CUTOFF_MAX, "%.2foct");
+
+        nk_layout_row_begin(ctx, NK_STATIC, 30, 2);
         {
             static const char* midiLetters[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
             char               text[16];
-            int                midi   = gCurrentMidiNote;
+            int                midi   = param_int_load(&gLastNote);
             int                octave = (midi / 12) - 3;
             const char*        letter = midiLetters[midi % 12];
 
@@ -406,10 +734,114 @@ static int draw_demo_ui(struct nk_context* ctx)
 
             nk_layout_row_push(ctx, 70);
             nk_label(ctx, text, NK_TEXT_LEFT);
+
+            snprintf(text, sizeof(text), "Voices: %d", param_int_load(&gNumVoices));
+            nk_layout_row_push(ctx, 100);
+            nk_label(ctx, text, NK_TEXT_LEFT);
         }
         nk_layout_row_end(ctx);
     }
     nk_end(ctx);
 
     return ! nk_window_is_closed(ctx, "Overview");
-}
\ No newline at end of file
+}
+
+// Log frequency spectrum of the output, one polyline per frame
+static void draw_spectrum(struct nk_context* ctx)
+{
+    static const float gridHz[]    = {100.0f, 1000.0f, 10000.0f};
+    static const char* gridNames[] = {"100", "1k", "10k"};
+    static float       points[2 * ANALYZER_MAX_POINTS];
+
+    if (nk_begin(ctx, "Spectrum", nk_rect(450, 50, 600, 300), NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE))
+    {
+        struct nk_command_buffer* canvas = nk_window_get_canvas(ctx);
+        struct nk_rect            bounds;
+
+        nk_layout_row_dynamic(ctx, 250, 1);
+        if (gAnalyzerReady && nk_widget(&bounds, ctx) != NK_WIDGET_INVALID)
+        {
+            int numPoints = (int)bounds.w < ANALYZER_MAX_POINTS ? (int)bounds.w : ANALYZER_MAX_POINTS;
+
+            nk_fill_rect(canvas, bounds, 0, nk_rgb(20, 24, 32));
+            // Every 30dB, then the decades
+            for (float db = -30.0f; db > ANALYZER_MIN_DB; db -= 30.0f)
+            {
+                float y = bounds.y + bounds.h * db / ANALYZER_MIN_DB;
+                nk_stroke_line(canvas, bounds.x, y, bounds.x + bounds.w, y, 1.0f, nk_rgb(50, 56, 70));
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                float          x     = bounds.x + bounds.w * analyzer_hz_to_x(&gAnalyzer, gridHz[i]);
+                struct nk_rect label = nk_rect(x + 3, bounds.y + bounds.h - 18, 40, 16);
+                nk_stroke_line(canvas, x, bounds.y, x, bounds.y + bounds.h, 1.0f, nk_rgb(50, 56, 70));
+                nk_draw_text(canvas, label, gridNames[i], (int)strlen(gridNames[i]), ctx->style.font,
+                             nk_rgb(20, 24, 32), nk_rgb(120, 128, 144));
+            }
+
+            analyzer_plot(&gAnalyzer, points, numPoints, bounds.x, bounds.y, bounds.w, bounds.h);
+            nk_stroke_polyline(canvas, points, numPoints, 1.0f, nk_rgb(130, 220, 140));
+        }
+    }
+    nk_end(ctx);
+}
+
+// Waveform of the last few seconds of output, one vertical line per pixel column
+static void draw_scope(struct nk_context* ctx)
+{
+    static const int minSamples = 64;
+    static float     mins[SCOPE_MAX_COLUMNS];
+    static float     maxs[SCOPE_MAX_COLUMNS];
+    static float     zoom = 0.5f; // 0 shows minSamples, 1 the whole history
+
+    if (nk_begin(ctx, "Scope", nk_rect(450, 370, 600, 330), NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE))
+    {
+        struct nk_command_buffer* canvas = nk_window_get_canvas(ctx);
+        struct nk_rect            bounds;
+        const float               octaves    = log2f((float)SCOPE_HISTORY / (float)minSamples);
+        const int                 numSamples = (int)((float)minSamples * exp2f(zoom * octaves));
+
+        nk_layout_row_dynamic(ctx, 250, 1);
+        if (nk_widget(&bounds, ctx) != NK_WIDGET_INVALID)
+        {
+            int   numColumns = (int)bounds.w < SCOPE_MAX_COLUMNS ? (int)bounds.w : SCOPE_MAX_COLUMNS;
+            float mid        = bounds.y + 0.5f * bounds.h;
+
+            nk_fill_rect(canvas, bounds, 0, nk_rgb(20, 24, 32));
+            nk_stroke_line(canvas, bounds.x, mid, bounds.x + bounds.w, mid, 1.0f, nk_rgb(50, 56, 70));
+            if (numColumns > 0)
+            {
+                scope_view(&gScope, numSamples, mins, maxs, numColumns);
+                for (int c = 0; c < numColumns; c++)
+                {
+                    float lo  = mins[c] > -1.0f ? mins[c] : -1.0f;
+                    float hi  = maxs[c] < 1.0f ? maxs[c] : 1.0f;
+                    float x   = bounds.x + (float)c + 0.5f;
+                    float top = mid - 0.5f * bounds.h * hi;
+                    float bot = mid - 0.5f * bounds.h * lo;
+                    // Flat stretches still get a pixel
+                    bot = bot > top + 1.0f ? bot : top + 1.0f;
+                    nk_stroke_line(canvas, x, top, x, bot, 1.0f, nk_rgb(130, 220, 140));
+                }
+            }
+        }
+
+        char  text[16];
+        float seconds = (float)numSamples / (float)saudio_sample_rate();
+        if (seconds < 1.0f)
+            snprintf(text, sizeof(text), "%.0f ms", seconds * 1000.0f);
+        else
+            snprintf(text, sizeof(text), "%.1f s", seconds);
+        nk_layout_row_begin(ctx, NK_STATIC, 30, 3);
+        {
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, "Span", NK_TEXT_LEFT);
+            nk_layout_row_push(ctx, 200);
+            nk_slider_float(ctx, 0, &zoom, 1.0f, 0.00000001f);
+            nk_layout_row_push(ctx, 70);
+            nk_label(ctx, text, NK_TEXT_LEFT);
+        }
+        nk_layout_row_end(ctx);
+    }
+    nk_end(ctx);
+}
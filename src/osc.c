@@ -0,0 +1,182 @@
+#include "osc.h"
+
+#include <math.h>
+
+const char* const OSC_SHAPE_NAMES[OSC_SHAPE_COUNT] = {"Saw", "Square", "Triangle"};
+
+// Inactive voices have an increment of 0. Keeping dt above 0 avoids 0 * inf in the lanes we throw away
+#define OSC_MIN_INC 1e-7f
+
+// https://www.kvraudio.com/forum/viewtopic.php?t=375517
+static inline float osc_polyblep(float t, float dt)
+{
+    if (t < dt)
+    {
+        t /= dt;
+        return t + t - t * t - 1.0f;
+    }
+    else if (t > 1.0f - dt)
+    {
+        t = (t - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
+    }
+    return 0.0f;
+}
+
+// Esqueda, Välimäki, Bilbao - Rounding Corners with BLAMP (DAFx 2016)
+static inline float osc_polyblamp(float t, float dt)
+{
+    if (t < dt)
+    {
+        t = 1.0f - t / dt;
+        return t * t * t * (1.0f / 3.0f);
+    }
+    else if (t > 1.0f - dt)
+    {
+        t = (t - 1.0f) / dt + 1.0f;
+        return t * t * t * (1.0f / 3.0f);
+    }
+    return 0.0f;
+}
+
+static inline float osc_wrap(float t) { return t - (int)t; }
+
+void osc_render_scalar(OscShape shape, float* phase, float inc, float pulseWidth, float* out, int numFrames)
+{
+    float t  = *phase;
+    float dt = inc > OSC_MIN_INC ? inc : OSC_MIN_INC;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        float sample;
+        switch (shape)
+        {
+        case OSC_SAW:
+            sample = 2.0f * t - 1.0f - osc_polyblep(t, dt);
+            break;
+        case OSC_SQUARE:
+            sample = t < pulseWidth ? 1.0f : -1.0f;
+            sample += osc_polyblep(t, dt);
+            sample -= osc_polyblep(osc_wrap(t + 1.0f - pulseWidth), dt);
+            break;
+        case OSC_TRIANGLE:
+        default:
+            sample = 1.0f - 4.0f * fabsf(t - 0.5f);
+            sample += 4.0f * dt * (osc_polyblamp(t, dt) - osc_polyblamp(osc_wrap(t + 0.5f), dt));
+            break;
+        }
+        out[i] = sample;
+        t      = osc_wrap(t + inc);
+    }
+    *phase = t;
+}
+
+// Branch free versions of the above. Both sides of each edge are computed and the right one is selected per lane
+
+// Returns the distance into the BLEP window either side of the step, normalised to 0-1, or 0 outside the window
+SIMD_INLINE simd_f osc_blep_x(simd_f t, simd_f dt, simd_f invDt, simd_f one)
+{
+    simd_f before = simd_mul(simd_sub(simd_add(t, dt), one), invDt); // t > 1 - dt
+    simd_f after  = simd_sub(one, simd_mul(t, invDt));                // t < dt
+    simd_f x      = simd_select(simd_cmplt(t, dt), after, simd_set1(0.0f));
+    return simd_select(simd_cmplt(simd_sub(one, dt), t), before, x);
+}
+
+SIMD_INLINE simd_f osc_polyblep_lanes(simd_f t, simd_f dt, simd_f invDt, simd_f one)
+{
+    // -(1 - t/dt)^2 after the step, ((t - 1)/dt + 1)^2 before it
+    simd_f before = simd_mul(simd_sub(simd_add(t, dt), one), invDt);
+    simd_f after  = simd_sub(one, simd_mul(t, invDt));
+    simd_f zero   = simd_set1(0.0f);
+    simd_f x      = simd_select(simd_cmplt(t, dt), simd_sub(zero, simd_mul(after, after)), zero);
+    return simd_select(simd_cmplt(simd_sub(one, dt), t), simd_mul(before, before), x);
+}
+
+SIMD_INLINE simd_f osc_polyblamp_lanes(simd_f t, simd_f dt, simd_f invDt, simd_f one)
+{
+    simd_f x = osc_blep_x(t, dt, invDt, one);
+    return simd_mul(simd_mul(x, simd_mul(x, x)), simd_set1(1.0f / 3.0f));
+}
+
+SIMD_INLINE simd_f osc_wrap_lanes(simd_f t) { return simd_sub(t, simd_trunc(t)); }
+
+// With 'glide', the increment ramps linearly to incTarget. The BLEP width stays at the starting increment,
+// which is close enough for the small steps made each control period
+SIMD_INLINE void osc_render_lanes_impl(OscShape shape, float* phase, float* inc, const float* incTarget,
+                                       float pulseWidth, float* out, int numFrames, int glide)
+{
+    const simd_f one   = simd_set1(1.0f);
+    const simd_f two   = simd_set1(2.0f);
+    simd_f       t     = simd_load(phase);
+    simd_f       dinc  = simd_load(inc);
+    simd_f       dt    = simd_max(dinc, simd_set1(OSC_MIN_INC));
+    simd_f       invDt = simd_div(one, dt);
+    simd_f       step  = simd_set1(0.0f);
+
+    if (glide && numFrames > 0)
+        step = simd_mul(simd_sub(simd_load(incTarget), dinc), simd_set1(1.0f / (float)numFrames));
+
+    switch (shape)
+    {
+    case OSC_SAW:
+        for (int i = 0; i < numFrames; i++)
+        {
+            simd_f sample = simd_sub(simd_fmadd(two, t, simd_set1(-1.0f)), osc_polyblep_lanes(t, dt, invDt, one));
+            simd_store(out + i * SIMD_WIDTH, sample);
+            t = osc_wrap_lanes(simd_add(t, dinc));
+            if (glide)
+                dinc = simd_add(dinc, step);
+        }
+        break;
+    case OSC_SQUARE:
+    {
+        const simd_f pw      = simd_set1(pulseWidth);
+        const simd_f fallOff = simd_set1(1.0f - pulseWidth);
+        for (int i = 0; i < numFrames; i++)
+        {
+            simd_f sample = simd_select(simd_cmplt(t, pw), one, simd_set1(-1.0f));
+            simd_f fall   = osc_wrap_lanes(simd_add(t, fallOff));
+            sample        = simd_add(sample, osc_polyblep_lanes(t, dt, invDt, one));
+            sample        = simd_sub(sample, osc_polyblep_lanes(fall, dt, invDt, one));
+            simd_store(out + i * SIMD_WIDTH, sample);
+            t = osc_wrap_lanes(simd_add(t, dinc));
+            if (glide)
+                dinc = simd_add(dinc, step);
+        }
+        break;
+    }
+    case OSC_TRIANGLE:
+    default:
+    {
+        const simd_f half      = simd_set1(0.5f);
+        const simd_f minusFour = simd_set1(-4.0f);
+        const simd_f scale     = simd_mul(simd_set1(4.0f), dt);
+        for (int i = 0; i < numFrames; i++)
+        {
+            simd_f sample = simd_fmadd(minusFour, simd_abs(simd_sub(t, half)), one);
+            simd_f peak   = osc_wrap_lanes(simd_add(t, half));
+            simd_f blamp  = simd_sub(osc_polyblamp_lanes(t, dt, invDt, one), osc_polyblamp_lanes(peak, dt, invDt, one));
+            sample        = simd_fmadd(scale, blamp, sample);
+            simd_store(out + i * SIMD_WIDTH, sample);
+            t = osc_wrap_lanes(simd_add(t, dinc));
+            if (glide)
+                dinc = simd_add(dinc, step);
+        }
+        break;
+    }
+    }
+    simd_store(phase, t);
+    if (glide)
+        simd_store(inc, simd_load(incTarget));
+}
+
+void osc_render_lanes(OscShape shape, float* phase, const float* inc, float pulseWidth, float* out, int numFrames)
+{
+    osc_render_lanes_impl(shape, phase, (float*)inc, inc, pulseWidth, out, numFrames, 0);
+}
+
+void osc_render_lanes_glide(OscShape shape, float* phase, float* inc, const float* incTarget, float pulseWidth,
+                            float* out, int numFrames)
+{
+    osc_render_lanes_impl(shape, phase, inc, incTarget, pulseWidth, out, numFrames, 1);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "simd.h"
+
+// Band-limited oscillators.
+// Saw & pulse use PolyBLEP to smooth their steps, triangle uses PolyBLAMP to smooth its corners.
+// Phase is 0-1, increment is Hz / sampleRate and must stay below 0.5 (Nyquist)
+
+typedef enum OscShape
+{
+    OSC_SAW,
+    OSC_SQUARE, // pulse with variable width, 0.5 is square
+    OSC_TRIANGLE,
+    OSC_SHAPE_COUNT,
+} OscShape;
+
+extern const char* const OSC_SHAPE_NAMES[OSC_SHAPE_COUNT];
+
+// Reference kernel. Renders one oscillator, writing numFrames samples to 'out'
+void osc_render_scalar(OscShape shape, float* phase, float inc, float pulseWidth, float* out, int numFrames);
+
+// Renders SIMD_WIDTH oscillators at once, one per lane.
+// 'phase' & 'inc' point to SIMD_WIDTH floats, 32 byte aligned.
+// Output is lane interleaved: out[frame * SIMD_WIDTH + lane]
+void osc_render_lanes(OscShape shape, float* phase, const float* inc, float pulseWidth, float* out, int numFrames);
+// Same, with the increment gliding linearly from 'inc' to 'incTarget' across the block. 'inc' is left at the target
+void osc_render_lanes_glide(OscShape shape, float* phase, float* inc, const float* incTarget, float pulseWidth,
+                            float* out, int numFrames);
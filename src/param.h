@@ -0,0 +1,94 @@
+#pragma once
+#include "fastmath.h"
+
+#include <math.h>
+
+// Parameter helpers shared by the UI & audio thread.
+// The audio thread keeps the last source value of each parameter and only recomputes derived values (gains,
+// filter coefficients) when it changes. Changes are ramped linearly across the block to avoid zipper noise,
+// so the steady state costs a compare per parameter.
+
+static inline float gain_to_db(float g) { return fast_gain_to_db(g); }
+// One value at a time, libm's exp2f is as fast as fast_exp2(). See fastmath.h
+static inline float db_to_gain(float db) { return exp2f(db * FAST_LOG2_10_OVER_20); }
+static inline float norm_to_hz(float norm) { return 20 * exp2f(norm * 10); }
+
+// Returns 1 if 'value' differs from the cached source value, updating the cache
+static inline int param_changed(float* cached, float value)
+{
+    if (*cached == value)
+        return 0;
+    *cached = value;
+    return 1;
+}
+
+typedef struct SmoothedValue
+{
+    float current;
+    float target;
+    float step;
+    int   framesLeft;
+} SmoothedValue;
+
+static inline void smoothed_reset(SmoothedValue* s, float value)
+{
+    s->current    = value;
+    s->target     = value;
+    s->step       = 0;
+    s->framesLeft = 0;
+}
+
+static inline void smoothed_set_target(SmoothedValue* s, float target, int rampFrames)
+{
+    if (rampFrames <= 0)
+    {
+        smoothed_reset(s, target);
+        return;
+    }
+    s->target     = target;
+    s->step       = (target - s->current) / (float)rampFrames;
+    s->framesLeft = rampFrames;
+}
+
+static inline int smoothed_is_ramping(const SmoothedValue* s) { return s->framesLeft > 0; }
+
+// Advances the ramp by numFrames and returns the value reached
+static inline float smoothed_skip(SmoothedValue* s, int numFrames)
+{
+    if (numFrames >= s->framesLeft)
+    {
+        s->current    = s->target;
+        s->framesLeft = 0;
+    }
+    else
+    {
+        s->current    += s->step * (float)numFrames;
+        s->framesLeft -= numFrames;
+    }
+    return s->current;
+}
+
+// Multiplies 'buf' by the value, ramping where needed
+static inline void smoothed_apply_gain(SmoothedValue* s, float* buf, int numFrames)
+{
+    int   i = 0;
+    float g = s->current;
+    for (; i < numFrames && s->framesLeft > 0; i++, s->framesLeft--)
+    {
+        g      += s->step;
+        buf[i] *= g;
+    }
+    if (s->framesLeft == 0)
+        g = s->target;
+    for (; i < numFrames; i++)
+        buf[i] *= g;
+    s->current = g;
+}
+
+// Writes the value at each frame to 'buf', ramping where needed
+static inline void smoothed_render(SmoothedValue* s, float* buf, int numFrames)
+{
+    for (int i = 0; i < numFrames; i++)
+        buf[i] = 1.0f;
+    smoothed_apply_gain(s, buf, numFrames);
+}
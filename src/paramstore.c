@@ -0,0 +1,32 @@
+#include "paramstore.h"
+
+#define PARAM_TRIPLE_NEW 4
+
+int  param_int_load(ParamInt* slot) { return thread_atomic_int_load(&slot->value); }
+void param_int_store(ParamInt* slot, int value) { thread_atomic_int_store(&slot->value, value); }
+int  param_int_swap(ParamInt* slot, int value) { return thread_atomic_int_swap(&slot->value, value); }
+
+void param_triple_init(ParamTripleBuffer* tb, void* storage, size_t size)
+{
+    for (int i = 0; i < 3; i++)
+        tb->buffers[i] = (char*)storage + i * size;
+    tb->back  = 0;
+    tb->front = 2;
+    thread_atomic_int_store(&tb->middle, 1);
+}
+
+void* param_triple_back(ParamTripleBuffer* tb) { return tb->buffers[tb->back]; }
+
+void param_triple_commit(ParamTripleBuffer* tb)
+{
+    // The swap is the commit. We get back whichever buffer the reader isn't using
+    tb->back = thread_atomic_int_swap(&tb->middle, tb->back | PARAM_TRIPLE_NEW) & ~PARAM_TRIPLE_NEW;
+}
+
+const void* param_triple_acquire(ParamTripleBuffer* tb)
+{
+    // Without a new commit we keep reading the buffer we already have
+    if (thread_atomic_int_load(&tb->middle) & PARAM_TRIPLE_NEW)
+        tb->front = thread_atomic_int_swap(&tb->middle, tb->front) & ~PARAM_TRIPLE_NEW;
+    return tb->buffers[tb->front];
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "thread.h"
+
+#include <stddef.h>
+
+// Lock free parameter exchange between the UI & audio thread, built on the atomics in thread.h.
+// Neither side ever blocks or allocates.
+// Single values go through typed atomic slots. Parameters that must change together go through a triple buffer:
+// the UI writes a whole set and commits it with one atomic swap. At the start of each block the audio thread picks
+// up the newest committed set, and never sees a half written one.
+
+typedef struct ParamInt
+{
+    thread_atomic_int_t value;
+} ParamInt;
+
+int  param_int_load(ParamInt* slot);
+void param_int_store(ParamInt* slot, int value);
+// Stores 'value' & returns the one it replaced, so a value posted by one thread is taken by the other exactly once
+int  param_int_swap(ParamInt* slot, int value);
+
+// One writer, one reader. The writer owns 'back', the reader owns 'front', and they trade buffers through 'middle'
+typedef struct ParamTripleBuffer
+{
+    char*               buffers[3];
+    thread_atomic_int_t middle; // index of the shared buffer, plus PARAM_TRIPLE_NEW while it holds an unread commit
+    int                 back;
+    int                 front;
+} ParamTripleBuffer;
+
+// 'storage' holds 3 * size bytes. Call before either thread starts, then build all three of 'buffers' in place.
+// Sets are never copied, so they can point into themselves
+void param_triple_init(ParamTripleBuffer* tb, void* storage, size_t size);
+// Writer. Fill the buffer param_triple_back() returns, then commit it to make it visible to the reader. It's the
+// writer's until then, & the reader never sees it half built
+void* param_triple_back(ParamTripleBuffer* tb);
+void  param_triple_commit(ParamTripleBuffer* tb);
+// Reader. Returns the newest committed set. It stays valid until the next call
+const void* param_triple_acquire(ParamTripleBuffer* tb);
@@ -0,0 +1,313 @@
+#include "preset.h"
+#include "synth.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+void preset_factory(SynthPreset* preset, int index)
+{
+    memset(preset, 0, sizeof(*preset));
+    // Index 0, the same as a fresh synth. The others start from it
+    snprintf(preset->name, sizeof(preset->name), "Init");
+    preset->shape       = OSC_SQUARE;
+    preset->gaindB      = -12.0f;
+    preset->cutoff      = 1.0f;
+    preset->crossover   = 0.5f;
+    preset->ampEnvelope = (AdsrParams){.attack = 0.005f, .decay = 0.3f, .sustain = 0.7f, .release = 0.2f};
+    preset->unison      = 1;
+    preset->detune      = 25.0f;
+    preset->unisonWidth = 0.7f;
+    preset->lfos[0]     = (Lfo){.shape = LFO_SINE, .rateHz = 5.0f};
+    preset->lfos[1]     = (Lfo){.shape = LFO_TRIANGLE, .rateHz = 0.5f};
+    preset->envelope    = (ModEnvelope){.attack = 0.005f, .decay = 0.3f, .sustain = 0.3f, .release = 0.2f};
+    preset->effects     = PRESET_REVERB;
+    preset->delayType   = DELAY_CHORUS;
+    preset->delayMix    = 0.3f;
+    preset->reverbWet   = 0.2f;
+
+    switch (index)
+    {
+    case 1:
+        snprintf(preset->name, sizeof(preset->name), "Vibrato lead");
+        preset->shape       = OSC_SAW;
+        preset->gaindB      = -14.0f;
+        preset->cutoff      = 0.75f;
+        preset->ampEnvelope = (AdsrParams){.attack = 0.01f, .decay = 0.2f, .sustain = 0.8f, .release = 0.3f};
+        preset->effects     = PRESET_DELAY | PRESET_REVERB;
+        preset->delayType   = DELAY_ECHO;
+        preset->delayMix    = 0.25f;
+        preset->reverbWet   = 0.15f;
+        modmatrix_add(&preset->mod, MOD_SRC_LFO1, MOD_DST_PITCH, 0.15f);
+        modmatrix_add(&preset->mod, MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, 1.5f);
+        modmatrix_add(&preset->mod, MOD_SRC_MODWHEEL, MOD_DST_CUTOFF, 2.0f);
+        break;
+    case 2:
+        snprintf(preset->name, sizeof(preset->name), "Chorus pad");
+        preset->shape       = OSC_SAW;
+        preset->gaindB      = -16.0f;
+        preset->cutoff      = 0.6f;
+        preset->ampEnvelope = (AdsrParams){.attack = 0.8f, .decay = 1.0f, .sustain = 0.8f, .release = 1.5f};
+        preset->lfos[1]     = (Lfo){.shape = LFO_TRIANGLE, .rateHz = 0.3f};
+        preset->envelope    = (ModEnvelope){.attack = 0.6f, .decay = 1.0f, .sustain = 0.5f, .release = 1.2f};
+        preset->effects     = PRESET_DELAY | PRESET_REVERB;
+        preset->delayType   = DELAY_CHORUS;
+        preset->delayMix    = 0.6f;
+        preset->reverbWet   = 0.45f;
+        modmatrix_add(&preset->mod, MOD_SRC_LFO2, MOD_DST_CUTOFF, 0.5f);
+        modmatrix_add(&preset->mod, MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, 1.0f);
+        break;
+    case 3:
+        snprintf(preset->name, sizeof(preset->name), "Flanged pluck");
+        preset->cutoff      = 0.45f;
+        preset->ampEnvelope = (AdsrParams){.attack = 0.002f, .decay = 0.4f, .sustain = 0.0f, .release = 0.3f};
+        preset->envelope    = (ModEnvelope){.attack = 0.001f, .decay = 0.25f, .sustain = 0.0f, .release = 0.2f};
+        preset->effects     = PRESET_DELAY | PRESET_REVERB;
+        preset->delayType   = DELAY_FLANGER;
+        preset->delayMix    = 0.5f;
+        preset->reverbWet   = 0.25f;
+        modmatrix_add(&preset->mod, MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, 3.0f);
+        modmatrix_add(&preset->mod, MOD_SRC_VELOCITY, MOD_DST_GAIN, 6.0f);
+        break;
+    case 4:
+        snprintf(preset->name, sizeof(preset->name), "Supersaw");
+        preset->shape       = OSC_SAW;
+        preset->gaindB      = -14.0f;
+        preset->cutoff      = 0.85f;
+        preset->ampEnvelope = (AdsrParams){.attack = 0.01f, .decay = 0.5f, .sustain = 0.8f, .release = 0.4f};
+        preset->unison      = 16;
+        preset->detune      = 30.0f;
+        preset->unisonWidth = 0.8f;
+        preset->reverbWet   = 0.3f;
+        modmatrix_add(&preset->mod, MOD_SRC_MODWHEEL, MOD_DST_CUTOFF, 1.0f);
+        break;
+    }
+}
+
+// Encoding. PRESET_MAX_BYTES covers the largest preset, so writes aren't checked
+static void put_u8(uint8_t* data, int* pos, unsigned value) { data[(*pos)++] = (uint8_t)value; }
+
+static void put_f32(uint8_t* data, int* pos, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; i++)
+        data[(*pos)++] = (uint8_t)(bits >> (8 * i));
+}
+
+int preset_encode(const SynthPreset* preset, uint8_t* data)
+{
+    int nameSize = (int)strnlen(preset->name, PRESET_NAME_SIZE - 1);
+    int pos      = 0;
+
+    memcpy(data, PRESET_MAGIC, 4);
+    pos += 4;
+    put_u8(data, &pos, PRESET_VERSION);
+    put_u8(data, &pos, nameSize);
+    memcpy(data + pos, preset->name, nameSize);
+    pos += nameSize;
+
+    put_u8(data, &pos, preset->shape);
+    put_f32(data, &pos, preset->gaindB);
+    put_f32(data, &pos, preset->cutoff);
+    put_f32(data, &pos, preset->crossover);
+    put_f32(data, &pos, preset->ampEnvelope.attack);
+    put_f32(data, &pos, preset->ampEnvelope.decay);
+    put_f32(data, &pos, preset->ampEnvelope.sustain);
+    put_f32(data, &pos, preset->ampEnvelope.release);
+
+    for (int i = 0; i < MOD_NUM_LFOS; i++)
+    {
+        put_u8(data, &pos, preset->lfos[i].shape);
+        put_f32(data, &pos, preset->lfos[i].rateHz);
+    }
+    put_f32(data, &pos, preset->envelope.attack);
+    put_f32(data, &pos, preset->envelope.decay);
+    put_f32(data, &pos, preset->envelope.sustain);
+    put_f32(data, &pos, preset->envelope.release);
+    put_u8(data, &pos, preset->mod.numSlots);
+    for (int i = 0; i < preset->mod.numSlots; i++)
+    {
+        put_u8(data, &pos, preset->mod.slots[i].source);
+        put_u8(data, &pos, preset->mod.slots[i].dest);
+        put_f32(data, &pos, preset->mod.slots[i].amount);
+    }
+
+    put_u8(data, &pos, preset->effects);
+    put_u8(data, &pos, preset->delayType);
+    put_f32(data, &pos, preset->delayMix);
+    put_f32(data, &pos, preset->reverbWet);
+    // Version 2
+    put_u8(data, &pos, preset->unison);
+    put_f32(data, &pos, preset->detune);
+    put_f32(data, &pos, preset->unisonWidth);
+    return pos;
+}
+
+// Decoding. Reads past the end, out of range enums & non finite floats set 'error' & return 0
+typedef struct PresetReader
+{
+    const uint8_t* data;
+    int            size;
+    int            pos;
+    int            error;
+} PresetReader;
+
+static unsigned get_u8(PresetReader* r)
+{
+    if (r->pos + 1 > r->size)
+    {
+        r->error = 1;
+        return 0;
+    }
+    return r->data[r->pos++];
+}
+
+static unsigned get_enum(PresetReader* r, unsigned count)
+{
+    unsigned value = get_u8(r);
+    if (value < count)
+        return value;
+    r->error = 1;
+    return 0;
+}
+
+static float get_f32(PresetReader* r)
+{
+    uint32_t bits = 0;
+    float    value;
+
+    if (r->pos + 4 > r->size)
+    {
+        r->error = 1;
+        return 0;
+    }
+    for (int i = 0; i < 4; i++)
+        bits |= (uint32_t)r->data[r->pos++] << (8 * i);
+    memcpy(&value, &bits, sizeof(value));
+    if (isfinite(value))
+        return value;
+    r->error = 1;
+    return 0;
+}
+
+static float clamp(float x, float min, float max) { return x < min ? min : x > max ? max : x; }
+
+static void preset_clamp(SynthPreset* p)
+{
+    static const float modAmountMax[MOD_DST_COUNT] = {PRESET_MOD_PITCH_MAX, PRESET_MOD_CUTOFF_MAX,
+                                                      PRESET_MOD_GAIN_MAX};
+
+    p->gaindB              = clamp(p->gaindB, PRESET_GAIN_DB_MIN, PRESET_GAIN_DB_MAX);
+    p->cutoff              = clamp(p->cutoff, 0.0f, 1.0f);
+    p->crossover           = clamp(p->crossover, 0.0f, 1.0f);
+    p->ampEnvelope.attack  = clamp(p->ampEnvelope.attack, 0.0f, PRESET_ATTACK_MAX);
+    p->ampEnvelope.decay   = clamp(p->ampEnvelope.decay, 0.0f, PRESET_DECAY_MAX);
+    p->ampEnvelope.sustain = clamp(p->ampEnvelope.sustain, 0.0f, 1.0f);
+    p->ampEnvelope.release = clamp(p->ampEnvelope.release, 0.0f, PRESET_RELEASE_MAX);
+    p->detune              = clamp(p->detune, 0.0f, PRESET_DETUNE_MAX);
+    p->unisonWidth         = clamp(p->unisonWidth, 0.0f, 1.0f);
+    for (int i = 0; i < MOD_NUM_LFOS; i++)
+        p->lfos[i].rateHz = clamp(p->lfos[i].rateHz, PRESET_LFO_RATE_MIN, PRESET_LFO_RATE_MAX);
+    p->envelope.attack  = clamp(p->envelope.attack, 0.0f, PRESET_ATTACK_MAX);
+    p->envelope.decay   = clamp(p->envelope.decay, 0.0f, PRESET_DECAY_MAX);
+    p->envelope.sustain = clamp(p->envelope.sustain, 0.0f, 1.0f);
+    p->envelope.release = clamp(p->envelope.release, 0.0f, PRESET_RELEASE_MAX);
+    for (int i = 0; i < p->mod.numSlots; i++)
+    {
+        float max              = modAmountMax[p->mod.slots[i].dest];
+        p->mod.slots[i].amount = clamp(p->mod.slots[i].amount, -max, max);
+    }
+    p->delayMix  = clamp(p->delayMix, 0.0f, 1.0f);
+    p->reverbWet = clamp(p->reverbWet, 0.0f, 1.0f);
+}
+
+int preset_decode(SynthPreset* preset, const uint8_t* data, int size)
+{
+    PresetReader r = {data, size, 0, 0};
+    SynthPreset  p;
+    unsigned     nameSize;
+    int          numSlots;
+
+    if (size < 6 || memcmp(data, PRESET_MAGIC, 4) != 0 || data[4] < 1 || data[4] > PRESET_VERSION)
+        return 1;
+    // Defaults for what older versions don't have
+    preset_factory(&p, 0);
+    r.pos    = 5;
+    nameSize = get_u8(&r);
+    if (nameSize >= PRESET_NAME_SIZE || r.pos + (int)nameSize > size)
+        return 1;
+    memcpy(p.name, data + r.pos, nameSize);
+    r.pos += nameSize;
+
+    p.shape               = (OscShape)get_enum(&r, OSC_SHAPE_COUNT);
+    p.gaindB              = get_f32(&r);
+    p.cutoff              = get_f32(&r);
+    p.crossover           = get_f32(&r);
+    p.ampEnvelope.attack  = get_f32(&r);
+    p.ampEnvelope.decay   = get_f32(&r);
+    p.ampEnvelope.sustain = get_f32(&r);
+    p.ampEnvelope.release = get_f32(&r);
+
+    for (int i = 0; i < MOD_NUM_LFOS; i++)
+    {
+        p.lfos[i].shape  = (LfoShape)get_enum(&r, LFO_SHAPE_COUNT);
+        p.lfos[i].rateHz = get_f32(&r);
+    }
+    p.envelope.attack  = get_f32(&r);
+    p.envelope.decay   = get_f32(&r);
+    p.envelope.sustain = get_f32(&r);
+    p.envelope.release = get_f32(&r);
+    numSlots           = (int)get_enum(&r, MOD_MAX_SLOTS + 1);
+    // Through modmatrix_add, so routes with no amount don't cost the synth its unmodulated path
+    modmatrix_clear(&p.mod);
+    for (int i = 0; i < numSlots; i++)
+    {
+        ModSource source = (ModSource)get_enum(&r, MOD_SRC_COUNT);
+        ModDest   dest   = (ModDest)get_enum(&r, MOD_DST_COUNT);
+        modmatrix_add(&p.mod, source, dest, get_f32(&r));
+    }
+
+    p.effects   = get_u8(&r) & (PRESET_DELAY | PRESET_REVERB);
+    p.delayType = (DelayType)get_enum(&r, DELAY_TYPE_COUNT);
+    p.delayMix  = get_f32(&r);
+    p.reverbWet = get_f32(&r);
+    if (data[4] >= 2)
+    {
+        p.unison      = (int)get_enum(&r, SYNTH_MAX_UNISON + 1);
+        p.detune      = get_f32(&r);
+        p.unisonWidth = get_f32(&r);
+    }
+    if (r.error || p.unison < 1)
+        return 1;
+    preset_clamp(&p);
+    *preset = p;
+    return 0;
+}
+
+int preset_save(const SynthPreset* preset, const char* path)
+{
+    uint8_t data[PRESET_MAX_BYTES];
+    int     size = preset_encode(preset, data);
+    FILE*   file = fopen(path, "wb");
+    int     error;
+
+    if (! file)
+        return 1;
+    error = fwrite(data, 1, size, file) != (size_t)size;
+    error |= fclose(file) != 0;
+    return error;
+}
+
+int preset_load(SynthPreset* preset, const char* path)
+{
+    uint8_t data[PRESET_MAX_BYTES];
+    FILE*   file = fopen(path, "rb");
+    int     size;
+
+    if (! file)
+        return 1;
+    size = (int)fread(data, 1, sizeof(data), file);
+    fclose(file);
+    return preset_decode(preset, data, size);
+}
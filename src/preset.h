@@ -0,0 +1,75 @@
+#pragma once
+#include "adsr.h"
+#include "delay.h"
+#include "modulation.h"
+#include "osc.h"
+
+#include <stdint.h>
+
+// Everything the player sets on the synth: parameters, modulation routing & which effects are in the graph.
+// Presets are saved as compact little endian blobs of at most PRESET_MAX_BYTES: a magic, a version byte, the name
+// as a length byte & its chars, then every field in struct order, enums as a byte & floats as their bit pattern.
+// The mod matrix only stores the slots it uses. Fields added by later versions go at the end, & older presets load
+// with their defaults.
+
+#define PRESET_MAGIC "SYNP"
+#define PRESET_VERSION 2
+#define PRESET_NAME_SIZE 32
+#define PRESET_MAX_BYTES 256
+#define PRESET_NUM_FACTORY 5
+
+// Ranges of the fields that aren't 0-1, as the UI's sliders allow. Loaded presets are clamped to them, so a file
+// can't hand the audio thread values it would turn into NaN or infinity
+#define PRESET_GAIN_DB_MIN -60.0f
+#define PRESET_GAIN_DB_MAX 0.0f
+#define PRESET_ATTACK_MAX 2.0f // seconds, both envelopes
+#define PRESET_DECAY_MAX 2.0f
+#define PRESET_RELEASE_MAX 4.0f
+#define PRESET_LFO_RATE_MIN 0.1f // Hz
+#define PRESET_LFO_RATE_MAX 20.0f
+#define PRESET_DETUNE_MAX 100.0f   // cents
+#define PRESET_MOD_PITCH_MAX 12.0f // mod amounts, either way. Semitones
+#define PRESET_MOD_CUTOFF_MAX 4.0f // octaves
+#define PRESET_MOD_GAIN_MAX 24.0f  // dB
+
+// Effects in the graph, after the crossover
+enum
+{
+    PRESET_DELAY  = 1 << 0,
+    PRESET_REVERB = 1 << 1,
+};
+
+typedef struct SynthPreset
+{
+    char name[PRESET_NAME_SIZE];
+    // Parameters
+    OscShape   shape;
+    float      gaindB;
+    float      cutoff;    // voice lowpass, 0-1
+    float      crossover; // 0-1
+    AdsrParams ampEnvelope;
+    int        unison;      // oscillators per note, 1-SYNTH_MAX_UNISON
+    float      detune;      // cents across the unison stack
+    float      unisonWidth; // 0-1
+    // Modulation. LFO phases aren't saved
+    Lfo         lfos[MOD_NUM_LFOS];
+    ModEnvelope envelope;
+    ModMatrix   mod;
+    // Graph
+    unsigned  effects; // PRESET_DELAY | PRESET_REVERB
+    DelayType delayType;
+    float     delayMix;  // wet gain, 0-1
+    float     reverbWet; // 0-1
+} SynthPreset;
+
+// Built in presets, index 0 - PRESET_NUM_FACTORY-1. The first is the synth's defaults
+void preset_factory(SynthPreset* preset, int index);
+
+// Returns the number of bytes written, at most PRESET_MAX_BYTES
+int preset_encode(const SynthPreset* preset, uint8_t* data);
+// Returns 0 on success, non zero if 'data' isn't a valid preset. 'preset' is only written on success.
+// Values out of range are clamped to it
+int preset_decode(SynthPreset* preset, const uint8_t* data, int size);
+// Return 0 on success, non zero if the file can't be written or read, or isn't a preset
+int preset_save(const SynthPreset* preset, const char* path);
+int preset_load(SynthPreset* preset, const char* path);
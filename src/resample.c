@@ -0,0 +1,153 @@
+#include "resample.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// Kaiser window beta for about 90dB of stopband attenuation
+#define RESAMPLE_BETA 8.96
+// Transition band width as a fraction of the input rate, for RESAMPLE_TAPS at that attenuation
+#define RESAMPLE_TRANSITION ((90.0 - 8.0) / (2.285 * 2.0 * 3.141592653589793 * (RESAMPLE_TAPS - 1)))
+
+static int resample_gcd(int a, int b)
+{
+    while (b != 0)
+    {
+        int t = a % b;
+        a     = b;
+        b     = t;
+    }
+    return a;
+}
+
+// Zeroth order modified Bessel function of the first kind
+static double resample_bessel_i0(double x)
+{
+    double sum  = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum  += term;
+    }
+    return sum;
+}
+
+static void resample_design(Resampler* r)
+{
+    static const double pi = 3.141592653589793;
+
+    const double half = RESAMPLE_TAPS / 2;
+    // Fraction of the input rate that survives
+    const double ratio = r->up < r->down ? (double)r->up / r->down : 1.0;
+    double       fc    = 0.5 * ratio - 0.5 * RESAMPLE_TRANSITION;
+    fc                 = fc > 0.25 * ratio ? fc : 0.25 * ratio;
+
+    for (int p = 0; p < r->up; p++)
+    {
+        double sum = 0;
+        for (int j = 0; j < RESAMPLE_TAPS; j++)
+        {
+            // Distance in input frames from the output frame, which lies p / up after input frame RESAMPLE_TAPS/2
+            double d = half - 1 - j + (double)p / r->up;
+            double w = d / half;
+            double h = 2 * fc;
+
+            if (d != 0)
+                h = sin(2 * pi * fc * d) / (pi * d);
+            h *= w * w < 1 ? resample_bessel_i0(RESAMPLE_BETA * sqrt(1 - w * w)) / resample_bessel_i0(RESAMPLE_BETA)
+                           : 0;
+            r->coeffs[p][j] = (float)h;
+            sum             += h;
+        }
+        // Unity gain at DC for every phase, otherwise the ripple between phases is heard as a tone at 'up'
+        for (int j = 0; j < RESAMPLE_TAPS; j++)
+            r->coeffs[p][j] = (float)(r->coeffs[p][j] / sum);
+    }
+}
+
+int resample_init(Resampler* r, int inRate, int outRate, int numChannels)
+{
+    int gcd = resample_gcd(inRate, outRate);
+
+    assert(inRate > 0 && outRate > 0);
+    assert(numChannels >= 1 && numChannels <= RESAMPLE_MAX_CHANNELS);
+    memset(r, 0, sizeof(*r));
+    r->numChannels = numChannels;
+    r->up          = outRate / gcd;
+    r->down        = inRate / gcd;
+    if (r->up > RESAMPLE_MAX_PHASES)
+        return 1;
+    resample_design(r);
+    return 0;
+}
+
+void resample_reset(Resampler* r)
+{
+    r->phase = 0;
+    r->pos   = 0;
+    memset(r->history, 0, sizeof(r->history));
+}
+
+SIMD_INLINE float resample_dot(const float* coeffs, const float* x)
+{
+    // Two accumulators hide the fmadd latency
+    simd_f acc0 = simd_mul(simd_load(coeffs), simd_loadu(x));
+    simd_f acc1 = simd_mul(simd_load(coeffs + SIMD_WIDTH), simd_loadu(x + SIMD_WIDTH));
+    for (int j = 2 * SIMD_WIDTH; j < RESAMPLE_TAPS; j += 2 * SIMD_WIDTH)
+    {
+        acc0 = simd_fmadd(simd_load(coeffs + j), simd_loadu(x + j), acc0);
+        acc1 = simd_fmadd(simd_load(coeffs + j + SIMD_WIDTH), simd_loadu(x + j + SIMD_WIDTH), acc1);
+    }
+    return simd_hsum(simd_add(acc0, acc1));
+}
+
+void resample_process(Resampler* r, ResampleFill fill, void* userdata, float* out, int numFrames)
+{
+    const int numChannels = r->numChannels;
+
+    if (r->up == r->down)
+    {
+        fill(userdata, out, numFrames);
+        return;
+    }
+
+    while (numFrames > 0)
+    {
+        // As many output frames as RESAMPLE_MAX_INPUT input frames allow
+        int maxOut  = ((RESAMPLE_MAX_INPUT - r->pos) * r->up - 1 - r->phase) / r->down + 1;
+        int numOut  = numFrames < maxOut ? numFrames : maxOut;
+        int lastPos = r->pos + (r->phase + (numOut - 1) * r->down) / r->up;
+        int numIn   = lastPos + 1 > 0 ? lastPos + 1 : 0;
+        int pos     = r->pos;
+        int phase   = r->phase;
+
+        if (numIn > 0)
+        {
+            fill(userdata, r->input, numIn);
+            for (int c = 0; c < numChannels; c++)
+            {
+                float* h = r->history[c] + RESAMPLE_TAPS;
+                for (int i = 0; i < numIn; i++)
+                    h[i] = r->input[i * numChannels + c];
+            }
+        }
+
+        for (int i = 0; i < numOut; i++, out += numChannels)
+        {
+            // The window ends on input frame 'pos'
+            const float* coeffs = r->coeffs[phase];
+            for (int c = 0; c < numChannels; c++)
+                out[c] = resample_dot(coeffs, r->history[c] + pos + 1);
+            phase += r->down;
+            pos   += phase / r->up;
+            phase %= r->up;
+        }
+
+        for (int c = 0; c < numChannels; c++)
+            memmove(r->history[c], r->history[c] + numIn, RESAMPLE_TAPS * sizeof(float));
+        r->pos     = pos - numIn;
+        r->phase   = phase;
+        numFrames -= numOut;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "simd.h"
+
+// Polyphase sample rate converter, so the synth can run at a fixed rate whatever the device's rate is.
+// The ratio is reduced to up / down. Each output frame is one phase of a Kaiser windowed sinc, RESAMPLE_TAPS input
+// frames long, designed once in resample_init(). Every phase is a dot product over contiguous history, one
+// SIMD_WIDTH of taps per instruction.
+// Roughly 90dB stopband. The transition band sits just below the lower of the two Nyquist frequencies, so above
+// about 17.5kHz when converting 48kHz to 44.1kHz. Latency is RESAMPLE_TAPS / 2 input frames.
+
+#define RESAMPLE_TAPS 64
+// Enough for 48kHz to and from the 44.1kHz family (147 / 160)
+#define RESAMPLE_MAX_PHASES 256
+#define RESAMPLE_MAX_CHANNELS 8
+// Most input frames asked for at once
+#define RESAMPLE_MAX_INPUT 512
+
+// Writes numFrames interleaved input frames to 'buffer'
+typedef void (*ResampleFill)(void* userdata, float* buffer, int numFrames);
+
+typedef struct Resampler
+{
+    int numChannels;
+    int up;
+    int down;
+    // Next output frame's phase, and its newest input frame counted from the next frame filled.
+    // -1 is the last frame of the previous fill
+    int phase;
+    int pos;
+    // Taps per phase, oldest input first
+    SIMD_ALIGNED float coeffs[RESAMPLE_MAX_PHASES][RESAMPLE_TAPS];
+    // Planar input, the last RESAMPLE_TAPS frames of the previous fill first
+    SIMD_ALIGNED float history[RESAMPLE_MAX_CHANNELS][RESAMPLE_TAPS + RESAMPLE_MAX_INPUT];
+    // Interleaved, as filled
+    SIMD_ALIGNED float input[RESAMPLE_MAX_INPUT * RESAMPLE_MAX_CHANNELS];
+} Resampler;
+
+// Returns 0 on success, non zero if the ratio needs more than RESAMPLE_MAX_PHASES phases
+int  resample_init(Resampler* r, int inRate, int outRate, int numChannels);
+void resample_reset(Resampler* r);
+// Fills the interleaved 'out' with numFrames, pulling as many input frames through 'fill' as that takes.
+// Equal rates are passed straight through
+void resample_process(Resampler* r, ResampleFill fill, void* userdata, float* out, int numFrames);
@@ -0,0 +1,435 @@
+#include "reverb.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Carves the reverb's arrays out of one allocation. With no base, only counts the bytes needed
+typedef struct ReverbArena
+{
+    uint8_t* base;
+    size_t   used;
+} ReverbArena;
+
+static void* reverb_take(ReverbArena* arena, size_t bytes)
+{
+    void* p     = arena->base ? arena->base + arena->used : NULL;
+    arena->used += (bytes + 31) & ~(size_t)31;
+    return p;
+}
+
+static float* reverb_take_floats(ReverbArena* arena, int count) { return reverb_take(arena, count * sizeof(float)); }
+
+static void reverb_layout_level(ReverbLevel* level, ReverbArena* arena, int numChannels, int blockFrames,
+                                int numPartitions)
+{
+    const int size = 2 * blockFrames;
+
+    level->blockFrames   = blockFrames;
+    level->numBins       = (blockFrames + 1 + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    level->numPartitions = numPartitions;
+    for (int c = 0; c < numChannels; c++)
+    {
+        level->irRe[c]      = reverb_take_floats(arena, numPartitions * level->numBins);
+        level->irIm[c]      = reverb_take_floats(arena, numPartitions * level->numBins);
+        level->delayRe[c]   = reverb_take_floats(arena, numPartitions * level->numBins);
+        level->delayIm[c]   = reverb_take_floats(arena, numPartitions * level->numBins);
+        level->prevInput[c] = reverb_take_floats(arena, blockFrames);
+        level->accRe[c]     = reverb_take_floats(arena, level->numBins);
+        level->accIm[c]     = reverb_take_floats(arena, level->numBins);
+    }
+    level->fftRe = reverb_take_floats(arena, size);
+    level->fftIm = reverb_take_floats(arena, size);
+}
+
+static void reverb_layout(Reverb* reverb, ReverbArena* arena, int headPartitions, int tailPartitions)
+{
+    reverb_layout_level(&reverb->head, arena, reverb->numChannels, REVERB_HEAD_FRAMES, headPartitions);
+    if (tailPartitions == 0)
+        return;
+    reverb_layout_level(&reverb->tail, arena, reverb->numChannels, REVERB_TAIL_FRAMES, tailPartitions);
+    for (int c = 0; c < reverb->numChannels; c++)
+    {
+        reverb->tailCollect[c] = reverb_take_floats(arena, REVERB_TAIL_FRAMES);
+        reverb->tailIn[c]      = reverb_take_floats(arena, REVERB_TAIL_FRAMES);
+        reverb->tailOut[0][c]  = reverb_take_floats(arena, REVERB_TAIL_FRAMES);
+        reverb->tailOut[1][c]  = reverb_take_floats(arena, REVERB_TAIL_FRAMES);
+    }
+}
+
+// Separates the spectra of the two real signals packed into fftRe & fftIm, bins 0 to blockFrames.
+// Both come out doubled
+static void reverb_split(const ReverbLevel* level, float* re0, float* im0, float* re1, float* im1)
+{
+    const int    n  = level->fft.size;
+    const float* zr = level->fftRe;
+    const float* zi = level->fftIm;
+
+    for (int k = 0; k <= level->blockFrames; k++)
+    {
+        int j  = (n - k) & (n - 1);
+        re0[k] = zr[k] + zr[j];
+        im0[k] = zi[k] - zi[j];
+        if (re1)
+        {
+            re1[k] = zi[k] + zi[j];
+            im1[k] = zr[j] - zr[k];
+        }
+    }
+}
+
+// Packs two real signals' half spectra back into one full spectrum, for one inverse FFT
+static void reverb_combine(ReverbLevel* level, const float* re0, const float* im0, const float* re1, const float* im1)
+{
+    const int n  = level->fft.size;
+    float*    zr = level->fftRe;
+    float*    zi = level->fftIm;
+
+    for (int k = 0; k <= level->blockFrames; k++)
+    {
+        float r1 = re1 ? re1[k] : 0.0f;
+        float i1 = im1 ? im1[k] : 0.0f;
+        zr[k]    = re0[k] - i1;
+        zi[k]    = im0[k] + r1;
+        if (k > 0 && k < level->blockFrames)
+        {
+            zr[n - k] = re0[k] + i1;
+            zi[n - k] = r1 - im0[k];
+        }
+    }
+}
+
+static void reverb_design_level(ReverbLevel* level, const float* const* ir, int numFrames, int numChannels,
+                                int start)
+{
+    const int n = level->fft.size;
+    // The split doubles the IR & the input spectra, and the inverse FFT is unscaled
+    const float scale = 0.25f / (float)n;
+
+    for (int p = 0; p < level->numPartitions; p++)
+    {
+        int offset = start + p * level->blockFrames;
+        int len    = numFrames - offset < level->blockFrames ? numFrames - offset : level->blockFrames;
+        int bin    = p * level->numBins;
+
+        // Partition first, zero padded, so the second half of each overlap-save block is the linear convolution
+        memset(level->fftRe, 0, n * sizeof(float));
+        memset(level->fftIm, 0, n * sizeof(float));
+        for (int i = 0; i < len; i++)
+        {
+            level->fftRe[i] = ir[0][offset + i];
+            level->fftIm[i] = numChannels > 1 ? ir[1][offset + i] : 0.0f;
+        }
+        fft_forward(&level->fft, level->fftRe, level->fftIm);
+        if (numChannels > 1)
+            reverb_split(level, level->irRe[0] + bin, level->irIm[0] + bin, level->irRe[1] + bin, level->irIm[1] + bin);
+        else
+            reverb_split(level, level->irRe[0] + bin, level->irIm[0] + bin, NULL, NULL);
+        for (int c = 0; c < numChannels; c++)
+        {
+            for (int k = 0; k < level->numBins; k++)
+            {
+                level->irRe[c][bin + k] *= scale;
+                level->irIm[c][bin + k] *= scale;
+            }
+        }
+    }
+}
+
+// Convolves the next blockFrames of input, writing blockFrames of output
+static void reverb_level_process(ReverbLevel* level, int numChannels, const float* const* in, float* const* out)
+{
+    const int P       = level->blockFrames;
+    const int numBins = level->numBins;
+    const int slot    = level->newest = (level->newest + level->numPartitions - 1) % level->numPartitions;
+
+    // Overlap-save: the previous block, then this one
+    for (int i = 0; i < P; i++)
+    {
+        level->fftRe[i]     = level->prevInput[0][i];
+        level->fftRe[P + i] = in[0][i];
+        level->fftIm[i]     = numChannels > 1 ? level->prevInput[1][i] : 0.0f;
+        level->fftIm[P + i] = numChannels > 1 ? in[1][i] : 0.0f;
+    }
+    for (int c = 0; c < numChannels; c++)
+        memcpy(level->prevInput[c], in[c], P * sizeof(float));
+    fft_forward(&level->fft, level->fftRe, level->fftIm);
+    if (numChannels > 1)
+        reverb_split(level, level->delayRe[0] + slot * numBins, level->delayIm[0] + slot * numBins,
+                     level->delayRe[1] + slot * numBins, level->delayIm[1] + slot * numBins);
+    else
+        reverb_split(level, level->delayRe[0] + slot * numBins, level->delayIm[0] + slot * numBins, NULL, NULL);
+
+    // Partition p of the IR meets the input from p blocks ago
+    for (int c = 0; c < numChannels; c++)
+    {
+        float* accRe = level->accRe[c];
+        float* accIm = level->accIm[c];
+        memset(accRe, 0, numBins * sizeof(float));
+        memset(accIm, 0, numBins * sizeof(float));
+        for (int p = 0; p < level->numPartitions; p++)
+        {
+            int          s  = slot + p < level->numPartitions ? slot + p : slot + p - level->numPartitions;
+            const float* xr = level->delayRe[c] + s * numBins;
+            const float* xi = level->delayIm[c] + s * numBins;
+            const float* hr = level->irRe[c] + p * numBins;
+            const float* hi = level->irIm[c] + p * numBins;
+            for (int k = 0; k < numBins; k += SIMD_WIDTH)
+            {
+                simd_f a = simd_load(&xr[k]), b = simd_load(&xi[k]);
+                simd_f c = simd_load(&hr[k]), d = simd_load(&hi[k]);
+                simd_store(&accRe[k], simd_sub(simd_fmadd(a, c, simd_load(&accRe[k])), simd_mul(b, d)));
+                simd_store(&accIm[k], simd_fmadd(a, d, simd_fmadd(b, c, simd_load(&accIm[k]))));
+            }
+        }
+    }
+
+    if (numChannels > 1)
+        reverb_combine(level, level->accRe[0], level->accIm[0], level->accRe[1], level->accIm[1]);
+    else
+        reverb_combine(level, level->accRe[0], level->accIm[0], NULL, NULL);
+    fft_inverse(&level->fft, level->fftRe, level->fftIm);
+    memcpy(out[0], level->fftRe + P, P * sizeof(float));
+    if (numChannels > 1)
+        memcpy(out[1], level->fftIm + P, P * sizeof(float));
+}
+
+static void reverb_run_tail(Reverb* reverb, int block)
+{
+    reverb_level_process(&reverb->tail, reverb->numChannels, (const float* const*)reverb->tailIn,
+                         reverb->tailOut[block & 1]);
+}
+
+static int reverb_thread(void* userdata)
+{
+    Reverb* reverb = userdata;
+    int     done   = 0;
+
+    thread_set_high_priority();
+    // Same floating point mode as the audio thread
+    simd_flush_denormals();
+    while (thread_atomic_int_load(&reverb->exit) == 0)
+    {
+        if (thread_atomic_int_load(&reverb->started) != done)
+        {
+            reverb_run_tail(reverb, done);
+            thread_atomic_int_store(&reverb->finished, ++done);
+            continue;
+        }
+        // Flag first, then check again, like the WorkPool's workers
+        thread_atomic_int_store(&reverb->sleeping, 1);
+        if (thread_atomic_int_load(&reverb->started) == done)
+            thread_signal_wait(&reverb->wake, 100);
+        thread_atomic_int_store(&reverb->sleeping, 0);
+    }
+    return 0;
+}
+
+int reverb_init(Reverb* reverb, const float* const* ir, int numFrames, int numChannels, float sampleRate,
+                int background)
+{
+    const int   tailStart = 2 * REVERB_TAIL_FRAMES;
+    const int   headLen   = numFrames < tailStart ? numFrames : tailStart;
+    const int   tailLen   = numFrames - headLen;
+    const int   headParts = headLen > 0 ? (headLen + REVERB_HEAD_FRAMES - 1) / REVERB_HEAD_FRAMES : 1;
+    const int   tailParts = (tailLen + REVERB_TAIL_FRAMES - 1) / REVERB_TAIL_FRAMES;
+    ReverbArena arena     = {0};
+
+    memset(reverb, 0, sizeof(*reverb));
+    numChannels         = numChannels < REVERB_MAX_CHANNELS ? numChannels : REVERB_MAX_CHANNELS;
+    reverb->numChannels = numChannels;
+    reverb->rampFrames  = (int)(sampleRate * 0.01f);
+
+    reverb_layout(reverb, &arena, headParts, tailParts);
+    reverb->memory = calloc(1, arena.used + 32);
+    if (! reverb->memory)
+        return 1;
+    arena.base = (uint8_t*)(((uintptr_t)reverb->memory + 31) & ~(uintptr_t)31);
+    arena.used = 0;
+    reverb_layout(reverb, &arena, headParts, tailParts);
+    if (fft_plan_init(&reverb->head.fft, 2 * REVERB_HEAD_FRAMES) ||
+        (tailParts > 0 && fft_plan_init(&reverb->tail.fft, 2 * REVERB_TAIL_FRAMES)))
+    {
+        reverb_free(reverb);
+        return 1;
+    }
+
+    reverb_design_level(&reverb->head, ir, headLen, numChannels, 0);
+    if (tailParts > 0)
+        reverb_design_level(&reverb->tail, ir, numFrames, numChannels, tailStart);
+    reverb->lastWet = NAN;
+
+    if (background && tailParts > 0)
+    {
+        thread_signal_init(&reverb->wake);
+        reverb->thread = thread_create(reverb_thread, reverb, THREAD_STACK_SIZE_DEFAULT);
+    }
+    return 0;
+}
+
+void reverb_free(Reverb* reverb)
+{
+    if (reverb->thread)
+    {
+        thread_atomic_int_store(&reverb->exit, 1);
+        thread_signal_raise(&reverb->wake);
+        thread_join(reverb->thread);
+        thread_destroy(reverb->thread);
+        thread_signal_term(&reverb->wake);
+        reverb->thread = NULL;
+    }
+    fft_plan_free(&reverb->head.fft);
+    fft_plan_free(&reverb->tail.fft);
+    free(reverb->memory);
+    reverb->memory = NULL;
+}
+
+static void reverb_reset_level(ReverbLevel* level, int numChannels)
+{
+    level->newest = 0;
+    if (level->numPartitions == 0)
+        return;
+    for (int c = 0; c < numChannels; c++)
+    {
+        memset(level->delayRe[c], 0, level->numPartitions * level->numBins * sizeof(float));
+        memset(level->delayIm[c], 0, level->numPartitions * level->numBins * sizeof(float));
+        memset(level->prevInput[c], 0, level->blockFrames * sizeof(float));
+    }
+}
+
+// Only call while the tail isn't running, e.g. with audio stopped
+void reverb_reset(Reverb* reverb)
+{
+    reverb_reset_level(&reverb->head, reverb->numChannels);
+    reverb_reset_level(&reverb->tail, reverb->numChannels);
+    memset(reverb->headIn, 0, sizeof(reverb->headIn));
+    memset(reverb->headOut, 0, sizeof(reverb->headOut));
+    reverb->headPos = 0;
+    reverb->tailPos = 0;
+    for (int c = 0; c < reverb->numChannels && reverb->tail.numPartitions > 0; c++)
+    {
+        memset(reverb->tailOut[0][c], 0, REVERB_TAIL_FRAMES * sizeof(float));
+        memset(reverb->tailOut[1][c], 0, REVERB_TAIL_FRAMES * sizeof(float));
+    }
+}
+
+// Hands a full block of input to the tail, once the previous block has finished
+static void reverb_start_tail(Reverb* reverb)
+{
+    const int block = reverb->tailBlock;
+
+    if (reverb->thread)
+    {
+        // It has had a whole tail block to run, so this only waits when the machine is overloaded
+        while (thread_atomic_int_load(&reverb->finished) != block)
+            thread_yield();
+    }
+    for (int c = 0; c < reverb->numChannels; c++)
+        memcpy(reverb->tailIn[c], reverb->tailCollect[c], REVERB_TAIL_FRAMES * sizeof(float));
+    if (reverb->thread)
+    {
+        thread_atomic_int_store(&reverb->started, block + 1);
+        if (thread_atomic_int_load(&reverb->sleeping))
+            thread_signal_raise(&reverb->wake);
+    }
+    else
+    {
+        reverb_run_tail(reverb, block);
+    }
+    reverb->tailBlock = block + 1;
+}
+
+// Convolves the head block just collected, adds the tail's share, and queues the block for the tail
+static void reverb_process_block(Reverb* reverb)
+{
+    const float* headIn[REVERB_MAX_CHANNELS];
+    float*       headOut[REVERB_MAX_CHANNELS];
+    const int    tail = reverb->tail.numPartitions > 0;
+
+    for (int c = 0; c < reverb->numChannels; c++)
+    {
+        headIn[c]  = reverb->headIn[c];
+        headOut[c] = reverb->headOut[c];
+    }
+    reverb_level_process(&reverb->head, reverb->numChannels, headIn, headOut);
+    if (! tail)
+        return;
+
+    for (int c = 0; c < reverb->numChannels; c++)
+    {
+        // Block n's output plays during block n + 2, the same buffer as n
+        const float* tailOut = reverb->tailOut[reverb->tailBlock & 1][c] + reverb->tailPos;
+        for (int i = 0; i < REVERB_HEAD_FRAMES; i++)
+            headOut[c][i] += tailOut[i];
+        memcpy(reverb->tailCollect[c] + reverb->tailPos, reverb->headIn[c], REVERB_HEAD_FRAMES * sizeof(float));
+    }
+    reverb->tailPos += REVERB_HEAD_FRAMES;
+    if (reverb->tailPos == REVERB_TAIL_FRAMES)
+    {
+        reverb->tailPos = 0;
+        reverb_start_tail(reverb);
+    }
+}
+
+void reverb_process(Reverb* reverb, const float* const* in, float* const* out, int numFrames)
+{
+    if (isnan(reverb->lastWet))
+    {
+        reverb->lastWet = reverb->wet;
+        smoothed_reset(&reverb->wetRamp, reverb->wet);
+    }
+    else if (param_changed(&reverb->lastWet, reverb->wet))
+    {
+        smoothed_set_target(&reverb->wetRamp, reverb->wet, reverb->rampFrames);
+    }
+
+    // Up to the end of the current head block at a time
+    for (int done = 0; done < numFrames;)
+    {
+        float wet[REVERB_HEAD_FRAMES];
+        int   n = REVERB_HEAD_FRAMES - reverb->headPos;
+        n       = n < numFrames - done ? n : numFrames - done;
+
+        smoothed_render(&reverb->wetRamp, wet, n);
+        for (int c = 0; c < reverb->numChannels; c++)
+        {
+            const float* x = in[c] + done;
+            const float* r = reverb->headOut[c] + reverb->headPos;
+            float*       y = out[c] + done;
+
+            memcpy(reverb->headIn[c] + reverb->headPos, x, n * sizeof(float));
+            for (int i = 0; i < n; i++)
+                y[i] = x[i] + r[i] * wet[i];
+        }
+
+        reverb->headPos += n;
+        done            += n;
+        if (reverb->headPos == REVERB_HEAD_FRAMES)
+        {
+            reverb->headPos = 0;
+            reverb_process_block(reverb);
+        }
+    }
+}
+
+void reverb_generate_ir(float* const* ir, int numFrames, int numChannels, float sampleRate, float rt60Seconds)
+{
+    // -60dB over rt60Seconds
+    const float decay = expf(-6.907755f / (rt60Seconds * sampleRate));
+
+    for (int c = 0; c < numChannels; c++)
+    {
+        uint32_t state = 0x9e3779b9u * (uint32_t)(c + 1);
+        float    env   = 0.25f;
+        for (int i = 0; i < numFrames; i++)
+        {
+            // xorshift32, uniform -1 to 1
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ir[c][i] = ((float)(state >> 8) * (2.0f / 16777216.0f) - 1.0f) * env;
+            env      *= decay;
+        }
+    }
+}
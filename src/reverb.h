@@ -0,0 +1,87 @@
+#pragma once
+#include "fft.h"
+#include "param.h"
+#include "simd.h"
+#include "thread.h"
+
+// Convolution reverb for impulse responses of several seconds.
+// Non uniformly partitioned overlap-save convolution in two levels. The head of the IR is split into
+// REVERB_HEAD_FRAMES partitions, convolved every REVERB_HEAD_FRAMES frames. The tail, from 2 * REVERB_TAIL_FRAMES
+// on, uses REVERB_TAIL_FRAMES partitions, so most of the IR costs one large FFT per tail block instead of many
+// small ones. The tail's output isn't needed until a whole tail block after its input arrives, so it can run on a
+// background thread. Inline or threaded, the output is the same.
+// Each level keeps a frequency domain delay line of past input spectra and multiply-accumulates them with the IR
+// partitions' spectra. Both channels share one complex FFT, left in the real part & right in the imaginary part.
+// The wet signal is REVERB_HEAD_FRAMES late, the dry signal passes straight through.
+
+#define REVERB_MAX_CHANNELS 2
+#define REVERB_HEAD_FRAMES 64
+#define REVERB_TAIL_FRAMES 1024
+
+// One level of partitions. Spectra are split complex, numBins long
+typedef struct ReverbLevel
+{
+    int       blockFrames;
+    int       numBins; // blockFrames + 1, rounded up to SIMD_WIDTH
+    int       numPartitions;
+    int       newest; // delay line slot of the newest input spectrum
+    FftPlan   fft;    // complex, 2 * blockFrames
+    float*    irRe[REVERB_MAX_CHANNELS]; // numPartitions * numBins, scaled for the inverse FFT
+    float*    irIm[REVERB_MAX_CHANNELS];
+    float*    delayRe[REVERB_MAX_CHANNELS]; // numPartitions * numBins
+    float*    delayIm[REVERB_MAX_CHANNELS];
+    float*    prevInput[REVERB_MAX_CHANNELS]; // blockFrames
+    float*    accRe[REVERB_MAX_CHANNELS];     // numBins
+    float*    accIm[REVERB_MAX_CHANNELS];
+    float*    fftRe; // 2 * blockFrames
+    float*    fftIm;
+} ReverbLevel;
+
+typedef struct Reverb
+{
+    int   numChannels;
+    float wet; // gain of the reverb, set before each reverb_process()
+    float lastWet;
+    // Changes ramp, like the synth's parameters
+    SmoothedValue wetRamp;
+    int           rampFrames;
+
+    ReverbLevel head;
+    ReverbLevel tail;
+    // Frames into the current head block. Input is collected & the last block's output handed out meanwhile
+    int   headPos;
+    float headIn[REVERB_MAX_CHANNELS][REVERB_HEAD_FRAMES];
+    float headOut[REVERB_MAX_CHANNELS][REVERB_HEAD_FRAMES];
+    // Tail blocks are numbered by when their input arrived. Block n's output is played during block n + 2,
+    // giving the tail a whole block to run. Output is double buffered by block number
+    int    tailPos;
+    int    tailBlock;
+    float* tailCollect[REVERB_MAX_CHANNELS]; // REVERB_TAIL_FRAMES
+    float* tailIn[REVERB_MAX_CHANNELS];
+    float* tailOut[2][REVERB_MAX_CHANNELS];
+
+    // Background thread running the tail, or NULL to run it inline
+    thread_ptr_t        thread;
+    thread_signal_t     wake;
+    thread_atomic_int_t sleeping;
+    thread_atomic_int_t exit;
+    // Tail blocks started & finished
+    thread_atomic_int_t started;
+    thread_atomic_int_t finished;
+
+    void* memory;
+} Reverb;
+
+// Allocates everything & designs the partitions for 'ir', numChannels planar channels of numFrames.
+// With 'background', the tail runs on its own thread. Returns 0 on success, non zero if out of memory, in which case
+// nothing is left allocated
+int  reverb_init(Reverb* reverb, const float* const* ir, int numFrames, int numChannels, float sampleRate,
+                 int background);
+void reverb_free(Reverb* reverb);
+void reverb_reset(Reverb* reverb);
+
+// Adds the reverb to numChannels planar channels of any length
+void reverb_process(Reverb* reverb, const float* const* in, float* const* out, int numFrames);
+
+// Decaying noise, decorrelated between channels, with the given RT60. Fills numChannels planar channels
+void reverb_generate_ir(float* const* ir, int numFrames, int numChannels, float sampleRate, float rt60Seconds);
@@ -0,0 +1,427 @@
+#include "sampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ring space, in floats, the prefetch thread needs before it reads another chunk
+#define SAMPLER_REFILL_SPACE (2 * SAMPLER_CHUNK_FRAMES)
+
+// Copies the first two channels, or the only one twice
+static void sampler_to_stereo(const float* in, int numChannels, float* out, int numFrames)
+{
+    for (int i = 0; i < numFrames; i++, in += numChannels)
+    {
+        out[2 * i]     = in[0];
+        out[2 * i + 1] = in[numChannels > 1 ? 1 : 0];
+    }
+}
+
+// Reads the next chunk of a voice's file into its ring. Frames that can't be read are silent
+static void sampler_prefetch_chunk(Sampler* sampler, SamplerVoice* voice)
+{
+    const SamplerSample* sample = &sampler->samples[voice->streamSample];
+    int                  n      = (int)(sample->info.numFrames - voice->nextFrame);
+    int                  done   = 0;
+
+    n = n < SAMPLER_CHUNK_FRAMES ? n : SAMPLER_CHUNK_FRAMES;
+    if (voice->file)
+        done = wav_read_frames(voice->file, &sample->info, voice->nextFrame, sampler->fileChunk, n);
+    sampler_to_stereo(sampler->fileChunk, sample->info.numChannels, sampler->stereoChunk, done);
+    memset(sampler->stereoChunk + 2 * done, 0, 2 * (n - done) * sizeof(float));
+    spsc_ring_write(&voice->ring, sampler->stereoChunk, 2 * n);
+    voice->nextFrame += n;
+}
+
+// One pass over the voices, at most one chunk each so they fill evenly. Returns 1 if there was anything to do
+static int sampler_prefetch_pass(Sampler* sampler)
+{
+    int work = 0;
+
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+    {
+        SamplerVoice* voice = &sampler->voices[v];
+        int           state = thread_atomic_int_load(&voice->state);
+
+        if (state == SAMPLER_STREAM_START)
+        {
+            const SamplerSample* sample = &sampler->samples[voice->streamSample];
+            voice->file                 = fopen(sample->path, "rb");
+            voice->nextFrame            = (unsigned)sample->headFrames;
+            spsc_ring_init(&voice->ring, voice->ring.data, voice->ring.capacity);
+            // The note may already have finished
+            if (thread_atomic_int_compare_and_swap(&voice->state, SAMPLER_STREAM_START, SAMPLER_STREAM_STREAMING) !=
+                SAMPLER_STREAM_START)
+                state = SAMPLER_STREAM_STOP;
+            work = 1;
+        }
+        else if (state == SAMPLER_STREAM_STREAMING)
+        {
+            const SamplerSample* sample = &sampler->samples[voice->streamSample];
+            if (voice->nextFrame < sample->info.numFrames &&
+                spsc_ring_space(&voice->ring) >= SAMPLER_REFILL_SPACE)
+            {
+                sampler_prefetch_chunk(sampler, voice);
+                work = 1;
+            }
+        }
+        if (state == SAMPLER_STREAM_STOP)
+        {
+            if (voice->file)
+                fclose(voice->file);
+            voice->file = NULL;
+            thread_atomic_int_store(&voice->state, SAMPLER_STREAM_IDLE);
+            work = 1;
+        }
+    }
+    return work;
+}
+
+static int sampler_thread(void* userdata)
+{
+    Sampler* sampler = userdata;
+
+    thread_set_high_priority();
+    while (thread_atomic_int_load(&sampler->exit) == 0)
+    {
+        int seen = thread_atomic_int_load(&sampler->requests);
+        if (sampler_prefetch_pass(sampler))
+            continue;
+        // Flag first, then check again, like the reverb's tail thread
+        thread_atomic_int_store(&sampler->sleeping, 1);
+        if (thread_atomic_int_load(&sampler->requests) == seen)
+            thread_signal_wait(&sampler->wake, 100);
+        thread_atomic_int_store(&sampler->sleeping, 0);
+    }
+    return 0;
+}
+
+// Tells the prefetch thread there's work
+static void sampler_request(Sampler* sampler)
+{
+    thread_atomic_int_inc(&sampler->requests);
+    if (thread_atomic_int_load(&sampler->sleeping))
+        thread_signal_raise(&sampler->wake);
+}
+
+int sampler_init(Sampler* sampler, float sampleRate)
+{
+    const size_t ringFloats  = 2 * SAMPLER_RING_FRAMES;
+    const size_t chunkFloats = SAMPLER_CHUNK_FRAMES * (SAMPLER_MAX_FILE_CHANNELS + 2);
+    float*       memory;
+
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->sampleRate = sampleRate;
+    memory              = calloc(SAMPLER_MAX_VOICES * ringFloats + chunkFloats, sizeof(float));
+    if (! memory)
+        return 1;
+    sampler->memory = memory;
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+    {
+        sampler->voices[v].sample = -1;
+        spsc_ring_init(&sampler->voices[v].ring, memory + v * ringFloats, (int)ringFloats);
+    }
+    sampler->fileChunk   = memory + SAMPLER_MAX_VOICES * ringFloats;
+    sampler->stereoChunk = sampler->fileChunk + SAMPLER_CHUNK_FRAMES * SAMPLER_MAX_FILE_CHANNELS;
+
+    thread_signal_init(&sampler->wake);
+    sampler->thread = thread_create(sampler_thread, sampler, THREAD_STACK_SIZE_DEFAULT);
+    return 0;
+}
+
+void sampler_free(Sampler* sampler)
+{
+    if (sampler->thread)
+    {
+        thread_atomic_int_store(&sampler->exit, 1);
+        thread_signal_raise(&sampler->wake);
+        thread_join(sampler->thread);
+        thread_destroy(sampler->thread);
+        thread_signal_term(&sampler->wake);
+        sampler->thread = NULL;
+    }
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+        if (sampler->voices[v].file)
+            fclose(sampler->voices[v].file);
+    for (int s = 0; s < sampler->numSamples; s++)
+    {
+        free(sampler->samples[s].path);
+        free(sampler->samples[s].head);
+    }
+    free(sampler->memory);
+    memset(sampler, 0, sizeof(*sampler));
+}
+
+int sampler_add_sample(Sampler* sampler, const char* path, int rootNote, int lowNote, int highNote)
+{
+    SamplerSample* sample = &sampler->samples[sampler->numSamples];
+    FILE*          file;
+    float*         frames;
+    int            numRead;
+
+    if (sampler->numSamples == SAMPLER_MAX_SAMPLES)
+        return 1;
+    file = fopen(path, "rb");
+    if (! file)
+        return 1;
+    if (wav_read_info(file, &sample->info) != 0 || sample->info.numChannels > SAMPLER_MAX_FILE_CHANNELS)
+    {
+        fclose(file);
+        return 1;
+    }
+
+    sample->headFrames = sample->info.numFrames < SAMPLER_HEAD_FRAMES ? (int)sample->info.numFrames
+                                                                       : SAMPLER_HEAD_FRAMES;
+    sample->head       = malloc(2 * sample->headFrames * sizeof(float) + 1);
+    sample->path       = malloc(strlen(path) + 1);
+    frames             = malloc(sample->headFrames * sample->info.numChannels * sizeof(float) + 1);
+    numRead            = frames ? wav_read_frames(file, &sample->info, 0, frames, sample->headFrames) : 0;
+    fclose(file);
+    if (! sample->head || ! sample->path || numRead != sample->headFrames)
+    {
+        free(sample->head);
+        free(sample->path);
+        free(frames);
+        return 1;
+    }
+    sampler_to_stereo(frames, sample->info.numChannels, sample->head, sample->headFrames);
+    free(frames);
+    strcpy(sample->path, path);
+    sample->rootNote = (uint8_t)rootNote;
+    sample->lowNote  = (uint8_t)lowNote;
+    sample->highNote = (uint8_t)highNote;
+    sampler->numSamples++;
+    return 0;
+}
+
+// Sample mapped to a note, or -1
+static int sampler_find_sample(const Sampler* sampler, uint8_t note)
+{
+    for (int s = 0; s < sampler->numSamples; s++)
+        if (note >= sampler->samples[s].lowNote && note <= sampler->samples[s].highNote)
+            return s;
+    return -1;
+}
+
+int sampler_has_note(const Sampler* sampler, uint8_t note) { return sampler_find_sample(sampler, note) >= 0; }
+
+static void sampler_voice_release(Sampler* sampler, SamplerVoice* voice)
+{
+    if (voice->release == 0)
+        voice->release = 1.0f / (SAMPLER_RELEASE_SECONDS * sampler->sampleRate);
+}
+
+static void sampler_voice_finish(Sampler* sampler, SamplerVoice* voice)
+{
+    const SamplerSample* sample = &sampler->samples[voice->sample];
+    // Whether or not the prefetch thread has picked up the START yet
+    if (sample->info.numFrames > (unsigned)sample->headFrames)
+    {
+        thread_atomic_int_store(&voice->state, SAMPLER_STREAM_STOP);
+        sampler_request(sampler);
+    }
+    voice->sample = -1;
+}
+
+void sampler_note_on(Sampler* sampler, uint8_t note, uint8_t velocity)
+{
+    const int      s      = sampler_find_sample(sampler, note);
+    SamplerVoice*  voice  = NULL;
+    SamplerSample* sample;
+    float          step;
+
+    if (velocity == 0)
+    {
+        sampler_note_off(sampler, note);
+        return;
+    }
+    if (s < 0)
+        return;
+    // A repeated note fades out the last one. Voices still handing their stream back can't be used yet
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+    {
+        SamplerVoice* other = &sampler->voices[v];
+        if (other->sample >= 0 && other->note == note)
+            sampler_voice_release(sampler, other);
+        else if (! voice && other->sample < 0 && thread_atomic_int_load(&other->state) == SAMPLER_STREAM_IDLE)
+            voice = other;
+    }
+    if (! voice)
+        return;
+
+    sample = &sampler->samples[s];
+    // Exactly 1 on the root note at the engine's rate, so it plays back bit exact
+    step = exp2f(((float)note - (float)sample->rootNote) / 12.0f) * (float)sample->info.sampleRate;
+    step /= sampler->sampleRate;
+    voice->sample  = s;
+    voice->note    = note;
+    voice->frame   = 0;
+    voice->frac    = 0;
+    voice->step    = step < (float)SAMPLER_MAX_STEP ? step : (float)SAMPLER_MAX_STEP;
+    voice->gain    = (float)velocity / 127.0f;
+    voice->level   = 1.0f;
+    voice->release = 0;
+    voice->fetched = 0;
+    memset(voice->last, 0, sizeof(voice->last));
+    if (sample->info.numFrames > (unsigned)sample->headFrames)
+    {
+        voice->streamSample = s;
+        thread_atomic_int_store(&voice->state, SAMPLER_STREAM_START);
+        sampler_request(sampler);
+    }
+}
+
+void sampler_note_off(Sampler* sampler, uint8_t note)
+{
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+        if (sampler->voices[v].sample >= 0 && sampler->voices[v].note == note)
+            sampler_voice_release(sampler, &sampler->voices[v]);
+}
+
+void sampler_all_notes_off(Sampler* sampler)
+{
+    for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+        if (sampler->voices[v].sample >= 0)
+            sampler_voice_finish(sampler, &sampler->voices[v]);
+}
+
+// Number of frames in [from, to) that stream through the ring rather than coming from the head
+static int sampler_ring_frames(const SamplerSample* sample, unsigned from, unsigned to)
+{
+    const unsigned headEnd = (unsigned)sample->headFrames;
+
+    from = from > headEnd ? from : headEnd;
+    to   = to < sample->info.numFrames ? to : sample->info.numFrames;
+    return to > from ? (int)(to - from) : 0;
+}
+
+// Hands 'count' frames read from a voice's ring back to the prefetch thread. It's only woken when they make room
+// for a chunk, not after every block. If it writes in between, it's awake anyway & sees the room on its next pass
+static void sampler_ring_consumed(Sampler* sampler, int space, int count)
+{
+    if (space < SAMPLER_REFILL_SPACE && space + 2 * count >= SAMPLER_REFILL_SPACE)
+        sampler_request(sampler);
+}
+
+// Fills the scratch with the source frames numFrames outputs need, after the two kept from the last block.
+// After an underrun, the play position has moved past frames that were never fetched. They're dropped, as far as
+// they've arrived. Returns where the source frame at the play position is in the scratch, or NULL if the ring
+// doesn't have the frames yet
+static const float* sampler_voice_fetch(Sampler* sampler, SamplerVoice* voice, int numFrames)
+{
+    const SamplerSample* sample    = &sampler->samples[voice->sample];
+    const float          last      = voice->frac + voice->step * (float)(numFrames - 1);
+    const unsigned       end       = voice->frame + (unsigned)last + 2;
+    const unsigned       headEnd   = (unsigned)sample->headFrames;
+    const int            streaming = thread_atomic_int_load(&voice->state) == SAMPLER_STREAM_STREAMING;
+    const int            space     = voice->ring.capacity - (streaming ? spsc_ring_available(&voice->ring) : 0);
+    unsigned             f         = voice->fetched;
+    float*               dst       = sampler->scratch + 4;
+    int                  dropped   = 0;
+    unsigned             first;
+    int                  fromRing;
+
+    // Scratch frame 0 is source frame f - 2
+    if (end <= f)
+    {
+        memcpy(sampler->scratch, voice->last, sizeof(voice->last));
+        return sampler->scratch + 2 * (voice->frame - (f - 2));
+    }
+    if (f < voice->frame)
+    {
+        int toDrop = sampler_ring_frames(sample, f, voice->frame);
+        if (toDrop > 0 && streaming)
+            dropped = spsc_ring_skip(&voice->ring, 2 * toDrop) / 2;
+        sampler_ring_consumed(sampler, space, dropped);
+        if (dropped < toDrop)
+        {
+            voice->fetched = (f > headEnd ? f : headEnd) + (unsigned)dropped;
+            return NULL;
+        }
+        // Nothing before the play position is read, so the kept frames don't matter
+        f = voice->frame;
+        memset(voice->last, 0, sizeof(voice->last));
+    }
+    first          = f;
+    voice->fetched = f;
+    fromRing       = sampler_ring_frames(sample, f, end);
+    if (fromRing > 0 && (! streaming || spsc_ring_available(&voice->ring) < 2 * fromRing))
+        return NULL;
+
+    memcpy(sampler->scratch, voice->last, sizeof(voice->last));
+    for (; f < end && f < headEnd; f++, dst += 2)
+    {
+        dst[0] = sample->head[2 * f];
+        dst[1] = sample->head[2 * f + 1];
+    }
+    if (fromRing > 0)
+    {
+        spsc_ring_read(&voice->ring, dst, 2 * fromRing);
+        sampler_ring_consumed(sampler, space + 2 * dropped, fromRing);
+        f   += (unsigned)fromRing;
+        dst += 2 * fromRing;
+    }
+    for (; f < end; f++, dst += 2)
+        dst[0] = dst[1] = 0;
+    voice->fetched = end;
+    memcpy(voice->last, dst - 4, sizeof(voice->last));
+    return sampler->scratch + 2 * (voice->frame - (first - 2));
+}
+
+// Moves the play position on by numFrames outputs
+static void sampler_voice_advance(Sampler* sampler, SamplerVoice* voice, int numFrames)
+{
+    float next = voice->frac + voice->step * (float)numFrames;
+
+    voice->frame += (unsigned)next;
+    voice->frac  = next - (float)(unsigned)next;
+    if (voice->frame >= sampler->samples[voice->sample].info.numFrames)
+        sampler_voice_finish(sampler, voice);
+}
+
+static void sampler_voice_render(Sampler* sampler, SamplerVoice* voice, float* const* out, int numFrames)
+{
+    const float* src = sampler_voice_fetch(sampler, voice, numFrames);
+
+    // Silent for the block, but the voice keeps time with everything else: the missed audio is dropped
+    if (! src)
+    {
+        thread_atomic_int_inc(&sampler->underruns);
+        voice->level -= voice->release * (float)numFrames;
+        if (voice->level <= 0)
+            sampler_voice_finish(sampler, voice);
+        else
+            sampler_voice_advance(sampler, voice, numFrames);
+        return;
+    }
+    for (int i = 0; i < numFrames; i++)
+    {
+        float pos = voice->frac + voice->step * (float)i;
+        int   k   = (int)pos;
+        float t = pos - (float)k;
+        float g = voice->gain * voice->level;
+
+        out[0][i] += g * (src[2 * k] + t * (src[2 * k + 2] - src[2 * k]));
+        out[1][i] += g * (src[2 * k + 1] + t * (src[2 * k + 3] - src[2 * k + 1]));
+        voice->level -= voice->release;
+        if (voice->level <= 0)
+        {
+            sampler_voice_finish(sampler, voice);
+            return;
+        }
+    }
+    sampler_voice_advance(sampler, voice, numFrames);
+}
+
+void sampler_process(Sampler* sampler, float* const* out, int numFrames)
+{
+    for (int done = 0; done < numFrames; done += SAMPLER_BLOCK_FRAMES)
+    {
+        float* block[2] = {out[0] + done, out[1] + done};
+        int    n        = numFrames - done < SAMPLER_BLOCK_FRAMES ? numFrames - done : SAMPLER_BLOCK_FRAMES;
+
+        for (int v = 0; v < SAMPLER_MAX_VOICES; v++)
+            if (sampler->voices[v].sample >= 0)
+                sampler_voice_render(sampler, &sampler->voices[v], block, n);
+    }
+}
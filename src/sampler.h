@@ -0,0 +1,112 @@
+#pragma once
+#include "spscring.h"
+#include "thread.h"
+#include "wav.h"
+
+#include <stdint.h>
+
+// Sample playback from WAV files of any length, triggered by MIDI notes.
+// The first SAMPLER_HEAD_FRAMES of each sample are loaded when it's added. The rest streams from disk on a prefetch
+// thread into a lock free ring per voice, starting when the note does, while the voice plays the head. The audio
+// thread never opens or reads a file: if a ring runs dry it plays silence for the block & counts an underrun. The
+// voice still moves on by the block, so it stays in time, & the frames it missed are dropped once they arrive.
+// Memory is the heads plus SAMPLER_MAX_VOICES rings, however long the samples are.
+// Each voice's stream is handed between the threads through its 'state':
+//   IDLE -> START      audio thread, note on
+//   START -> STREAMING prefetch thread, once the file is open & the ring reset
+//   STREAMING -> STOP  audio thread, when the voice finishes
+//   STOP -> IDLE       prefetch thread, once the file is closed
+// Voices are stereo. Mono samples play in both channels, & only the first two channels of wider ones are used.
+
+#define SAMPLER_MAX_SAMPLES 128
+#define SAMPLER_MAX_VOICES 32
+#define SAMPLER_HEAD_FRAMES 8192
+#define SAMPLER_RING_FRAMES 16384
+#define SAMPLER_CHUNK_FRAMES 2048 // read from disk at a time
+#define SAMPLER_MAX_FILE_CHANNELS 8
+#define SAMPLER_MAX_STEP 4 // playback rate limit, two octaves above the root
+#define SAMPLER_BLOCK_FRAMES 64
+#define SAMPLER_RELEASE_SECONDS 0.2f
+
+enum
+{
+    SAMPLER_STREAM_IDLE,
+    SAMPLER_STREAM_START,
+    SAMPLER_STREAM_STREAMING,
+    SAMPLER_STREAM_STOP,
+};
+
+typedef struct SamplerSample
+{
+    char*   path;
+    WavInfo info;
+    uint8_t rootNote;
+    uint8_t lowNote;
+    uint8_t highNote;
+    int     headFrames;
+    float*  head; // headFrames stereo frames
+} SamplerSample;
+
+typedef struct SamplerVoice
+{
+    // Owned by the audio thread
+    int      sample; // or -1 if the voice is free
+    uint8_t  note;
+    unsigned frame; // play position, whole frames & fraction
+    float    frac;
+    float    step;
+    float    gain;
+    float    level;   // release fade, 1 while held
+    float    release; // fade per frame, 0 while held
+    // Source frames taken from the head & ring so far, dropped ones included. The last two are kept for
+    // interpolating across blocks
+    unsigned fetched;
+    float    last[4];
+
+    // Owned by the prefetch thread
+    FILE*    file;
+    unsigned nextFrame; // next frame to read from the file
+
+    // Shared
+    int                 streamSample; // set by the audio thread before START, kept until IDLE
+    SpscRing            ring;         // stereo frames, prefetch thread to audio thread
+    thread_atomic_int_t state;
+} SamplerVoice;
+
+typedef struct Sampler
+{
+    float         sampleRate;
+    int           numSamples;
+    SamplerSample samples[SAMPLER_MAX_SAMPLES];
+    SamplerVoice  voices[SAMPLER_MAX_VOICES];
+    // One voice's source frames for a block, stereo
+    float scratch[2 * (SAMPLER_BLOCK_FRAMES * SAMPLER_MAX_STEP + 4)];
+    // Prefetch thread buffers, a chunk as read & as stereo
+    float* fileChunk;
+    float* stereoChunk;
+
+    thread_ptr_t        thread;
+    thread_signal_t     wake;
+    thread_atomic_int_t sleeping;
+    thread_atomic_int_t exit;
+    // Bumped by the audio thread whenever the prefetch thread has work
+    thread_atomic_int_t requests;
+    thread_atomic_int_t underruns;
+
+    void* memory;
+} Sampler;
+
+// Allocates the rings & starts the prefetch thread. Returns 0 on success, non zero if out of memory
+int  sampler_init(Sampler* sampler, float sampleRate);
+void sampler_free(Sampler* sampler);
+// Loads a sample's head & maps it to lowNote - highNote, played at its own pitch on rootNote.
+// Call before the sampler is handed to the audio thread. Returns 0 on success, non zero if the file can't be read
+int sampler_add_sample(Sampler* sampler, const char* path, int rootNote, int lowNote, int highNote);
+
+// Audio thread. Returns 1 if a sample is mapped to the note
+int  sampler_has_note(const Sampler* sampler, uint8_t note);
+void sampler_note_on(Sampler* sampler, uint8_t note, uint8_t velocity);
+void sampler_note_off(Sampler* sampler, uint8_t note);
+void sampler_all_notes_off(Sampler* sampler);
+// Adds the playing voices to 2 planar channels
+void sampler_process(Sampler* sampler, float* const* out, int numFrames);
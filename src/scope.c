@@ -0,0 +1,88 @@
+#include "scope.h"
+
+#include <assert.h>
+#include <string.h>
+
+void scope_init(Scope* sc)
+{
+    int offset = 0;
+
+    memset(sc, 0, sizeof(*sc));
+    sc->levels[0].mins = sc->samples;
+    sc->levels[0].maxs = sc->samples;
+    sc->levels[0].mask = SCOPE_HISTORY - 1;
+    for (int l = 1; l < SCOPE_NUM_LEVELS; l++)
+    {
+        sc->levels[l].mins = sc->mins + offset;
+        sc->levels[l].maxs = sc->maxs + offset;
+        sc->levels[l].mask = (SCOPE_HISTORY >> l) - 1;
+        offset             += SCOPE_HISTORY >> l;
+    }
+}
+
+static void scope_push_sample(Scope* sc, float sample)
+{
+    ScopeLevel* lv = sc->levels;
+
+    lv[0].mins[lv[0].count & lv[0].mask] = sample;
+    lv[0].count++;
+    // Every second entry at one level completes an entry at the next
+    for (int l = 1; l < SCOPE_NUM_LEVELS && (lv[l - 1].count & 1) == 0; l++)
+    {
+        const ScopeLevel* below = &lv[l - 1];
+        unsigned          a     = (below->count - 2) & below->mask;
+        unsigned          b     = (below->count - 1) & below->mask;
+        unsigned          i     = lv[l].count & lv[l].mask;
+
+        lv[l].mins[i] = below->mins[a] < below->mins[b] ? below->mins[a] : below->mins[b];
+        lv[l].maxs[i] = below->maxs[a] > below->maxs[b] ? below->maxs[a] : below->maxs[b];
+        lv[l].count++;
+    }
+}
+
+void scope_push(Scope* sc, const float* frames, int numFrames, int numChannels)
+{
+    const float scale = 1.0f / (float)numChannels;
+
+    for (int i = 0; i < numFrames; i++, frames += numChannels)
+    {
+        float sum = 0;
+        for (int c = 0; c < numChannels; c++)
+            sum += frames[c];
+        scope_push_sample(sc, sum * scale);
+    }
+}
+
+void scope_view(const Scope* sc, int numSamples, float* mins, float* maxs, int numColumns)
+{
+    int level = 0;
+
+    assert(numSamples > 0 && numSamples <= SCOPE_HISTORY);
+    assert(numColumns > 0 && numColumns <= SCOPE_MAX_COLUMNS);
+    // The coarsest level that still has an entry for every column
+    while (level < SCOPE_NUM_LEVELS - 1 && (numSamples >> (level + 1)) >= numColumns)
+        level++;
+
+    const ScopeLevel* lv         = &sc->levels[level];
+    const int         numEntries = numSamples >> level;
+    const unsigned    first      = lv->count - (unsigned)numEntries;
+
+    for (int c = 0; c < numColumns; c++)
+    {
+        int begin = (int)((long long)c * numEntries / numColumns);
+        int end   = (int)((long long)(c + 1) * numEntries / numColumns);
+        end       = end < numEntries - 1 ? end : numEntries - 1;
+
+        unsigned i  = (first + (unsigned)begin) & lv->mask;
+        float    lo = lv->mins[i];
+        float    hi = lv->maxs[i];
+        for (int e = begin + 1; e <= end; e++)
+        {
+            i  = (first + (unsigned)e) & lv->mask;
+            lo = lv->mins[i] < lo ? lv->mins[i] : lo;
+            hi = lv->maxs[i] > hi ? lv->maxs[i] : hi;
+        }
+        mins[c] = lo;
+        maxs[c] = hi;
+    }
+}
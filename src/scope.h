@@ -0,0 +1,35 @@
+#pragma once
+
+// Oscilloscope history for the UI thread, fed with output tapped from the audio thread.
+// Keeps the last SCOPE_HISTORY samples of a mono mix plus a pyramid of min/max summaries above them: each level's
+// entries cover twice the samples of the level below, built from pairs of its entries as they complete. A view of
+// any span reads the coarsest level with at least one entry per column, so each column combines only a few entries
+// & drawing costs the same at every zoom.
+
+#define SCOPE_HISTORY (1 << 18)
+#define SCOPE_NUM_LEVELS 13 // entries of 1 to 4096 samples
+#define SCOPE_MAX_COLUMNS 2048
+
+typedef struct ScopeLevel
+{
+    float*   mins; // rings of SCOPE_HISTORY >> level entries
+    float*   maxs;
+    unsigned mask;
+    unsigned count; // entries ever written
+} ScopeLevel;
+
+typedef struct Scope
+{
+    ScopeLevel levels[SCOPE_NUM_LEVELS];
+    float      samples[SCOPE_HISTORY]; // level 0, where an entry's min & max are the sample
+    float      mins[SCOPE_HISTORY];    // levels 1 & up, each half the size of the last
+    float      maxs[SCOPE_HISTORY];
+} Scope;
+
+void scope_init(Scope* sc);
+// Adds numFrames interleaved frames of numChannels
+void scope_push(Scope* sc, const float* frames, int numFrames, int numChannels);
+// Splits the newest numSamples, at most SCOPE_HISTORY, into numColumns columns, oldest first, & writes the lowest
+// & highest sample in each. Neighbouring columns share an entry so they join into one trace.
+// numColumns is at most SCOPE_MAX_COLUMNS
+void scope_view(const Scope* sc, int numSamples, float* mins, float* maxs, int numColumns);
@@ -0,0 +1,332 @@
+#pragma once
+// Tiny SIMD wrapper used by the DSP kernels.
+// SIMD_WIDTH is the number of float lanes in simd_f for the instruction set we were compiled for:
+//   AVX2 (8), SSE2 (4), NEON (4) or plain C (1).
+// Kernels are written once against these functions and process SIMD_WIDTH voices/channels per instruction.
+// AVX2 is opt in, see SOKOLTEST_AVX2 in CMakeLists.txt. Define SIMD_SCALAR to force the plain C fallback
+
+#if defined(_MSC_VER)
+#define SIMD_ALIGNED __declspec(align(32))
+#define SIMD_INLINE static __forceinline
+#else
+#define SIMD_ALIGNED __attribute__((aligned(32)))
+#define SIMD_INLINE static inline __attribute__((always_inline))
+#endif
+
+#if defined(SIMD_SCALAR)
+// forced
+#elif defined(__AVX2__)
+#define SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#else
+#define SIMD_SCALAR 1
+#endif
+
+#if defined(SIMD_AVX2)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+#define SIMD_NAME "avx2"
+typedef __m256 simd_f;
+typedef __m256 simd_m;
+
+SIMD_INLINE simd_f simd_set1(float x) { return _mm256_set1_ps(x); }
+SIMD_INLINE simd_f simd_load(const float* p) { return _mm256_load_ps(p); }
+SIMD_INLINE simd_f simd_loadu(const float* p) { return _mm256_loadu_ps(p); }
+SIMD_INLINE void   simd_store(float* p, simd_f x) { _mm256_store_ps(p, x); }
+SIMD_INLINE void   simd_storeu(float* p, simd_f x) { _mm256_storeu_ps(p, x); }
+SIMD_INLINE simd_f simd_add(simd_f a, simd_f b) { return _mm256_add_ps(a, b); }
+SIMD_INLINE simd_f simd_sub(simd_f a, simd_f b) { return _mm256_sub_ps(a, b); }
+SIMD_INLINE simd_f simd_mul(simd_f a, simd_f b) { return _mm256_mul_ps(a, b); }
+SIMD_INLINE simd_f simd_div(simd_f a, simd_f b) { return _mm256_div_ps(a, b); }
+SIMD_INLINE simd_f simd_min(simd_f a, simd_f b) { return _mm256_min_ps(a, b); }
+SIMD_INLINE simd_f simd_max(simd_f a, simd_f b) { return _mm256_max_ps(a, b); }
+SIMD_INLINE simd_f simd_trunc(simd_f x) { return _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+SIMD_INLINE simd_f simd_abs(simd_f x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+SIMD_INLINE simd_m simd_cmplt(simd_f a, simd_f b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+SIMD_INLINE simd_m simd_cmpge(simd_f a, simd_f b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+SIMD_INLINE simd_f simd_select(simd_m m, simd_f a, simd_f b) { return _mm256_blendv_ps(b, a, m); }
+SIMD_INLINE simd_f simd_and(simd_m m, simd_f a) { return _mm256_and_ps(m, a); }
+SIMD_INLINE simd_f simd_floor(simd_f x) { return _mm256_floor_ps(x); }
+// x * 2^n, for whole numbers n where the result stays a normal float
+SIMD_INLINE simd_f simd_ldexp(simd_f x, simd_f n)
+{
+    __m256i e = _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23);
+    return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(x), e));
+}
+// Splits a positive normal x into m * 2^e, returning m in [1, 2)
+SIMD_INLINE simd_f simd_mantissa(simd_f x, simd_f* e)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    *e           = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    bits         = _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff));
+    bits         = _mm256_or_si256(bits, _mm256_set1_epi32(0x3f800000));
+    return _mm256_castsi256_ps(bits);
+}
+// Interleaves a & b: lo = a0 b0 a1 b1 a2 b2 a3 b3, hi = a4 b4 ... a7 b7
+SIMD_INLINE void simd_zip(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    __m256 l = _mm256_unpacklo_ps(a, b);
+    __m256 h = _mm256_unpackhi_ps(a, b);
+    *lo      = _mm256_permute2f128_ps(l, h, 0x20);
+    *hi      = _mm256_permute2f128_ps(l, h, 0x31);
+}
+// Inverse of simd_zip(): a = lo0 lo2 lo4 lo6 hi0 hi2 hi4 hi6, b = the odd elements
+SIMD_INLINE void simd_unzip(simd_f lo, simd_f hi, simd_f* a, simd_f* b)
+{
+    // Shuffles stay within 128 bit halves, so the 64 bit pairs are put back in order after
+    __m256d e = _mm256_castps_pd(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m256d o = _mm256_castps_pd(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+    *a        = _mm256_castpd_ps(_mm256_permute4x64_pd(e, _MM_SHUFFLE(3, 1, 2, 0)));
+    *b        = _mm256_castpd_ps(_mm256_permute4x64_pd(o, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+SIMD_INLINE simd_f simd_reverse(simd_f x)
+{
+    return _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+// Interleaves the halves of a & b: lo = a0 a1 a2 a3 b0 b1 b2 b3, hi = a4 a5 a6 a7 b4 b5 b6 b7
+SIMD_INLINE void simd_zip_halves(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = _mm256_permute2f128_ps(a, b, 0x20);
+    *hi = _mm256_permute2f128_ps(a, b, 0x31);
+}
+SIMD_INLINE float  simd_hsum(simd_f x)
+{
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    lo        = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo        = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    return _mm_cvtss_f32(lo);
+}
+
+#elif defined(SIMD_SSE2)
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+#define SIMD_NAME "sse2"
+typedef __m128 simd_f;
+typedef __m128 simd_m;
+
+SIMD_INLINE simd_f simd_set1(float x) { return _mm_set1_ps(x); }
+SIMD_INLINE simd_f simd_load(const float* p) { return _mm_load_ps(p); }
+SIMD_INLINE simd_f simd_loadu(const float* p) { return _mm_loadu_ps(p); }
+SIMD_INLINE void   simd_store(float* p, simd_f x) { _mm_store_ps(p, x); }
+SIMD_INLINE void   simd_storeu(float* p, simd_f x) { _mm_storeu_ps(p, x); }
+SIMD_INLINE simd_f simd_add(simd_f a, simd_f b) { return _mm_add_ps(a, b); }
+SIMD_INLINE simd_f simd_sub(simd_f a, simd_f b) { return _mm_sub_ps(a, b); }
+SIMD_INLINE simd_f simd_mul(simd_f a, simd_f b) { return _mm_mul_ps(a, b); }
+SIMD_INLINE simd_f simd_div(simd_f a, simd_f b) { return _mm_div_ps(a, b); }
+SIMD_INLINE simd_f simd_min(simd_f a, simd_f b) { return _mm_min_ps(a, b); }
+SIMD_INLINE simd_f simd_max(simd_f a, simd_f b) { return _mm_max_ps(a, b); }
+// Only valid for |x| < 2^31, which is all we ever need for phases
+SIMD_INLINE simd_f simd_trunc(simd_f x) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(x)); }
+SIMD_INLINE simd_f simd_abs(simd_f x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+SIMD_INLINE simd_m simd_cmplt(simd_f a, simd_f b) { return _mm_cmplt_ps(a, b); }
+SIMD_INLINE simd_m simd_cmpge(simd_f a, simd_f b) { return _mm_cmpge_ps(a, b); }
+SIMD_INLINE simd_f simd_select(simd_m m, simd_f a, simd_f b)
+{
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+SIMD_INLINE simd_f simd_and(simd_m m, simd_f a) { return _mm_and_ps(m, a); }
+SIMD_INLINE simd_f simd_floor(simd_f x)
+{
+    simd_f t = simd_trunc(x);
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+// x * 2^n, for whole numbers n where the result stays a normal float
+SIMD_INLINE simd_f simd_ldexp(simd_f x, simd_f n)
+{
+    __m128i e = _mm_slli_epi32(_mm_cvtps_epi32(n), 23);
+    return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(x), e));
+}
+// Splits a positive normal x into m * 2^e, returning m in [1, 2)
+SIMD_INLINE simd_f simd_mantissa(simd_f x, simd_f* e)
+{
+    __m128i bits = _mm_castps_si128(x);
+    *e           = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    bits         = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000));
+    return _mm_castsi128_ps(bits);
+}
+// Interleaves a & b: lo = a0 b0 a1 b1, hi = a2 b2 a3 b3
+SIMD_INLINE void simd_zip(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = _mm_unpacklo_ps(a, b);
+    *hi = _mm_unpackhi_ps(a, b);
+}
+// Inverse of simd_zip(): a = lo0 lo2 hi0 hi2, b = lo1 lo3 hi1 hi3
+SIMD_INLINE void simd_unzip(simd_f lo, simd_f hi, simd_f* a, simd_f* b)
+{
+    *a = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *b = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+SIMD_INLINE simd_f simd_reverse(simd_f x) { return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3)); }
+// Interleaves the halves of a & b: lo = a0 a1 b0 b1, hi = a2 a3 b2 b3
+SIMD_INLINE void simd_zip_halves(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = _mm_movelh_ps(a, b);
+    *hi = _mm_movehl_ps(b, a);
+}
+SIMD_INLINE float  simd_hsum(simd_f x)
+{
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+}
+
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#define SIMD_WIDTH 4
+#define SIMD_NAME "neon"
+typedef float32x4_t simd_f;
+typedef uint32x4_t  simd_m;
+
+SIMD_INLINE simd_f simd_set1(float x) { return vdupq_n_f32(x); }
+SIMD_INLINE simd_f simd_load(const float* p) { return vld1q_f32(p); }
+SIMD_INLINE simd_f simd_loadu(const float* p) { return vld1q_f32(p); }
+SIMD_INLINE void   simd_store(float* p, simd_f x) { vst1q_f32(p, x); }
+SIMD_INLINE void   simd_storeu(float* p, simd_f x) { vst1q_f32(p, x); }
+SIMD_INLINE simd_f simd_add(simd_f a, simd_f b) { return vaddq_f32(a, b); }
+SIMD_INLINE simd_f simd_sub(simd_f a, simd_f b) { return vsubq_f32(a, b); }
+SIMD_INLINE simd_f simd_mul(simd_f a, simd_f b) { return vmulq_f32(a, b); }
+SIMD_INLINE simd_f simd_div(simd_f a, simd_f b) { return vdivq_f32(a, b); }
+SIMD_INLINE simd_f simd_min(simd_f a, simd_f b) { return vminq_f32(a, b); }
+SIMD_INLINE simd_f simd_max(simd_f a, simd_f b) { return vmaxq_f32(a, b); }
+SIMD_INLINE simd_f simd_trunc(simd_f x) { return vrndq_f32(x); }
+SIMD_INLINE simd_f simd_abs(simd_f x) { return vabsq_f32(x); }
+SIMD_INLINE simd_m simd_cmplt(simd_f a, simd_f b) { return vcltq_f32(a, b); }
+SIMD_INLINE simd_m simd_cmpge(simd_f a, simd_f b) { return vcgeq_f32(a, b); }
+SIMD_INLINE simd_f simd_select(simd_m m, simd_f a, simd_f b) { return vbslq_f32(m, a, b); }
+SIMD_INLINE simd_f simd_and(simd_m m, simd_f a)
+{
+    return vreinterpretq_f32_u32(vandq_u32(m, vreinterpretq_u32_f32(a)));
+}
+SIMD_INLINE simd_f simd_floor(simd_f x) { return vrndmq_f32(x); }
+// x * 2^n, for whole numbers n where the result stays a normal float
+SIMD_INLINE simd_f simd_ldexp(simd_f x, simd_f n)
+{
+    int32x4_t e = vshlq_n_s32(vcvtq_s32_f32(n), 23);
+    return vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(x), e));
+}
+// Splits a positive normal x into m * 2^e, returning m in [1, 2)
+SIMD_INLINE simd_f simd_mantissa(simd_f x, simd_f* e)
+{
+    uint32x4_t bits = vreinterpretq_u32_f32(x);
+    *e              = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+    bits            = vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000));
+    return vreinterpretq_f32_u32(bits);
+}
+SIMD_INLINE float  simd_hsum(simd_f x) { return vaddvq_f32(x); }
+SIMD_INLINE void simd_zip(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = vzip1q_f32(a, b);
+    *hi = vzip2q_f32(a, b);
+}
+SIMD_INLINE void simd_unzip(simd_f lo, simd_f hi, simd_f* a, simd_f* b)
+{
+    *a = vuzp1q_f32(lo, hi);
+    *b = vuzp2q_f32(lo, hi);
+}
+SIMD_INLINE simd_f simd_reverse(simd_f x)
+{
+    x = vrev64q_f32(x);
+    return vcombine_f32(vget_high_f32(x), vget_low_f32(x));
+}
+SIMD_INLINE void simd_zip_halves(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = vcombine_f32(vget_low_f32(a), vget_low_f32(b));
+    *hi = vcombine_f32(vget_high_f32(a), vget_high_f32(b));
+}
+
+#else
+#define SIMD_WIDTH 1
+#define SIMD_NAME "scalar"
+typedef float simd_f;
+typedef int   simd_m;
+
+SIMD_INLINE simd_f simd_set1(float x) { return x; }
+SIMD_INLINE simd_f simd_load(const float* p) { return *p; }
+SIMD_INLINE simd_f simd_loadu(const float* p) { return *p; }
+SIMD_INLINE void   simd_store(float* p, simd_f x) { *p = x; }
+SIMD_INLINE void   simd_storeu(float* p, simd_f x) { *p = x; }
+SIMD_INLINE simd_f simd_add(simd_f a, simd_f b) { return a + b; }
+SIMD_INLINE simd_f simd_sub(simd_f a, simd_f b) { return a - b; }
+SIMD_INLINE simd_f simd_mul(simd_f a, simd_f b) { return a * b; }
+SIMD_INLINE simd_f simd_div(simd_f a, simd_f b) { return a / b; }
+SIMD_INLINE simd_f simd_min(simd_f a, simd_f b) { return a < b ? a : b; }
+SIMD_INLINE simd_f simd_max(simd_f a, simd_f b) { return a > b ? a : b; }
+SIMD_INLINE simd_f simd_trunc(simd_f x) { return (float)(int)x; }
+SIMD_INLINE simd_f simd_abs(simd_f x) { return x < 0 ? -x : x; }
+SIMD_INLINE simd_m simd_cmplt(simd_f a, simd_f b) { return a < b; }
+SIMD_INLINE simd_m simd_cmpge(simd_f a, simd_f b) { return a >= b; }
+SIMD_INLINE simd_f simd_select(simd_m m, simd_f a, simd_f b) { return m ? a : b; }
+SIMD_INLINE simd_f simd_and(simd_m m, simd_f a) { return m ? a : 0.0f; }
+SIMD_INLINE simd_f simd_floor(simd_f x)
+{
+    float t = (float)(int)x;
+    return t > x ? t - 1.0f : t;
+}
+// x * 2^n, for whole numbers n where the result stays a normal float
+SIMD_INLINE simd_f simd_ldexp(simd_f x, simd_f n)
+{
+    union
+    {
+        float        f;
+        unsigned int u;
+    } bits = {x};
+    bits.u += (unsigned int)(int)n << 23;
+    return bits.f;
+}
+// Splits a positive normal x into m * 2^e, returning m in [1, 2)
+SIMD_INLINE simd_f simd_mantissa(simd_f x, simd_f* e)
+{
+    union
+    {
+        float        f;
+        unsigned int u;
+    } bits = {x};
+    *e     = (float)((int)(bits.u >> 23) - 127);
+    bits.u = (bits.u & 0x007fffff) | 0x3f800000;
+    return bits.f;
+}
+SIMD_INLINE float  simd_hsum(simd_f x) { return x; }
+SIMD_INLINE void simd_zip(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = a;
+    *hi = b;
+}
+SIMD_INLINE void simd_unzip(simd_f lo, simd_f hi, simd_f* a, simd_f* b)
+{
+    *a = lo;
+    *b = hi;
+}
+SIMD_INLINE simd_f simd_reverse(simd_f x) { return x; }
+SIMD_INLINE void simd_zip_halves(simd_f a, simd_f b, simd_f* lo, simd_f* hi)
+{
+    *lo = a;
+    *hi = b;
+}
+#endif
+
+#if defined(SIMD_AVX2) && (defined(__FMA__) || defined(_MSC_VER))
+SIMD_INLINE simd_f simd_fmadd(simd_f a, simd_f b, simd_f c) { return _mm256_fmadd_ps(a, b, c); }
+#elif defined(SIMD_NEON)
+SIMD_INLINE simd_f simd_fmadd(simd_f a, simd_f b, simd_f c) { return vfmaq_f32(c, a, b); }
+#else
+// a * b + c
+SIMD_INLINE simd_f simd_fmadd(simd_f a, simd_f b, simd_f c) { return simd_add(simd_mul(a, b), c); }
+#endif
+
+// Flushes denormals to zero on the calling thread. Decaying filter states & tails otherwise spend a long time in
+// the denormal range, where every multiply involving one can be ~100x slower. Call at the start of each audio thread
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+SIMD_INLINE void simd_flush_denormals(void) { _mm_setcsr(_mm_getcsr() | 0x8040); } // FTZ | DAZ
+#elif defined(SIMD_NEON) && defined(__aarch64__)
+SIMD_INLINE void simd_flush_denormals(void)
+{
+    unsigned long long fpcr;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ volatile("msr fpcr, %0" : : "r"(fpcr | (1ull << 24))); // FZ
+}
+#else
+SIMD_INLINE void simd_flush_denormals(void) {}
+#endif
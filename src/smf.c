@@ -0,0 +1,282 @@
+#include "smf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct SmfReader
+{
+    const uint8_t* pos;
+    const uint8_t* end;
+    int            error;
+} SmfReader;
+
+// Events before tempo conversion
+typedef struct SmfRawEvent
+{
+    uint64_t tick;
+    int      order; // position in the file, keeps events at the same tick in order
+    uint32_t tempo; // microseconds per quarter note if this is a tempo change, otherwise 0
+    uint8_t  status;
+    uint8_t  data1;
+    uint8_t  data2;
+} SmfRawEvent;
+
+typedef struct SmfRawEvents
+{
+    SmfRawEvent* events;
+    int          num;
+    int          cap;
+} SmfRawEvents;
+
+static uint32_t smf_read_bytes(SmfReader* r, int n)
+{
+    uint32_t v = 0;
+    if (r->end - r->pos < n)
+    {
+        r->error = 1;
+        r->pos   = r->end;
+        return 0;
+    }
+    for (int i = 0; i < n; i++)
+        v = (v << 8) | *r->pos++;
+    return v;
+}
+
+static uint32_t smf_read_varlen(SmfReader* r)
+{
+    uint32_t v = 0;
+    // At most 4 bytes
+    for (int i = 0; i < 4; i++)
+    {
+        uint32_t b = smf_read_bytes(r, 1);
+        v          = (v << 7) | (b & 0x7f);
+        if ((b & 0x80) == 0)
+            return v;
+    }
+    r->error = 1;
+    return v;
+}
+
+static void smf_skip(SmfReader* r, uint32_t n)
+{
+    if ((uint32_t)(r->end - r->pos) < n)
+    {
+        r->error = 1;
+        r->pos   = r->end;
+        return;
+    }
+    r->pos += n;
+}
+
+static int smf_push(SmfRawEvents* list, SmfRawEvent* e)
+{
+    if (list->num == list->cap)
+    {
+        int          cap    = list->cap ? list->cap * 2 : 1024;
+        SmfRawEvent* events = realloc(list->events, cap * sizeof(*events));
+        if (! events)
+            return SMF_ERROR_MEMORY;
+        list->events = events;
+        list->cap    = cap;
+    }
+    e->order                  = list->num;
+    list->events[list->num++] = *e;
+    return SMF_OK;
+}
+
+static int smf_read_track(SmfReader* r, SmfRawEvents* list)
+{
+    uint64_t tick          = 0;
+    uint8_t  runningStatus = 0;
+
+    while (r->pos < r->end && ! r->error)
+    {
+        SmfRawEvent e = {0};
+        uint8_t     status;
+
+        tick   += smf_read_varlen(r);
+        e.tick = tick;
+        status = (uint8_t)smf_read_bytes(r, 1);
+
+        if (status == 0xff)
+        {
+            uint8_t  type = (uint8_t)smf_read_bytes(r, 1);
+            uint32_t len  = smf_read_varlen(r);
+            if (type == 0x2f) // end of track
+                return SMF_OK;
+            if (type == 0x51 && len == 3)
+            {
+                e.tempo = smf_read_bytes(r, 3);
+                if (smf_push(list, &e) != SMF_OK)
+                    return SMF_ERROR_MEMORY;
+                continue;
+            }
+            smf_skip(r, len);
+            continue;
+        }
+        if (status == 0xf0 || status == 0xf7)
+        {
+            smf_skip(r, smf_read_varlen(r));
+            continue;
+        }
+
+        if (status & 0x80)
+        {
+            runningStatus = status;
+            e.data1       = (uint8_t)smf_read_bytes(r, 1);
+        }
+        else
+        {
+            // Running status. The byte we read was the first data byte
+            if (runningStatus == 0)
+                return SMF_ERROR_FORMAT;
+            e.data1 = status;
+        }
+        e.status = runningStatus;
+        // Program change & channel pressure have one data byte
+        if ((e.status & 0xf0) != 0xc0 && (e.status & 0xf0) != 0xd0)
+            e.data2 = (uint8_t)smf_read_bytes(r, 1);
+        if (smf_push(list, &e) != SMF_OK)
+            return SMF_ERROR_MEMORY;
+    }
+    return r->error ? SMF_ERROR_FORMAT : SMF_OK;
+}
+
+static int smf_compare(const void* a, const void* b)
+{
+    const SmfRawEvent* x = a;
+    const SmfRawEvent* y = b;
+    if (x->tick != y->tick)
+        return x->tick < y->tick ? -1 : 1;
+    return x->order - y->order;
+}
+
+static int smf_parse(SmfFile* smf, const uint8_t* data, long size, SmfRawEvents* list)
+{
+    SmfReader r = {data, data + size, 0};
+    uint32_t  headerLen, numTracks, division;
+    double    secondsPerTick;
+    double    seconds  = 0;
+    uint64_t  lastTick = 0;
+    int       numOut   = 0;
+
+    if (smf_read_bytes(&r, 4) != 0x4d546864) // "MThd"
+        return SMF_ERROR_FORMAT;
+    headerLen = smf_read_bytes(&r, 4);
+    if (headerLen < 6)
+        return SMF_ERROR_FORMAT;
+    if (smf_read_bytes(&r, 2) > 1)
+        return SMF_ERROR_FORMAT; // format 2 files hold independent sequences
+    numTracks = smf_read_bytes(&r, 2);
+    division  = smf_read_bytes(&r, 2);
+    // Later versions of the format may add fields to the header
+    smf_skip(&r, headerLen - 6);
+    if (r.error || division == 0)
+        return SMF_ERROR_FORMAT;
+
+    for (uint32_t t = 0; t < numTracks && r.pos < r.end; t++)
+    {
+        uint32_t  id  = smf_read_bytes(&r, 4);
+        uint32_t  len = smf_read_bytes(&r, 4);
+        SmfReader track;
+        int       err;
+
+        if (r.error || (uint32_t)(r.end - r.pos) < len)
+            return SMF_ERROR_FORMAT;
+        track = (SmfReader){r.pos, r.pos + len, 0};
+        r.pos += len;
+        // Unknown chunks must be ignored
+        if (id != 0x4d54726b) // "MTrk"
+            continue;
+        err = smf_read_track(&track, list);
+        if (err != SMF_OK)
+            return err;
+    }
+
+    qsort(list->events, list->num, sizeof(*list->events), smf_compare);
+
+    if (division & 0x8000)
+    {
+        // SMPTE: frames per second in the upper byte (negative), ticks per frame in the lower
+        int fps        = -(int8_t)(division >> 8);
+        secondsPerTick = 1.0 / ((double)fps * (double)(division & 0xff));
+    }
+    else
+    {
+        // 120bpm until told otherwise
+        secondsPerTick = 0.5 / (double)division;
+    }
+
+    smf->events = malloc((list->num ? list->num : 1) * sizeof(*smf->events));
+    if (! smf->events)
+        return SMF_ERROR_MEMORY;
+    for (int i = 0; i < list->num; i++)
+    {
+        const SmfRawEvent* e = &list->events[i];
+
+        seconds  += (double)(e->tick - lastTick) * secondsPerTick;
+        lastTick = e->tick;
+        if (e->tempo != 0)
+        {
+            if (! (division & 0x8000))
+                secondsPerTick = (double)e->tempo * 1e-6 / (double)division;
+            continue;
+        }
+        smf->events[numOut].seconds = seconds;
+        smf->events[numOut].status  = e->status;
+        smf->events[numOut].data1   = e->data1;
+        smf->events[numOut].data2   = e->data2;
+        numOut++;
+    }
+    smf->numEvents     = numOut;
+    smf->lengthSeconds = seconds;
+    return SMF_OK;
+}
+
+int smf_load(SmfFile* smf, const char* path)
+{
+    SmfRawEvents list = {0};
+    uint8_t*     data;
+    long         size;
+    int          err;
+    FILE*        f = fopen(path, "rb");
+
+    memset(smf, 0, sizeof(*smf));
+    if (! f)
+        return SMF_ERROR_OPEN;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0)
+    {
+        fclose(f);
+        return SMF_ERROR_FORMAT;
+    }
+    data = malloc(size);
+    if (! data)
+    {
+        fclose(f);
+        return SMF_ERROR_MEMORY;
+    }
+    if (fread(data, 1, size, f) != (size_t)size)
+    {
+        free(data);
+        fclose(f);
+        return SMF_ERROR_OPEN;
+    }
+    fclose(f);
+
+    err = smf_parse(smf, data, size, &list);
+    free(list.events);
+    free(data);
+    if (err != SMF_OK)
+        smf_free(smf);
+    return err;
+}
+
+void smf_free(SmfFile* smf)
+{
+    free(smf->events);
+    memset(smf, 0, sizeof(*smf));
+}
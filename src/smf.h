@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+// Standard MIDI File reader for offline rendering.
+// Reads format 0 & 1 files, merges all tracks and converts delta times to seconds through the tempo map.
+// Only channel voice messages are kept. Meta & sysex events are skipped.
+
+typedef struct SmfEvent
+{
+    double  seconds;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+} SmfEvent;
+
+typedef struct SmfFile
+{
+    SmfEvent* events; // sorted by time
+    int       numEvents;
+    double    lengthSeconds;
+} SmfFile;
+
+enum SmfError
+{
+    SMF_OK,
+    SMF_ERROR_OPEN,
+    SMF_ERROR_FORMAT,
+    SMF_ERROR_MEMORY,
+};
+
+// Returns SMF_OK on success. Allocates, so don't call it from the audio thread
+int  smf_load(SmfFile* smf, const char* path);
+void smf_free(SmfFile* smf);
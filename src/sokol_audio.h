@@ -565,6 +565,24 @@ typedef struct saudio_desc
     saudio_logger    logger;    // optional logging function (default: NO LOGGING!)
 } saudio_desc;
 
+/*
+    saudio_load_stats
+
+    Every stream callback is timed against its real-time budget (num_frames / sample_rate), giving a load
+    of 0 (idle) to 1 (deadline reached). Callbacks above 1 were late and counted as xruns.
+    The audio thread updates the counters with atomics, so they can be read from any thread without locks.
+*/
+#define SAUDIO_LOAD_HISTOGRAM_BINS (11)
+typedef struct saudio_load_stats
+{
+    uint32_t num_callbacks;
+    uint32_t num_xruns;  // callbacks that took longer than the audio they rendered
+    float    last_load;  // load of the most recent callback
+    float    peak_load;  // highest load since setup or saudio_reset_load_peak()
+    // bins 0-9 count loads in 10% steps up to & including 1, bin 10 counts late callbacks (the xruns)
+    uint32_t histogram[SAUDIO_LOAD_HISTOGRAM_BINS];
+} saudio_load_stats;
+
 /* setup sokol-audio */
 SOKOL_AUDIO_API_DECL void saudio_setup(const saudio_desc* desc);
 /* shutdown sokol-audio */
@@ -583,6 +601,13 @@ SOKOL_AUDIO_API_DECL int saudio_buffer_frames(void);
 SOKOL_AUDIO_API_DECL int saudio_channels(void);
 /* return true if audio context is currently suspended (only in WebAudio backend, all other backends return false) */
 SOKOL_AUDIO_API_DECL bool saudio_suspended(void);
+/* load meter: how long stream callbacks take compared to the audio they render, see saudio_load_stats */
+SOKOL_AUDIO_API_DECL saudio_load_stats saudio_query_load(void);
+/* restart the peak load, e.g. after showing it */
+SOKOL_AUDIO_API_DECL void saudio_reset_load_peak(void);
+/* dummy backend only: runs the stream callback for num_frames frames of interleaved output, as fast as the caller
+   likes. Returns the number of frames rendered, 0 with a real backend or no callback */
+SOKOL_AUDIO_API_DECL int saudio_dummy_pull(float* buffer, int num_frames);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -932,6 +957,34 @@ typedef _saudio_apple_backend_t _saudio_backend_t;
 typedef _saudio_wasapi_backend_t _saudio_backend_t;
 #endif
 
+// load meter clock & atomics
+#if defined(_WIN32)
+#if defined(SOKOL_DUMMY_BACKEND)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+#include <intrin.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+// Callback loads are stored as fixed point in these units
+#define _SAUDIO_LOAD_ONE (10000)
+
+typedef struct
+{
+    uint32_t num_callbacks;
+    uint32_t num_xruns;
+    uint32_t last_load;
+    uint32_t peak_load;
+    uint32_t histogram[SAUDIO_LOAD_HISTOGRAM_BINS];
+    double   ticks_per_sec;
+} _saudio_load_t;
+
 /* a ringbuffer structure */
 typedef struct
 {
@@ -956,14 +1009,96 @@ typedef struct
     int               num_channels;    /* actual number of channels */
     saudio_desc       desc;
     _saudio_backend_t backend;
+    _saudio_load_t    load;
 } _saudio_state_t;
 
 _SOKOL_PRIVATE _saudio_state_t _saudio;
 
 _SOKOL_PRIVATE bool _saudio_has_callback(void) { return (_saudio.stream_cb || _saudio.stream_userdata_cb); }
 
+// >>load meter
+_SOKOL_PRIVATE uint32_t _saudio_atomic_load(uint32_t* p)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)_InterlockedOr((volatile long*)p, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+#endif
+}
+
+_SOKOL_PRIVATE void _saudio_atomic_store(uint32_t* p, uint32_t v)
+{
+#if defined(_MSC_VER)
+    _InterlockedExchange((volatile long*)p, (long)v);
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+// Only the audio thread writes the counters, so a load & store is enough. The atomics stop torn reads
+_SOKOL_PRIVATE void _saudio_atomic_inc(uint32_t* p) { _saudio_atomic_store(p, _saudio_atomic_load(p) + 1); }
+
+_SOKOL_PRIVATE uint64_t _saudio_ticks(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (uint64_t)now.QuadPart;
+#elif defined(__APPLE__)
+    return mach_absolute_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+_SOKOL_PRIVATE void _saudio_load_init(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    _saudio.load.ticks_per_sec = (double)freq.QuadPart;
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t tb;
+    mach_timebase_info(&tb);
+    _saudio.load.ticks_per_sec = 1e9 * (double)tb.denom / (double)tb.numer;
+#else
+    _saudio.load.ticks_per_sec = 1e9;
+#endif
+}
+
+_SOKOL_PRIVATE void _saudio_load_record(uint64_t ticks, int num_frames)
+{
+    _saudio_load_t* l       = &_saudio.load;
+    double          budget  = (double)num_frames / (double)_saudio.sample_rate;
+    double          elapsed = (double)ticks / l->ticks_per_sec;
+    double          load    = budget > 0.0 ? elapsed / budget : 0.0;
+    uint32_t        fixed   = load < 100.0 ? (uint32_t)(load * _SAUDIO_LOAD_ONE) : 100 * _SAUDIO_LOAD_ONE;
+    int             bin     = (int)(load * 10.0);
+
+    // The last bin holds exactly the xruns. A load of 1 is still in time, in the bin below
+    if (load > 1.0)
+    {
+        bin = SAUDIO_LOAD_HISTOGRAM_BINS - 1;
+        _saudio_atomic_inc(&l->num_xruns);
+    }
+    else if (bin > SAUDIO_LOAD_HISTOGRAM_BINS - 2)
+    {
+        bin = SAUDIO_LOAD_HISTOGRAM_BINS - 2;
+    }
+    _saudio_atomic_inc(&l->histogram[bin]);
+    if (fixed > _saudio_atomic_load(&l->peak_load))
+    {
+        _saudio_atomic_store(&l->peak_load, fixed);
+    }
+    _saudio_atomic_store(&l->last_load, fixed);
+    _saudio_atomic_inc(&l->num_callbacks);
+}
+
 _SOKOL_PRIVATE void _saudio_stream_callback(float* buffer, int num_frames, int num_channels)
 {
+    uint64_t start = _saudio_ticks();
     if (_saudio.stream_cb)
     {
         _saudio.stream_cb(buffer, num_frames, num_channels);
@@ -972,6 +1107,7 @@ _SOKOL_PRIVATE void _saudio_stream_callback(float* buffer, int num_frames, int n
     {
         _saudio.stream_userdata_cb(buffer, num_frames, num_channels, _saudio.user_data);
     }
+    _saudio_load_record(_saudio_ticks() - start, num_frames);
 }
 
 // ██       ██████   ██████   ██████  ██ ███    ██  ██████
@@ -1082,6 +1218,17 @@ _SOKOL_PRIVATE bool _saudio_dummy_backend_init(void)
 };
 _SOKOL_PRIVATE void _saudio_dummy_backend_shutdown(void){};
 
+// There's no device, so nothing calls the stream callback unless the app pulls. Used for offline rendering
+_SOKOL_PRIVATE int _saudio_dummy_backend_pull(float* buffer, int num_frames)
+{
+    if (! _saudio_has_callback() || num_frames <= 0)
+    {
+        return 0;
+    }
+    _saudio_stream_callback(buffer, num_frames, _saudio.num_channels);
+    return num_frames;
+}
+
 // ██     ██  █████  ███████  █████  ██████  ██
 // ██     ██ ██   ██ ██      ██   ██ ██   ██ ██
 // ██  █  ██ ███████ ███████ ███████ ██████  ██
@@ -1481,6 +1628,7 @@ SOKOL_API_IMPL void saudio_setup(const saudio_desc* desc)
     _saudio.packet_frames      = _saudio_def(_saudio.desc.packet_frames, _SAUDIO_DEFAULT_PACKET_FRAMES);
     _saudio.num_packets        = _saudio_def(_saudio.desc.num_packets, _SAUDIO_DEFAULT_NUM_PACKETS);
     _saudio.num_channels       = _saudio_def(_saudio.desc.num_channels, 1);
+    _saudio_load_init();
     if (_saudio_backend_init())
     {
         /* the backend might not support the requested exact buffer size,
@@ -1521,6 +1669,37 @@ SOKOL_API_IMPL int saudio_channels(void) { return _saudio.num_channels; }
 
 SOKOL_API_IMPL bool saudio_suspended(void) { return false; }
 
+SOKOL_API_IMPL saudio_load_stats saudio_query_load(void)
+{
+    saudio_load_stats stats;
+    _saudio_clear(&stats, sizeof(stats));
+    stats.num_callbacks = _saudio_atomic_load(&_saudio.load.num_callbacks);
+    stats.num_xruns     = _saudio_atomic_load(&_saudio.load.num_xruns);
+    stats.last_load     = (float)_saudio_atomic_load(&_saudio.load.last_load) / _SAUDIO_LOAD_ONE;
+    stats.peak_load     = (float)_saudio_atomic_load(&_saudio.load.peak_load) / _SAUDIO_LOAD_ONE;
+    for (int i = 0; i < SAUDIO_LOAD_HISTOGRAM_BINS; i++)
+    {
+        stats.histogram[i] = _saudio_atomic_load(&_saudio.load.histogram[i]);
+    }
+    return stats;
+}
+
+SOKOL_API_IMPL void saudio_reset_load_peak(void) { _saudio_atomic_store(&_saudio.load.peak_load, 0); }
+
+SOKOL_API_IMPL int saudio_dummy_pull(float* buffer, int num_frames)
+{
+#if defined(SOKOL_DUMMY_BACKEND)
+    if (_saudio.valid)
+    {
+        return _saudio_dummy_backend_pull(buffer, num_frames);
+    }
+#else
+    _SOKOL_UNUSED(buffer);
+    _SOKOL_UNUSED(num_frames);
+#endif
+    return 0;
+}
+
 #undef _saudio_def
 #undef _saudio_def_flt
 
@@ -0,0 +1,80 @@
+#include "spscring.h"
+
+#include <assert.h>
+#include <string.h>
+
+void spsc_ring_init(SpscRing* ring, float* storage, int capacity)
+{
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    ring->data     = storage;
+    ring->capacity = capacity;
+    thread_atomic_int_store(&ring->writePos, 0);
+    thread_atomic_int_store(&ring->readPos, 0);
+    thread_atomic_int_store(&ring->dropped, 0);
+}
+
+static int spsc_ring_distance(const SpscRing* ring, int from, int to) { return (to - from) & (2 * ring->capacity - 1); }
+
+// Where 'count' values from 'pos' start in 'data', and how many fit before it wraps
+static int spsc_ring_span(const SpscRing* ring, int pos, int count, int* first)
+{
+    int start = pos & (ring->capacity - 1);
+    *first    = ring->capacity - start < count ? ring->capacity - start : count;
+    return start;
+}
+
+int spsc_ring_write(SpscRing* ring, const float* values, int count)
+{
+    int writePos = thread_atomic_int_load(&ring->writePos);
+    int readPos  = thread_atomic_int_load(&ring->readPos);
+
+    if (ring->capacity - spsc_ring_distance(ring, readPos, writePos) < count)
+    {
+        thread_atomic_int_add(&ring->dropped, count);
+        return 0;
+    }
+    int first;
+    int start = spsc_ring_span(ring, writePos, count, &first);
+    memcpy(ring->data + start, values, first * sizeof(float));
+    memcpy(ring->data, values + first, (count - first) * sizeof(float));
+    // Publishes the values. The store is a full barrier, so they're visible before the new position
+    thread_atomic_int_store(&ring->writePos, (writePos + count) & (2 * ring->capacity - 1));
+    return 1;
+}
+
+int spsc_ring_space(SpscRing* ring)
+{
+    int readPos  = thread_atomic_int_load(&ring->readPos);
+    int writePos = thread_atomic_int_load(&ring->writePos);
+    return ring->capacity - spsc_ring_distance(ring, readPos, writePos);
+}
+
+int spsc_ring_available(SpscRing* ring)
+{
+    return spsc_ring_distance(ring, thread_atomic_int_load(&ring->readPos), thread_atomic_int_load(&ring->writePos));
+}
+
+int spsc_ring_read(SpscRing* ring, float* values, int maxCount)
+{
+    int readPos = thread_atomic_int_load(&ring->readPos);
+    int count   = spsc_ring_distance(ring, readPos, thread_atomic_int_load(&ring->writePos));
+
+    count = count < maxCount ? count : maxCount;
+    int first;
+    int start = spsc_ring_span(ring, readPos, count, &first);
+    memcpy(values, ring->data + start, first * sizeof(float));
+    memcpy(values + first, ring->data, (count - first) * sizeof(float));
+    // Hands the space back to the writer once the values are copied out
+    thread_atomic_int_store(&ring->readPos, (readPos + count) & (2 * ring->capacity - 1));
+    return count;
+}
+
+int spsc_ring_skip(SpscRing* ring, int maxCount)
+{
+    int readPos = thread_atomic_int_load(&ring->readPos);
+    int count   = spsc_ring_distance(ring, readPos, thread_atomic_int_load(&ring->writePos));
+
+    count = count < maxCount ? count : maxCount;
+    thread_atomic_int_store(&ring->readPos, (readPos + count) & (2 * ring->capacity - 1));
+    return count;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "thread.h"
+
+// Wait free single producer, single consumer ring of floats, built on the atomics in thread.h.
+// Used to tap audio out of the audio thread for display. Neither side ever blocks or allocates: the writer drops
+// what doesn't fit rather than wait for the reader, and the reader takes whatever has arrived.
+// Positions run over twice the capacity, so a full ring & an empty one look different without a spare slot.
+
+typedef struct SpscRing
+{
+    float*              data;
+    int                 capacity; // power of two
+    thread_atomic_int_t writePos; // [0, 2 * capacity), only stored by the writer
+    thread_atomic_int_t readPos;  // [0, 2 * capacity), only stored by the reader
+    thread_atomic_int_t dropped;  // values the writer couldn't fit
+} SpscRing;
+
+// 'storage' holds 'capacity' floats, a power of two. Call before either thread starts
+void spsc_ring_init(SpscRing* ring, float* storage, int capacity);
+// Writer. Writes all 'count' values, or none if they don't fit so multichannel frames stay whole.
+// Returns 1 if they were written
+int spsc_ring_write(SpscRing* ring, const float* values, int count);
+// Writer. Values that can be written without dropping
+int spsc_ring_space(SpscRing* ring);
+// Reader. Values waiting to be read
+int spsc_ring_available(SpscRing* ring);
+// Reader. Reads up to 'maxCount' values, returning how many were read
+int spsc_ring_read(SpscRing* ring, float* values, int maxCount);
+// Reader. Drops up to 'maxCount' values without copying them, returning how many were dropped
+int spsc_ring_skip(SpscRing* ring, int maxCount);
@@ -0,0 +1,926 @@
+#include "synth.h"
+#include "interleave.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+static void synth_voice_link_newest(SynthVoices* v, int slot)
+{
+    v->older[slot] = v->newest;
+    v->newer[slot] = SYNTH_NO_VOICE;
+    if (v->newest != SYNTH_NO_VOICE)
+        v->newer[v->newest] = slot;
+    else
+        v->oldest = slot;
+    v->newest = slot;
+}
+
+static void synth_voice_unlink(SynthVoices* v, int slot)
+{
+    uint8_t older = v->older[slot];
+    uint8_t newer = v->newer[slot];
+    if (older != SYNTH_NO_VOICE)
+        v->newer[older] = newer;
+    else
+        v->oldest = newer;
+    if (newer != SYNTH_NO_VOICE)
+        v->older[newer] = older;
+    else
+        v->newest = older;
+}
+
+// Frees a slot by moving the last playing voice into it, keeping the pool packed
+static void synth_voice_free(SynthVoices* v, int slot)
+{
+    int last = v->numActive - 1;
+
+    synth_voice_unlink(v, slot);
+    if (v->noteToSlot[v->note[slot]] == slot)
+        v->noteToSlot[v->note[slot]] = SYNTH_NO_VOICE;
+
+    if (slot != last)
+    {
+        v->phase[slot]    = v->phase[last];
+        v->inc[slot]      = v->inc[last];
+        v->gainL[slot]    = v->gainL[last];
+        v->gainR[slot]    = v->gainR[last];
+        v->baseInc[slot]  = v->baseInc[last];
+        v->velocity[slot] = v->velocity[last];
+        v->modGain[slot]  = v->modGain[last];
+        v->envLevel[slot] = v->envLevel[last];
+        v->envStage[slot] = v->envStage[last];
+        v->note[slot]     = v->note[last];
+        v->older[slot]    = v->older[last];
+        v->newer[slot]    = v->newer[last];
+        memcpy(v->stackPhase[slot], v->stackPhase[last], sizeof(v->stackPhase[slot]));
+        svf_bank_copy_lane(&v->filter, slot, last);
+        svf_bank_copy_lane(&v->filterR, slot, last);
+        adsr_bank_copy_lane(&v->amp, slot, last);
+
+        if (v->older[slot] != SYNTH_NO_VOICE)
+            v->newer[v->older[slot]] = slot;
+        else
+            v->oldest = slot;
+        if (v->newer[slot] != SYNTH_NO_VOICE)
+            v->older[v->newer[slot]] = slot;
+        else
+            v->newest = slot;
+        if (v->noteToSlot[v->note[slot]] == last)
+            v->noteToSlot[v->note[slot]] = slot;
+    }
+
+    // Unused slots are silent, so the render loop never needs to check them
+    v->phase[last]    = 0;
+    v->inc[last]      = 0;
+    v->gainL[last]    = 0;
+    v->gainR[last]    = 0;
+    v->baseInc[last]  = 0;
+    v->velocity[last] = 0;
+    v->envLevel[last] = 0;
+    v->envStage[last] = MOD_ENV_IDLE;
+    v->numActive      = last;
+    adsr_bank_reset_lane(&v->amp, last);
+}
+
+// Returns a free slot, stealing the oldest voice if the pool is full
+static int synth_voice_alloc(SynthVoices* v)
+{
+    int slot;
+    if (v->numActive == SYNTH_MAX_VOICES)
+        synth_voice_free(v, v->oldest);
+
+    slot = v->numActive++;
+    synth_voice_link_newest(v, slot);
+    return slot;
+}
+
+static void synth_build_graph(Synth* synth);
+
+void synth_init(Synth* synth, float sampleRate)
+{
+    memset(synth, 0, sizeof(*synth));
+    synth->sampleRate      = sampleRate;
+    synth->shape           = OSC_SQUARE;
+    synth->pulseWidth      = 0.5f;
+    synth->spread          = 0.5f;
+    synth->unison          = 1;
+    synth->detune          = 25.0f;
+    synth->unisonWidth     = 0.7f;
+    synth->random          = 0x9e3779b9u;
+    synth->cutoff          = 1.0f;
+    synth->crossoverCutoff = 0.5f;
+    synth->lastNote        = 0xff;
+    synth->voices.oldest   = SYNTH_NO_VOICE;
+    synth->voices.newest   = SYNTH_NO_VOICE;
+    // Nothing to ramp from yet. The first block snaps to its parameters
+    synth->lastGaindB          = NAN;
+    synth->lastCutoff          = NAN;
+    synth->lastCrossoverCutoff = NAN;
+    memset(synth->voices.noteToSlot, SYNTH_NO_VOICE, sizeof(synth->voices.noteToSlot));
+    memset(synth->voices.envStage, MOD_ENV_IDLE, sizeof(synth->voices.envStage));
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++)
+        synth->voices.modGain[i] = 1.0f;
+    synth->lfos[0].rateHz   = 5.0f;
+    synth->lfos[1].rateHz   = 0.5f;
+    synth->lfos[1].shape    = LFO_TRIANGLE;
+    synth->envelope.attack  = 0.005f;
+    synth->envelope.decay   = 0.3f;
+    synth->envelope.sustain = 0.3f;
+    synth->envelope.release = 0.2f;
+    synth->modSettled       = 1;
+    synth->ampEnvelope      = (AdsrParams){.attack = 0.005f, .decay = 0.3f, .sustain = 0.7f, .release = 0.2f};
+    synth->lastAmpEnvelope  = synth->ampEnvelope;
+    synth->ampCoeffs        = adsr_coeffs(&synth->ampEnvelope, sampleRate);
+    svf_bank_init(&synth->voices.filter, SYNTH_MAX_VOICES);
+    svf_bank_init(&synth->voices.filterR, SYNTH_MAX_VOICES);
+    adsr_bank_init(&synth->voices.amp);
+    crossover_init(&synth->crossover, SYNTH_NUM_CHANNELS);
+    synth_build_graph(synth);
+}
+
+// Free running oscillators start out of phase, so a stack doesn't sound like one loud oscillator at note on.
+// Done once per note, so playing the stack costs nothing extra
+static void synth_randomise_stack(Synth* synth, int slot)
+{
+    float*   phase = synth->voices.stackPhase[slot];
+    uint32_t x     = synth->random;
+
+    for (int k = 0; k < SYNTH_MAX_UNISON; k++)
+    {
+        x        = x ^ (x << 13);
+        x        = x ^ (x >> 17);
+        x        = x ^ (x << 5);
+        phase[k] = (float)(x >> 8) * (1.0f / 16777216.0f);
+    }
+    synth->random = x;
+}
+
+void synth_note_on(Synth* synth, uint8_t note, uint8_t velocity)
+{
+    SynthVoices* v = &synth->voices;
+    int          slot;
+    float        Hz, pan, angle, gain;
+
+    // Running status devices send note on with zero velocity instead of note off
+    if (velocity == 0)
+    {
+        synth_note_off(synth, note);
+        return;
+    }
+
+    slot = v->noteToSlot[note];
+    if (slot == SYNTH_NO_VOICE)
+    {
+        slot              = synth_voice_alloc(v);
+        v->phase[slot]    = 0.0f;
+        v->modGain[slot]  = 1.0f;
+        v->envLevel[slot] = 0.0f;
+        synth_randomise_stack(synth, slot);
+        svf_bank_reset_lane(&v->filter, slot);
+        svf_bank_reset_lane(&v->filterR, slot);
+        adsr_bank_reset_lane(&v->amp, slot);
+    }
+    else
+    {
+        // Retriggered notes keep their phase & envelope level, but count as the newest voice
+        synth_voice_unlink(v, slot);
+        synth_voice_link_newest(v, slot);
+    }
+
+    // Equal power pan, low notes left & high notes right
+    pan   = synth->spread * ((float)note - 64.0f) / 48.0f;
+    pan   = pan < -1.0f ? -1.0f : pan > 1.0f ? 1.0f : pan;
+    angle = (pan + 1.0f) * 0.7853981633974483f;
+    gain  = (float)velocity / 127.0f;
+
+    Hz                  = exp2f(((float)note - 69.0f) * 0.0833333f) * 440.0f;
+    v->note[slot]       = note;
+    v->baseInc[slot]    = Hz / synth->sampleRate;
+    v->inc[slot]        = v->baseInc[slot];
+    v->velocity[slot]   = gain;
+    v->envStage[slot]   = MOD_ENV_ATTACK;
+    adsr_note_on(&v->amp, slot, &synth->ampCoeffs);
+    v->gainL[slot]      = gain * cosf(angle);
+    v->gainR[slot]      = gain * sinf(angle);
+    v->noteToSlot[note] = slot;
+    synth->lastNote     = note;
+}
+
+void synth_note_off(Synth* synth, uint8_t note)
+{
+    SynthVoices* v    = &synth->voices;
+    int          slot = v->noteToSlot[note];
+    // The voice keeps its note, so playing it again during the release retriggers it
+    if (slot != SYNTH_NO_VOICE)
+    {
+        adsr_note_off(&v->amp, slot, &synth->ampCoeffs);
+        v->envStage[slot] = MOD_ENV_RELEASE;
+    }
+    if (synth->lastNote == note)
+        synth->lastNote = 0xff;
+}
+
+// Frees voices whose release has finished
+static void synth_free_finished(Synth* synth)
+{
+    SynthVoices* v = &synth->voices;
+    // Backwards, as freeing moves the last voice into the freed slot
+    for (int i = v->numActive - 1; i >= 0; i--)
+        if (adsr_is_finished(&v->amp, i))
+            synth_voice_free(v, i);
+}
+
+void synth_all_notes_off(Synth* synth)
+{
+    SynthVoices* v = &synth->voices;
+    while (v->numActive > 0)
+        synth_voice_free(v, v->numActive - 1);
+    if (synth->sampler)
+        sampler_all_notes_off(synth->sampler);
+    synth->lastNote = 0xff;
+}
+
+void synth_handle_event(Synth* synth, const SynthEvent* event)
+{
+    // ignore channel & release velocity
+    int sampled = synth->sampler && sampler_has_note(synth->sampler, event->data1);
+    if ((event->status & 0xf0) == MIDI_NOTE_ON && sampled)
+        sampler_note_on(synth->sampler, event->data1, event->data2);
+    else if ((event->status & 0xf0) == MIDI_NOTE_ON)
+        synth_note_on(synth, event->data1, event->data2);
+    else if ((event->status & 0xf0) == MIDI_NOTE_OFF && sampled)
+        sampler_note_off(synth->sampler, event->data1);
+    else if ((event->status & 0xf0) == MIDI_NOTE_OFF)
+        synth_note_off(synth, event->data1);
+    else if ((event->status & 0xf0) == MIDI_CONTROL_CHANGE && event->data1 == 1)
+        synth->modWheel = (float)event->data2 / 127.0f;
+}
+
+#define SYNTH_FILTER_Q 0.7071067811865475f
+
+// Glides the filter coefficients to where the parameter ramps will be after numFrames.
+// Filter coefficients only get recalculated while a ramp is running. While modulating, the voice filters are
+// glided every control period instead
+static void synth_advance_ramps(Synth* synth, int numFrames)
+{
+    if (! synth->modulating && smoothed_is_ramping(&synth->cutoffRamp))
+    {
+        float     Hz = norm_to_hz(smoothed_skip(&synth->cutoffRamp, numFrames));
+        SVFCoeffs c  = svf_coeffs(Hz, SYNTH_FILTER_Q, synth->sampleRate);
+        svf_bank_glide_all(&synth->voices.filter, c);
+        svf_bank_glide_all(&synth->voices.filterR, c);
+    }
+    if (smoothed_is_ramping(&synth->crossoverRamp))
+    {
+        float Hz = norm_to_hz(smoothed_skip(&synth->crossoverRamp, numFrames));
+        crossover_glide(&synth->crossover, crossover_coeffs(Hz, synth->sampleRate));
+    }
+}
+
+// Held notes move to the new sustain level. Voices in other stages carry on with the coefficients they have
+static void synth_update_amp_envelope(Synth* synth)
+{
+    SynthVoices* v = &synth->voices;
+
+    synth->lastAmpEnvelope = synth->ampEnvelope;
+    synth->ampCoeffs       = adsr_coeffs(&synth->ampEnvelope, synth->sampleRate);
+    for (int i = 0; i < v->numActive; i++)
+        adsr_retarget_decay(&v->amp, i, &synth->ampCoeffs);
+}
+
+// Detunes the stack evenly & spreads it with equal power pans, alternating sides so each pair of detunes is split.
+// Scaled so a stack is about as loud as one oscillator through the voice's own pan
+static void synth_update_unison(Synth* synth)
+{
+    const int   n    = synth->unison < 1 ? 1 : synth->unison > SYNTH_MAX_UNISON ? SYNTH_MAX_UNISON : synth->unison;
+    const float norm = sqrtf(2.0f / (float)n);
+
+    // The right channel's filters start where the left ones are
+    if (synth->lastUnison <= 1 && n > 1)
+        synth->voices.filterR = synth->voices.filter;
+    synth->lastUnison   = synth->unison;
+    synth->unisonGroups = (n + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    for (int k = 0; k < SYNTH_MAX_UNISON; k++)
+    {
+        float x     = n > 1 ? 2.0f * (float)k / (float)(n - 1) - 1.0f : 0.0f;
+        float pan   = synth->unisonWidth * fabsf(x) * (k & 1 ? 1.0f : -1.0f);
+        float angle = (pan + 1.0f) * 0.7853981633974483f;
+
+        synth->unisonRatio[k] = exp2f(synth->detune * x / 1200.0f);
+        synth->unisonGainL[k] = k < n ? norm * cosf(angle) : 0.0f;
+        synth->unisonGainR[k] = k < n ? norm * sinf(angle) : 0.0f;
+    }
+}
+
+static void synth_update_params(Synth* synth)
+{
+    const int rampFrames    = (int)(synth->sampleRate * SYNTH_RAMP_SECONDS);
+    int       unisonChanged = synth->unison != synth->lastUnison;
+
+    if (memcmp(&synth->lastAmpEnvelope, &synth->ampEnvelope, sizeof(synth->ampEnvelope)) != 0)
+        synth_update_amp_envelope(synth);
+    unisonChanged |= param_changed(&synth->lastDetune, synth->detune);
+    unisonChanged |= param_changed(&synth->lastUnisonWidth, synth->unisonWidth);
+    if (unisonChanged)
+        synth_update_unison(synth);
+
+    if (isnan(synth->lastGaindB) || isnan(synth->lastCutoff) || isnan(synth->lastCrossoverCutoff))
+    {
+        synth->lastGaindB          = synth->gaindB;
+        synth->lastCutoff          = synth->cutoff;
+        synth->lastCrossoverCutoff = synth->crossoverCutoff;
+        smoothed_reset(&synth->gain, db_to_gain(synth->gaindB));
+        smoothed_reset(&synth->cutoffRamp, synth->cutoff);
+        smoothed_reset(&synth->crossoverRamp, synth->crossoverCutoff);
+        svf_bank_set_all(&synth->voices.filter,
+                         svf_coeffs(norm_to_hz(synth->cutoff), SYNTH_FILTER_Q, synth->sampleRate));
+        synth->voices.filterR = synth->voices.filter;
+        crossover_set(&synth->crossover, crossover_coeffs(norm_to_hz(synth->crossoverCutoff), synth->sampleRate));
+        return;
+    }
+
+    if (param_changed(&synth->lastGaindB, synth->gaindB))
+        smoothed_set_target(&synth->gain, db_to_gain(synth->gaindB), rampFrames);
+    if (param_changed(&synth->lastCutoff, synth->cutoff))
+        smoothed_set_target(&synth->cutoffRamp, synth->cutoff, rampFrames);
+    if (param_changed(&synth->lastCrossoverCutoff, synth->crossoverCutoff))
+        smoothed_set_target(&synth->crossoverRamp, synth->crossoverCutoff, rampFrames);
+}
+
+// Renders the unison stacks of the voices in lanes j to j + SIMD_WIDTH, mixed down to stereo, one voice per lane.
+// Each stack takes one vector pass per SIMD_WIDTH oscillators. With 'incTarget', the voices' increments glide to it
+// across the frames & are left there
+SIMD_INLINE void synth_render_stacks(Synth* synth, int task, int j, const float* incTarget, float* outL, float* outR,
+                                     int numFrames)
+{
+    SynthVoices* v         = &synth->voices;
+    const int    numGroups = synth->unisonGroups;
+    const int    numLanes  = v->numActive - j < SIMD_WIDTH ? v->numActive - j : SIMD_WIDTH;
+    float*       stack     = synth->stack[task];
+
+    for (int lane = 0; lane < SIMD_WIDTH; lane++)
+    {
+        const int slot = j + lane;
+
+        // Free slots are silent
+        if (lane >= numLanes)
+        {
+            for (int i = 0; i < numFrames; i++)
+                outL[i * SIMD_WIDTH + lane] = outR[i * SIMD_WIDTH + lane] = 0.0f;
+            continue;
+        }
+        for (int g = 0; g < numGroups; g++)
+        {
+            SIMD_ALIGNED float inc[SIMD_WIDTH];
+            SIMD_ALIGNED float target[SIMD_WIDTH];
+            const int          k     = g * SIMD_WIDTH;
+            simd_f             ratio = simd_load(&synth->unisonRatio[k]);
+            float*             out   = stack + g * numFrames * SIMD_WIDTH;
+
+            simd_store(inc, simd_mul(simd_set1(v->inc[slot]), ratio));
+            if (incTarget)
+            {
+                simd_store(target, simd_mul(simd_set1(incTarget[lane]), ratio));
+                osc_render_lanes_glide(synth->shape, &v->stackPhase[slot][k], inc, target, synth->pulseWidth, out,
+                                       numFrames);
+            }
+            else
+            {
+                osc_render_lanes(synth->shape, &v->stackPhase[slot][k], inc, synth->pulseWidth, out, numFrames);
+            }
+        }
+        // Mixed down per frame. Oscillators past 'unison' have no gain
+        for (int i = 0; i < numFrames; i++)
+        {
+            simd_f left  = simd_set1(0.0f);
+            simd_f right = simd_set1(0.0f);
+            for (int g = 0; g < numGroups; g++)
+            {
+                simd_f x = simd_load(&stack[(g * numFrames + i) * SIMD_WIDTH]);
+                left     = simd_fmadd(x, simd_load(&synth->unisonGainL[g * SIMD_WIDTH]), left);
+                right    = simd_fmadd(x, simd_load(&synth->unisonGainR[g * SIMD_WIDTH]), right);
+            }
+            outL[i * SIMD_WIDTH + lane] = simd_hsum(left);
+            outR[i * SIMD_WIDTH + lane] = simd_hsum(right);
+        }
+    }
+    if (incTarget)
+        memcpy(&v->inc[j], incTarget, SIMD_WIDTH * sizeof(float));
+}
+
+// Lowpass & amp envelope for a group of stereo stacks. The envelope runs once, into the stack buffer, for both sides
+SIMD_INLINE void synth_stacks_filter_amp(Synth* synth, int task, int j, float* outL, float* outR, int numFrames)
+{
+    SynthVoices* v   = &synth->voices;
+    float*       env = synth->stack[task];
+
+    svf_bank_process(&v->filter, SVF_LOWPASS, j, SIMD_WIDTH, outL, numFrames);
+    svf_bank_process(&v->filterR, SVF_LOWPASS, j, SIMD_WIDTH, outR, numFrames);
+    for (int i = 0; i < numFrames * SIMD_WIDTH; i++)
+        env[i] = 1.0f;
+    adsr_process_lanes(&v->amp, &synth->ampCoeffs, j, env, numFrames);
+    for (int i = 0; i < numFrames * SIMD_WIDTH; i += SIMD_WIDTH)
+    {
+        simd_f e = simd_load(&env[i]);
+        simd_store(&outL[i], simd_mul(simd_load(&outL[i]), e));
+        simd_store(&outR[i], simd_mul(simd_load(&outR[i]), e));
+    }
+}
+
+// Renders & sums one task's share of the voice groups, panned but still one voice per lane
+SIMD_INLINE void synth_render_groups(Synth* synth, int task, int numFrames)
+{
+    SynthVoices* v         = &synth->voices;
+    const int    numGroups = (v->numActive + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    const int    first     = task * numGroups / synth->numTasks;
+    const int    last      = (task + 1) * numGroups / synth->numTasks;
+    float*       scratch   = synth->scratch[task];
+    float*       accL      = synth->acc[task][0];
+    float*       accR      = synth->acc[task][1];
+
+    memset(accL, 0, numFrames * SIMD_WIDTH * sizeof(*accL));
+    memset(accR, 0, numFrames * SIMD_WIDTH * sizeof(*accR));
+    // Lanes past numActive in the last group are silent
+    for (int g = first; g < last; g++)
+    {
+        const int j     = g * SIMD_WIDTH;
+        simd_f    gainL = simd_load(&v->gainL[j]);
+        simd_f    gainR = simd_load(&v->gainR[j]);
+
+        osc_render_lanes(synth->shape, &v->phase[j], &v->inc[j], synth->pulseWidth, scratch, numFrames);
+        svf_bank_process(&v->filter, SVF_LOWPASS, j, SIMD_WIDTH, scratch, numFrames);
+        adsr_process_lanes(&v->amp, &synth->ampCoeffs, j, scratch, numFrames);
+        for (int i = 0; i < numFrames * SIMD_WIDTH; i += SIMD_WIDTH)
+        {
+            simd_f x = simd_load(&scratch[i]);
+            simd_store(&accL[i], simd_fmadd(x, gainL, simd_load(&accL[i])));
+            simd_store(&accR[i], simd_fmadd(x, gainR, simd_load(&accR[i])));
+        }
+    }
+}
+
+// Same as synth_render_groups(), with every voice playing its unison stack in stereo
+SIMD_INLINE void synth_render_groups_unison(Synth* synth, int task, int numFrames)
+{
+    SynthVoices* v         = &synth->voices;
+    const int    numGroups = (v->numActive + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    const int    first     = task * numGroups / synth->numTasks;
+    const int    last      = (task + 1) * numGroups / synth->numTasks;
+    float*       outL      = synth->scratch[task];
+    float*       outR      = synth->stackR[task];
+    float*       accL      = synth->acc[task][0];
+    float*       accR      = synth->acc[task][1];
+
+    memset(accL, 0, numFrames * SIMD_WIDTH * sizeof(*accL));
+    memset(accR, 0, numFrames * SIMD_WIDTH * sizeof(*accR));
+    for (int g = first; g < last; g++)
+    {
+        const int j     = g * SIMD_WIDTH;
+        simd_f    gainL = simd_load(&v->gainL[j]);
+        simd_f    gainR = simd_load(&v->gainR[j]);
+
+        synth_render_stacks(synth, task, j, NULL, outL, outR, numFrames);
+        synth_stacks_filter_amp(synth, task, j, outL, outR, numFrames);
+        for (int i = 0; i < numFrames * SIMD_WIDTH; i += SIMD_WIDTH)
+        {
+            simd_store(&accL[i], simd_fmadd(simd_load(&outL[i]), gainL, simd_load(&accL[i])));
+            simd_store(&accR[i], simd_fmadd(simd_load(&outR[i]), gainR, simd_load(&accR[i])));
+        }
+    }
+}
+
+static void synth_advance_envelopes(Synth* synth, int first, int last, float seconds)
+{
+    SynthVoices* v = &synth->voices;
+    for (int i = first; i < last; i++)
+        modenv_advance(&synth->envelope, &v->envLevel[i], &v->envStage[i], seconds);
+}
+
+// Highest increment pitch modulation can reach, safely below Nyquist
+#define SYNTH_MAX_INC 0.45f
+
+// Same as synth_render_groups(), split into control periods. At the start of each, the sources are read and
+// the voices' pitch, cutoff & gain set to glide to their modulated values by its end
+SIMD_INLINE void synth_render_groups_modulated(Synth* synth, int task, int numFrames)
+{
+    SynthVoices* v         = &synth->voices;
+    const int    numGroups = (v->numActive + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    const int    first     = task * numGroups / synth->numTasks;
+    const int    last      = (task + 1) * numGroups / synth->numTasks;
+    const int    unison    = synth->unison > 1;
+    float*       scratch   = synth->scratch[task];
+    float*       scratchR  = unison ? synth->stackR[task] : scratch; // plain voices are mono
+    float*       accL      = synth->acc[task][0];
+    float*       accR      = synth->acc[task][1];
+
+    memset(accL, 0, numFrames * SIMD_WIDTH * sizeof(*accL));
+    memset(accR, 0, numFrames * SIMD_WIDTH * sizeof(*accR));
+    for (int g = first; g < last; g++)
+    {
+        const int          j = g * SIMD_WIDTH;
+        simd_f             sources[MOD_SRC_COUNT];
+        simd_f             dests[MOD_DST_COUNT];
+        SIMD_ALIGNED float incTarget[SIMD_WIDTH];
+
+        for (int p = 0, offset = 0; offset < numFrames; p++, offset += SYNTH_CONTROL_FRAMES)
+        {
+            const int n    = numFrames - offset < SYNTH_CONTROL_FRAMES ? numFrames - offset : SYNTH_CONTROL_FRAMES;
+            float*    out  = scratch + offset * SIMD_WIDTH;
+            float*    outR = scratchR + offset * SIMD_WIDTH;
+            simd_f    gain = simd_load(&v->modGain[j]);
+            simd_f    target, step, gainL, gainR, stepL, stepR;
+
+            synth_advance_envelopes(synth, j, j + SIMD_WIDTH, (float)n / synth->sampleRate);
+            sources[MOD_SRC_LFO1]     = simd_set1(synth->lfoValues[0][p]);
+            sources[MOD_SRC_LFO2]     = simd_set1(synth->lfoValues[1][p]);
+            sources[MOD_SRC_ENVELOPE] = simd_load(&v->envLevel[j]);
+            sources[MOD_SRC_VELOCITY] = simd_load(&v->velocity[j]);
+            sources[MOD_SRC_MODWHEEL] = simd_set1(synth->modWheel);
+            modmatrix_eval_lanes(&synth->mod, sources, dests);
+
+            target = fast_exp2_lanes(simd_mul(dests[MOD_DST_PITCH], simd_set1(1.0f / 12.0f)));
+            target = simd_min(simd_mul(simd_load(&v->baseInc[j]), target), simd_set1(SYNTH_MAX_INC));
+            simd_store(incTarget, target);
+            target = simd_mul(simd_set1(synth->cutoffHz[p]), fast_exp2_lanes(dests[MOD_DST_CUTOFF]));
+            svf_bank_glide_cutoffs(&v->filter, j, target, SYNTH_FILTER_Q, synth->sampleRate);
+
+            if (unison)
+            {
+                svf_bank_glide_cutoffs(&v->filterR, j, target, SYNTH_FILTER_Q, synth->sampleRate);
+                synth_render_stacks(synth, task, j, incTarget, out, outR, n);
+                synth_stacks_filter_amp(synth, task, j, out, outR, n);
+            }
+            else
+            {
+                osc_render_lanes_glide(synth->shape, &v->phase[j], &v->inc[j], incTarget, synth->pulseWidth, out, n);
+                svf_bank_process(&v->filter, SVF_LOWPASS, j, SIMD_WIDTH, out, n);
+                adsr_process_lanes(&v->amp, &synth->ampCoeffs, j, out, n);
+            }
+
+            // Pan & velocity times the gain ramp
+            target = fast_db_to_gain_lanes(dests[MOD_DST_GAIN]);
+            step   = simd_mul(simd_sub(target, gain), simd_set1(1.0f / (float)n));
+            gainL  = simd_mul(simd_load(&v->gainL[j]), gain);
+            gainR  = simd_mul(simd_load(&v->gainR[j]), gain);
+            stepL  = simd_mul(simd_load(&v->gainL[j]), step);
+            stepR  = simd_mul(simd_load(&v->gainR[j]), step);
+            for (int i = offset * SIMD_WIDTH; i < (offset + n) * SIMD_WIDTH; i += SIMD_WIDTH)
+            {
+                gainL = simd_add(gainL, stepL);
+                gainR = simd_add(gainR, stepR);
+                simd_store(&accL[i], simd_fmadd(simd_load(&scratch[i]), gainL, simd_load(&accL[i])));
+                simd_store(&accR[i], simd_fmadd(simd_load(&scratchR[i]), gainR, simd_load(&accR[i])));
+            }
+            simd_store(&v->modGain[j], target);
+        }
+    }
+}
+
+static void synth_render_task(void* userdata, int task)
+{
+    Synth* synth = userdata;
+    if (synth->modulating)
+    {
+        synth_render_groups_modulated(synth, task, synth->taskFrames);
+        return;
+    }
+    if (synth->unison > 1)
+    {
+        synth_render_groups_unison(synth, task, synth->taskFrames);
+        return;
+    }
+    // Constant trip counts for the usual case
+    if (synth->taskFrames == SYNTH_BLOCK_FRAMES)
+        synth_render_groups(synth, task, SYNTH_BLOCK_FRAMES);
+    else
+        synth_render_groups(synth, task, synth->taskFrames);
+}
+
+static int synth_num_tasks(const Synth* synth, int numFrames)
+{
+    int numGroups = (synth->voices.numActive + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    // A group of unison voices renders each voice's stack separately
+    int passes    = synth->unison > 1 ? SIMD_WIDTH * synth->unisonGroups : 1;
+    int numTasks  = numGroups * numFrames * passes / SYNTH_MIN_TASK_WORK;
+
+    if (! synth->workers)
+        return 1;
+    numTasks = numTasks < numGroups ? numTasks : numGroups;
+    numTasks = numTasks < synth->workers->numWorkers + 1 ? numTasks : synth->workers->numWorkers + 1;
+    numTasks = numTasks < SYNTH_MAX_TASKS ? numTasks : SYNTH_MAX_TASKS;
+    return numTasks > 1 ? numTasks : 1;
+}
+
+// Adds up the tasks, then the lanes, into planar channels
+SIMD_INLINE void synth_mix_tasks(Synth* synth, float* const* out, int numFrames)
+{
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+    {
+        for (int i = 0; i < numFrames; i++)
+        {
+            simd_f sum = simd_load(&synth->acc[0][c][i * SIMD_WIDTH]);
+            // Summed in task order, so the output doesn't depend on which thread ran what
+            for (int t = 1; t < synth->numTasks; t++)
+                sum = simd_add(sum, simd_load(&synth->acc[t][c][i * SIMD_WIDTH]));
+            out[c][i] = simd_hsum(sum);
+        }
+    }
+}
+
+// Reads the global modulation sources for each control period of the pass. Without modulation, the LFOs &
+// envelopes still run, so they are in the right place when something gets routed
+static void synth_advance_modulation(Synth* synth, int numFrames)
+{
+    const float rate = synth->sampleRate;
+
+    synth->modulating = synth->mod.numSlots > 0 || ! synth->modSettled;
+    if (! synth->modulating)
+    {
+        for (int l = 0; l < MOD_NUM_LFOS; l++)
+            lfo_advance(&synth->lfos[l], numFrames, rate);
+        synth_advance_envelopes(synth, 0, synth->voices.numActive, (float)numFrames / rate);
+        return;
+    }
+
+    for (int p = 0, offset = 0; offset < numFrames; p++, offset += SYNTH_CONTROL_FRAMES)
+    {
+        const int n = numFrames - offset < SYNTH_CONTROL_FRAMES ? numFrames - offset : SYNTH_CONTROL_FRAMES;
+        for (int l = 0; l < MOD_NUM_LFOS; l++)
+            synth->lfoValues[l][p] = lfo_advance(&synth->lfos[l], n, rate);
+        synth->cutoffHz[p] = norm_to_hz(smoothed_skip(&synth->cutoffRamp, n));
+    }
+}
+
+// Once nothing is routed, the pass just rendered has glided every voice back to its unmodulated values.
+// Snaps them there exactly, so the plain render path can take over
+static void synth_settle_modulation(Synth* synth)
+{
+    SynthVoices* v = &synth->voices;
+    SVFCoeffs    c;
+
+    if (! synth->modulating || synth->mod.numSlots > 0)
+    {
+        synth->modSettled = ! synth->modulating;
+        return;
+    }
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++)
+    {
+        v->inc[i]     = v->baseInc[i];
+        v->modGain[i] = 1.0f;
+    }
+    c = svf_coeffs(norm_to_hz(synth->cutoffRamp.current), SYNTH_FILTER_Q, synth->sampleRate);
+    svf_bank_glide_all(&v->filter, c);
+    svf_bank_glide_all(&v->filterR, c);
+    synth->modSettled = 1;
+}
+
+// Graph nodes. Inputs & outputs are SYNTH_NUM_CHANNELS planar channels
+
+static void synth_voices_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+    (void)inputs;
+
+    synth->taskFrames = numFrames;
+    synth->numTasks   = synth_num_tasks(synth, numFrames);
+    if (synth->numTasks > 1)
+        workpool_run(synth->workers, synth_render_task, synth, synth->numTasks);
+    else
+        synth_render_task(synth, 0);
+
+    synth_settle_modulation(synth);
+    synth_free_finished(synth);
+    synth_mix_tasks(synth, outputs, numFrames);
+}
+
+// Effects a patch uses but the synth hasn't been given pass the signal through
+static void synth_pass_through(const float* const* inputs, float* const* outputs, int numFrames)
+{
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+        memcpy(outputs[c], inputs[c], numFrames * sizeof(float));
+}
+
+static void synth_sampler_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+
+    synth_pass_through(inputs, outputs, numFrames);
+    if (synth->sampler)
+        sampler_process(synth->sampler, outputs, numFrames);
+}
+
+static void synth_crossover_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+        for (int i = 0; i < numFrames; i++)
+            synth->mix[i * SYNTH_MIX_LANES + c] = inputs[c][i];
+    crossover_process(&synth->crossover, synth->mix, numFrames);
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+        for (int i = 0; i < numFrames; i++)
+            outputs[c][i] = synth->mix[i * SYNTH_MIX_LANES + c];
+}
+
+static void synth_delay_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+
+    if (synth->delay)
+        delay_process(synth->delay, inputs, outputs, numFrames);
+    else
+        synth_pass_through(inputs, outputs, numFrames);
+}
+
+static void synth_reverb_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+
+    if (synth->reverb)
+        reverb_process(synth->reverb, inputs, outputs, numFrames);
+    else
+        synth_pass_through(inputs, outputs, numFrames);
+}
+
+static void synth_gain_node(void* userdata, const float* const* inputs, float* const* outputs, int numFrames)
+{
+    Synth* synth = userdata;
+
+    smoothed_render(&synth->gain, synth->gainRamp, numFrames);
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+        for (int i = 0; i < numFrames; i++)
+            outputs[c][i] = inputs[c][i] * synth->gainRamp[i];
+}
+
+// Builds a chain of the voices, the effects asked for & the gain. Only reads the synth's address, so it's safe to call
+// on any thread
+static void synth_graph_build(Synth* synth, SynthGraph* sg, int useSampler, int useDelay, int useReverb)
+{
+    Graph* graph = &sg->graph;
+    int    chain[6];
+    int    numNodes = 0;
+    int    error    = 0;
+
+    graph_init(graph);
+    sg->voicesNode  = graph_add_node(graph, "Voices", synth_voices_node, synth, 0, SYNTH_NUM_CHANNELS);
+    sg->samplerNode = GRAPH_NONE;
+    if (useSampler)
+        sg->samplerNode = graph_add_node(graph, "Sampler", synth_sampler_node, synth, SYNTH_NUM_CHANNELS,
+                                         SYNTH_NUM_CHANNELS);
+    sg->crossoverNode = graph_add_node(graph, "Crossover", synth_crossover_node, synth, SYNTH_NUM_CHANNELS,
+                                       SYNTH_NUM_CHANNELS);
+    sg->delayNode     = GRAPH_NONE;
+    if (useDelay)
+        sg->delayNode = graph_add_node(graph, "Delay", synth_delay_node, synth, SYNTH_NUM_CHANNELS, SYNTH_NUM_CHANNELS);
+    sg->reverbNode = GRAPH_NONE;
+    if (useReverb)
+        sg->reverbNode = graph_add_node(graph, "Reverb", synth_reverb_node, synth, SYNTH_NUM_CHANNELS,
+                                        SYNTH_NUM_CHANNELS);
+    sg->gainNode = graph_add_node(graph, "Gain", synth_gain_node, synth, SYNTH_NUM_CHANNELS, SYNTH_NUM_CHANNELS);
+
+    // One straight chain, skipping the effects that aren't used
+    chain[numNodes++] = sg->voicesNode;
+    if (useSampler)
+        chain[numNodes++] = sg->samplerNode;
+    chain[numNodes++] = sg->crossoverNode;
+    if (useDelay)
+        chain[numNodes++] = sg->delayNode;
+    if (useReverb)
+        chain[numNodes++] = sg->reverbNode;
+    chain[numNodes++] = sg->gainNode;
+    for (int n = 0; n + 1 < numNodes; n++)
+        for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+            error |= graph_connect(graph, chain[n], c, chain[n + 1], c);
+    error |= graph_compile(graph);
+    assert(error == 0);
+    (void)error;
+}
+
+static void synth_build_graph(Synth* synth)
+{
+    synth_graph_build(synth, &synth->ownGraph, synth->sampler != NULL, synth->delay != NULL, synth->reverb != NULL);
+    synth->graph = &synth->ownGraph;
+}
+
+void synth_patch_build(Synth* synth, SynthPatch* patch, const SynthPreset* preset)
+{
+    patch->preset = *preset;
+    // The sampler isn't part of the preset. Its node passes the voices through until one is set
+    synth_graph_build(synth, &patch->graph, 1, (preset->effects & PRESET_DELAY) != 0,
+                      (preset->effects & PRESET_REVERB) != 0);
+}
+
+void synth_set_patch(Synth* synth, SynthPatch* patch)
+{
+    const SynthPreset* preset = &patch->preset;
+
+    // Only source values are copied. Like any other change, the synth ramps to them
+    synth->shape           = preset->shape;
+    synth->gaindB          = preset->gaindB;
+    synth->cutoff          = preset->cutoff;
+    synth->crossoverCutoff = preset->crossover;
+    synth->ampEnvelope     = preset->ampEnvelope;
+    synth->unison          = preset->unison;
+    synth->detune          = preset->detune;
+    synth->unisonWidth     = preset->unisonWidth;
+    synth->envelope        = preset->envelope;
+    synth->mod             = preset->mod;
+    for (int i = 0; i < MOD_NUM_LFOS; i++)
+    {
+        synth->lfos[i].shape  = preset->lfos[i].shape;
+        synth->lfos[i].rateHz = preset->lfos[i].rateHz;
+    }
+    if (synth->delay)
+    {
+        delay_set_type(synth->delay, preset->delayType);
+        synth->delay->mix = preset->delayMix;
+    }
+    if (synth->reverb)
+        synth->reverb->wet = preset->reverbWet;
+    synth->graph = &patch->graph;
+}
+
+void synth_set_reverb(Synth* synth, Reverb* reverb)
+{
+    assert(! reverb || reverb->numChannels == SYNTH_NUM_CHANNELS);
+    synth->reverb = reverb;
+    synth_build_graph(synth);
+}
+
+void synth_set_sampler(Synth* synth, Sampler* sampler)
+{
+    if (synth->sampler)
+        sampler_all_notes_off(synth->sampler);
+    synth->sampler = sampler;
+    synth_build_graph(synth);
+}
+
+void synth_set_delay(Synth* synth, Delay* delay)
+{
+    assert(! delay || delay->numChannels == SYNTH_NUM_CHANNELS);
+    synth->delay = delay;
+    synth_build_graph(synth);
+}
+
+// One pass over the voices, numFrames <= SYNTH_BLOCK_FRAMES
+SIMD_INLINE void synth_render_pass(Synth* synth, const float* const* planar, float* buffer, int numFrames,
+                                   int numChannels)
+{
+    synth_advance_modulation(synth, numFrames);
+    synth_advance_ramps(synth, numFrames);
+    graph_run(&synth->graph->graph, numFrames);
+
+    if (numChannels == 1)
+    {
+        // Centre panned voices keep their level
+        for (int i = 0; i < numFrames; i++)
+            buffer[i] = (planar[0][i] + planar[1][i]) * 0.7071067811865475f;
+    }
+    else
+    {
+        interleave(planar, numChannels, buffer, numFrames);
+    }
+}
+
+static void synth_render(Synth* synth, float* buffer, int numFrames, int numChannels)
+{
+    const float* planar[SYNTH_MAX_OUTPUT_CHANNELS];
+
+    for (int c = 0; c < SYNTH_NUM_CHANNELS; c++)
+        planar[c] = graph_output(&synth->graph->graph, synth->graph->gainNode, c);
+    for (int c = SYNTH_NUM_CHANNELS; c < SYNTH_MAX_OUTPUT_CHANNELS; c++)
+        planar[c] = synth->graph->graph.silence;
+
+    for (; numFrames >= SYNTH_BLOCK_FRAMES; numFrames -= SYNTH_BLOCK_FRAMES)
+    {
+        synth_render_pass(synth, planar, buffer, SYNTH_BLOCK_FRAMES, numChannels);
+        buffer += SYNTH_BLOCK_FRAMES * numChannels;
+    }
+    // Left over when events split the block, or when not driven through a BlockFifo
+    if (numFrames > 0)
+        synth_render_pass(synth, planar, buffer, numFrames, numChannels);
+}
+
+void synth_process(Synth* synth, const SynthEvent* events, int numEvents, float* buffer, int numFrames,
+                   int numChannels)
+{
+    int pos = 0;
+
+    assert(numChannels >= 1 && numChannels <= SYNTH_MAX_OUTPUT_CHANNELS);
+
+    synth_update_params(synth);
+
+    for (int e = 0; e < numEvents; e++)
+    {
+        int frame = events[e].frame;
+        frame     = frame < pos ? pos : frame;
+        frame     = frame > numFrames ? numFrames : frame;
+        if (frame > pos)
+            synth_render(synth, buffer + pos * numChannels, frame - pos, numChannels);
+        pos = frame;
+        synth_handle_event(synth, &events[e]);
+    }
+    if (pos < numFrames)
+        synth_render(synth, buffer + pos * numChannels, numFrames - pos, numChannels);
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include "adsr.h"
+#include "delay.h"
+#include "filter.h"
+#include "graph.h"
+#include "modulation.h"
+#include "osc.h"
+#include "param.h"
+#include "preset.h"
+#include "reverb.h"
+#include "sampler.h"
+#include "workpool.h"
+
+#include <stdint.h>
+
+// Polyphonic voice engine.
+// Voice state lives structure-of-arrays in a preallocated pool. Playing voices are kept packed in slots
+// [0, numActive), so the render loop streams through contiguous memory without any indirection.
+// Note on/off and voice stealing are O(1) and never allocate, so they are safe to call on the audio thread.
+// Note off starts a voice's release. It keeps its slot until its amp envelope has finished, and is then freed
+// at the end of the pass.
+// Voices are rendered in groups of SIMD_WIDTH, one voice per lane. With a worker pool, the groups are split
+// between threads when there are enough of them to be worth it.
+// Pitch, cutoff & gain can be modulated per voice through a ModMatrix. Sources are read every
+// SYNTH_CONTROL_FRAMES and the destinations ramp linearly in between. With nothing routed, voices render
+// straight through without the control rate split.
+// In unison mode each voice plays a stack of detuned oscillators, SIMD_WIDTH of them per vector pass, mixed down to
+// stereo before the voice's filter & envelope. The stack's phases are randomised at note on.
+// Voices are panned by note across the stereo field. The engine works in planar, SIMD aligned channel buffers and
+// only interleaves into the backend's layout at the very end.
+// Each pass runs a Graph: the voices are one node, followed by the crossover & master gain. Effects are added as
+// further nodes.
+
+#define SYNTH_MAX_VOICES 64
+// Most oscillators in a unison stack. A multiple of SIMD_WIDTH
+#define SYNTH_MAX_UNISON 16
+#define SYNTH_NO_VOICE 0xff
+// Frames rendered per pass over the voices. Larger buffers are rendered in several passes. Driven through a
+// BlockFifo, every pass is exactly this long, and the render loops are specialised for it. 32 or 64
+#ifndef SYNTH_BLOCK_FRAMES
+#define SYNTH_BLOCK_FRAMES 64
+#endif
+#if SYNTH_BLOCK_FRAMES > GRAPH_MAX_FRAMES
+#error "Graph buffers are shorter than SYNTH_BLOCK_FRAMES"
+#endif
+// Rate the app runs the engine at, so DSP cost & tuning are the same on every machine.
+// Devices running at other rates go through a Resampler
+#ifndef SYNTH_ENGINE_RATE
+#define SYNTH_ENGINE_RATE 48000
+#endif
+// Frames between modulation updates. Must divide SYNTH_BLOCK_FRAMES
+#ifndef SYNTH_CONTROL_FRAMES
+#define SYNTH_CONTROL_FRAMES 16
+#endif
+#define SYNTH_MAX_CONTROL_PERIODS (SYNTH_BLOCK_FRAMES / SYNTH_CONTROL_FRAMES)
+// Parameter changes ramp over this long
+#define SYNTH_RAMP_SECONDS 0.01f
+// Most threads one block is split across
+#define SYNTH_MAX_TASKS 8
+// Channels rendered. Extra output channels are silent, mono outputs get a downmix
+#define SYNTH_NUM_CHANNELS 2
+// Lanes of the lane interleaved mix the crossover runs on
+#if SIMD_WIDTH < SYNTH_NUM_CHANNELS
+#define SYNTH_MIX_LANES SYNTH_NUM_CHANNELS
+#else
+#define SYNTH_MIX_LANES SIMD_WIDTH
+#endif
+#define SYNTH_MAX_OUTPUT_CHANNELS 8
+// Voice groups * frames each task needs. Below this, handing work to other threads costs more than it saves
+#define SYNTH_MIN_TASK_WORK 256
+
+enum MidiEventType
+{
+    MIDI_NOTE_OFF       = 0x80,
+    MIDI_NOTE_ON        = 0x90,
+    MIDI_CONTROL_CHANGE = 0xb0, // only the mod wheel, CC 1
+    MIDI_PROGRAM_CHANGE = 0xc0, // left to the app, which owns the presets
+};
+
+// A MIDI message scheduled at a frame offset inside the block being rendered
+typedef struct SynthEvent
+{
+    int     frame;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+} SynthEvent;
+
+typedef struct SynthVoices
+{
+    // Hot. Read & written every sample
+    SIMD_ALIGNED float phase[SYNTH_MAX_VOICES]; // oscillator phase, 0-1
+    SIMD_ALIGNED float inc[SYNTH_MAX_VOICES];   // phase increment per sample
+    SIMD_ALIGNED float gainL[SYNTH_MAX_VOICES]; // note velocity & pan
+    SIMD_ALIGNED float gainR[SYNTH_MAX_VOICES];
+    SVFBank            filter; // lowpass, one lane per slot
+    // Unison stacks, a row per slot. The right channel of a stack gets its own lowpass
+    SIMD_ALIGNED float stackPhase[SYNTH_MAX_VOICES][SYNTH_MAX_UNISON];
+    SVFBank            filterR;
+    AdsrBank           amp;    // amplitude envelope, one lane per slot
+
+    // Warm. Read & written once per control period
+    SIMD_ALIGNED float baseInc[SYNTH_MAX_VOICES];  // increment of the note, before pitch modulation
+    SIMD_ALIGNED float velocity[SYNTH_MAX_VOICES]; // 0-1
+    SIMD_ALIGNED float modGain[SYNTH_MAX_VOICES];  // gain modulation reached at the end of the last period
+    SIMD_ALIGNED float envLevel[SYNTH_MAX_VOICES];
+    uint8_t            envStage[SYNTH_MAX_VOICES]; // ModEnvStage
+
+    // Cold. Only touched on note on/off
+    uint8_t note[SYNTH_MAX_VOICES];
+    // Age list of playing voices, linked through slot indexes. Stealing takes 'oldest'
+    uint8_t older[SYNTH_MAX_VOICES];
+    uint8_t newer[SYNTH_MAX_VOICES];
+    uint8_t oldest;
+    uint8_t newest;
+    int     numActive;
+    // Slot playing each MIDI note, or SYNTH_NO_VOICE
+    uint8_t noteToSlot[128];
+} SynthVoices;
+
+// Everything after the voices: a compiled graph & where its nodes are
+typedef struct SynthGraph
+{
+    Graph graph;
+    int   voicesNode;
+    int   samplerNode; // GRAPH_NONE without a sampler
+    int   crossoverNode;
+    int   delayNode;  // GRAPH_NONE without a delay
+    int   reverbNode; // GRAPH_NONE without a reverb
+    int   gainNode;   // output
+} SynthGraph;
+
+// A whole synth state: a preset & the graph compiled for its effects. Built off the audio thread by
+// synth_patch_build(), so applying it is a copy of the source values & a pointer swap
+typedef struct SynthPatch
+{
+    SynthPreset preset;
+    SynthGraph  graph;
+} SynthPatch;
+
+typedef struct Synth
+{
+    float       sampleRate;
+    OscShape    shape;
+    float       pulseWidth;
+    float       spread; // how far apart low & high notes are panned, 0-1
+    // Unison. Each note stacks 'unison' oscillators, 1-SYNTH_MAX_UNISON, detuned evenly across 'detune' cents &
+    // spread across 'unisonWidth' of the stereo field, 0-1. 1 plays a single oscillator
+    int   unison;
+    float detune;
+    float unisonWidth;
+    // Values the stack tables were built for, & the tables: each oscillator's frequency ratio & stereo gains
+    int                lastUnison;
+    float              lastDetune;
+    float              lastUnisonWidth;
+    int                unisonGroups; // vector passes per stack
+    SIMD_ALIGNED float unisonRatio[SYNTH_MAX_UNISON];
+    SIMD_ALIGNED float unisonGainL[SYNTH_MAX_UNISON];
+    SIMD_ALIGNED float unisonGainR[SYNTH_MAX_UNISON];
+    uint32_t           random; // xorshift state for the stack phases
+    // Source parameters, set before each synth_process()
+    float gaindB;
+    float cutoff;          // voice lowpass, 0-1. See norm_to_hz()
+    float crossoverCutoff; // 0-1
+    // Source values seen by the last synth_process(). Derived values are only recomputed when these change
+    float lastGaindB;
+    float lastCutoff;
+    float lastCrossoverCutoff;
+    // Amplitude envelope. Changes apply to the next stage each voice enters, and to held notes' sustain level
+    AdsrParams ampEnvelope;
+    AdsrParams lastAmpEnvelope;
+    AdsrCoeffs ampCoeffs;
+    // Changes ramp over SYNTH_RAMP_SECONDS, however long the blocks are
+    SmoothedValue gain;
+    SmoothedValue cutoffRamp;
+    SmoothedValue crossoverRamp;
+
+    SynthVoices voices;
+    Crossover   crossover;
+    // Everything after the voices. The synth's own graph, compiled by synth_init() & the synth_set_ effect calls,
+    // or the graph of the last patch applied
+    SynthGraph* graph;
+    SynthGraph  ownGraph;
+    Sampler*    sampler;
+    Delay*      delay;
+    Reverb*     reverb;
+
+    // Modulation. The matrix, LFO & envelope settings may be changed between synth_process() calls
+    ModMatrix   mod;
+    Lfo         lfos[MOD_NUM_LFOS];
+    ModEnvelope envelope;
+    float       modWheel; // 0-1, from CC 1
+    // Voices are back at their unmodulated values. Cleared while anything is routed
+    int modSettled;
+    // The current pass runs at control rate
+    int modulating;
+    // Global sources for each control period of the current pass
+    float lfoValues[MOD_NUM_LFOS][SYNTH_MAX_CONTROL_PERIODS];
+    float cutoffHz[SYNTH_MAX_CONTROL_PERIODS];
+
+    // Optional, set after synth_init(). NULL renders everything on the calling thread
+    WorkPool* workers;
+    int       numTasks;
+    int       taskFrames;
+    // Output of one voice group, lane interleaved. One per task
+    SIMD_ALIGNED float scratch[SYNTH_MAX_TASKS][SYNTH_BLOCK_FRAMES * SIMD_WIDTH];
+    // In unison mode, one voice's stack before it's mixed down, & the right channel of the group. One per task
+    SIMD_ALIGNED float stack[SYNTH_MAX_TASKS][SYNTH_MAX_UNISON * SYNTH_BLOCK_FRAMES];
+    SIMD_ALIGNED float stackR[SYNTH_MAX_TASKS][SYNTH_BLOCK_FRAMES * SIMD_WIDTH];
+    // Voices summed by each task, still one voice per lane. Lanes are only added up once all tasks are done
+    SIMD_ALIGNED float acc[SYNTH_MAX_TASKS][SYNTH_NUM_CHANNELS][SYNTH_BLOCK_FRAMES * SIMD_WIDTH];
+    // Voice mix, one channel per lane, laid out for the crossover
+    SIMD_ALIGNED float mix[SYNTH_BLOCK_FRAMES * SYNTH_MIX_LANES];
+    // Master gain for each frame
+    SIMD_ALIGNED float gainRamp[SYNTH_BLOCK_FRAMES];
+    // Last note played. 0xff if none
+    uint8_t lastNote;
+} Synth;
+
+void synth_init(Synth* synth, float sampleRate);
+void synth_note_on(Synth* synth, uint8_t note, uint8_t velocity);
+void synth_note_off(Synth* synth, uint8_t note);
+void synth_all_notes_off(Synth* synth);
+void synth_handle_event(Synth* synth, const SynthEvent* event);
+// Adds a reverb after the crossover, or removes it with NULL. The Reverb is owned by the caller & must have
+// SYNTH_NUM_CHANNELS channels. Recompiles the graph, so call it between synth_process() calls
+void synth_set_reverb(Synth* synth, Reverb* reverb);
+// Adds a delay between the crossover & the reverb, or removes it with NULL. Like the reverb, the Delay is owned by
+// the caller & must have SYNTH_NUM_CHANNELS channels
+void synth_set_delay(Synth* synth, Delay* delay);
+// Plays the notes the sampler has samples for through it instead of the oscillators, or stops with NULL. The Sampler
+// is owned by the caller & mixed in before the crossover
+void synth_set_sampler(Synth* synth, Sampler* sampler);
+
+// Builds a patch for the synth at this address. Doesn't read or change the synth, so any thread may call it, even
+// before synth_init(). Effects the preset uses but the synth hasn't been given pass the signal through
+void synth_patch_build(Synth* synth, SynthPatch* patch, const SynthPreset* preset);
+// Applies a patch in constant time, replacing the graph until the next patch or synth_set_ effect call.
+// Call it between synth_process() calls. The patch is in use until then, so keep it alive & unchanged
+void synth_set_patch(Synth* synth, SynthPatch* patch);
+
+// Renders all playing voices through their filters and the crossover into an interleaved buffer of numChannels
+// (1 to SYNTH_MAX_OUTPUT_CHANNELS), overwriting it.
+// 'events' must be sorted by frame. Rendering is split at each event, so notes start on the sample they were
+// scheduled for, no matter how large the buffer is
+void synth_process(Synth* synth, const SynthEvent* events, int numEvents, float* buffer, int numFrames,
+                   int numChannels);
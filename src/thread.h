@@ -1040,8 +1040,8 @@ void thread_atomic_int_store( thread_atomic_int_t* atomic, int desired )
 
     #elif defined( __linux__ ) || defined( __APPLE__ ) || defined( __ANDROID__ )
 
-        __sync_fetch_and_and( &atomic->i, 0 );
-        __sync_fetch_and_or( &atomic->i, desired );
+        // and + or is two operations, so readers could see 0 in between
+        __atomic_store_n( &atomic->i, desired, __ATOMIC_SEQ_CST );
     
     #else 
         #error Unknown platform.
@@ -1121,9 +1121,8 @@ int thread_atomic_int_swap( thread_atomic_int_t* atomic, int desired )
     
     #elif defined( __linux__ ) || defined( __APPLE__ ) || defined( __ANDROID__ )
 
-        int old = (int)__sync_lock_test_and_set( &atomic->i, desired );
-        __sync_lock_release( &atomic->i );
-        return old;
+        // __sync_lock_release() writes 0, undoing the swap
+        return (int)__atomic_exchange_n( &atomic->i, desired, __ATOMIC_SEQ_CST );
     
     #else 
         #error Unknown platform.
@@ -1177,8 +1176,7 @@ void thread_atomic_ptr_store( thread_atomic_ptr_t* atomic, void* desired )
     
     #elif defined( __linux__ ) || defined( __APPLE__ ) || defined( __ANDROID__ )
 
-        __sync_lock_test_and_set( &atomic->ptr, desired );
-        __sync_lock_release( &atomic->ptr );
+        __atomic_store_n( &atomic->ptr, desired, __ATOMIC_SEQ_CST );
     
     #else 
         #error Unknown platform.
@@ -1199,9 +1197,7 @@ void* thread_atomic_ptr_swap( thread_atomic_ptr_t* atomic, void* desired )
     
     #elif defined( __linux__ ) || defined( __APPLE__ ) || defined( __ANDROID__ )
 
-        void* old = __sync_lock_test_and_set( &atomic->ptr, desired );
-        __sync_lock_release( &atomic->ptr );
-        return old;
+        return __atomic_exchange_n( &atomic->ptr, desired, __ATOMIC_SEQ_CST );
     
     #else 
         #error Unknown platform.
@@ -1310,7 +1306,7 @@ thread_tls_t thread_tls_create( void )
 
         pthread_key_t tls;
         if( pthread_key_create( &tls, NULL ) == 0 )
-            return (thread_tls_t) tls;
+            return (thread_tls_t) (uintptr_t) tls;
         else
             return NULL;
 
@@ -0,0 +1,183 @@
+#include "wav.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define WAV_HEADER_BYTES 44
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+static void wav_put16(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void wav_put32(uint8_t* p, uint32_t v)
+{
+    wav_put16(p, v & 0xffff);
+    wav_put16(p + 2, v >> 16);
+}
+
+static uint32_t wav_get16(const uint8_t* p) { return p[0] | (uint32_t)p[1] << 8; }
+static uint32_t wav_get32(const uint8_t* p) { return wav_get16(p) | wav_get16(p + 2) << 16; }
+
+// Files may be larger than a long on Windows
+static int wav_seek(FILE* file, long long offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static int wav_write_header(WavWriter* wav, int sampleRate)
+{
+    uint8_t  h[WAV_HEADER_BYTES];
+    uint32_t blockAlign = wav->numChannels * (uint32_t)sizeof(float);
+    uint32_t dataBytes  = wav->numFrames * blockAlign;
+
+    memcpy(h, "RIFF", 4);
+    wav_put32(h + 4, WAV_HEADER_BYTES - 8 + dataBytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    wav_put32(h + 16, 16);
+    wav_put16(h + 20, WAV_FORMAT_FLOAT);
+    wav_put16(h + 22, wav->numChannels);
+    wav_put32(h + 24, sampleRate);
+    wav_put32(h + 28, sampleRate * blockAlign);
+    wav_put16(h + 32, blockAlign);
+    wav_put16(h + 34, 32);
+    memcpy(h + 36, "data", 4);
+    wav_put32(h + 40, dataBytes);
+    return fwrite(h, 1, sizeof(h), wav->file) == sizeof(h) ? 0 : 1;
+}
+
+int wav_open(WavWriter* wav, const char* path, int sampleRate, int numChannels)
+{
+    memset(wav, 0, sizeof(*wav));
+    wav->file = fopen(path, "wb");
+    if (! wav->file)
+        return 1;
+    wav->numChannels = numChannels;
+    // Placeholder sizes, patched on close. The sample rate goes in now as it's never rewritten
+    if (wav_write_header(wav, sampleRate) != 0)
+    {
+        fclose(wav->file);
+        wav->file = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+int wav_write(WavWriter* wav, const float* samples, int numFrames)
+{
+    size_t n = (size_t)numFrames * wav->numChannels;
+    // WAV is little endian. So is every platform we build on, so samples are written as is
+    if (fwrite(samples, sizeof(float), n, wav->file) != n)
+        return 1;
+    wav->numFrames += numFrames;
+    return 0;
+}
+
+int wav_close(WavWriter* wav)
+{
+    uint8_t  sizes[4];
+    uint32_t dataBytes = wav->numFrames * wav->numChannels * (uint32_t)sizeof(float);
+    int      err       = 0;
+
+    wav_put32(sizes, WAV_HEADER_BYTES - 8 + dataBytes);
+    err |= fseek(wav->file, 4, SEEK_SET) != 0 || fwrite(sizes, 1, 4, wav->file) != 4;
+    wav_put32(sizes, dataBytes);
+    err |= fseek(wav->file, 40, SEEK_SET) != 0 || fwrite(sizes, 1, 4, wav->file) != 4;
+    err |= fclose(wav->file) != 0;
+    wav->file = NULL;
+    return err;
+}
+
+int wav_read_info(FILE* file, WavInfo* info)
+{
+    uint8_t   h[40];
+    long long offset = 12;
+    int       format = 0;
+
+    memset(info, 0, sizeof(*info));
+    if (fread(h, 1, 12, file) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0)
+        return 1;
+    // Chunks can come in any order, with others in between
+    for (;;)
+    {
+        uint32_t size;
+
+        if (wav_seek(file, offset) != 0 || fread(h, 1, 8, file) != 8)
+            return 1;
+        size   = wav_get32(h + 4);
+        offset += 8;
+        if (memcmp(h, "fmt ", 4) == 0)
+        {
+            size_t n = size < sizeof(h) ? size : sizeof(h);
+            if (n < 16 || fread(h, 1, n, file) != n)
+                return 1;
+            format              = (int)wav_get16(h);
+            info->numChannels   = (int)wav_get16(h + 2);
+            info->sampleRate    = (int)wav_get32(h + 4);
+            info->bitsPerSample = (int)wav_get16(h + 14);
+            // The real format is the first 2 bytes of the sub format GUID
+            if (format == WAV_FORMAT_EXTENSIBLE && n >= 26)
+                format = (int)wav_get16(h + 24);
+        }
+        else if (memcmp(h, "data", 4) == 0)
+        {
+            info->dataOffset = offset;
+            break;
+        }
+        // Chunks are padded to an even size
+        offset += size + (size & 1);
+    }
+
+    info->isFloat       = format == WAV_FORMAT_FLOAT;
+    info->bytesPerFrame = info->numChannels * info->bitsPerSample / 8;
+    if (info->numChannels <= 0 || info->sampleRate <= 0)
+        return 1;
+    if (! (format == WAV_FORMAT_PCM && (info->bitsPerSample == 16 || info->bitsPerSample == 24)) &&
+        ! (format == WAV_FORMAT_FLOAT && info->bitsPerSample == 32))
+        return 1;
+    info->numFrames = wav_get32(h + 4) / info->bytesPerFrame;
+    return 0;
+}
+
+int wav_read_frames(FILE* file, const WavInfo* info, unsigned int frame, float* samples, int numFrames)
+{
+    uint8_t   bytes[4096];
+    const int framesPerRead = (int)sizeof(bytes) / info->bytesPerFrame;
+    int       done          = 0;
+
+    if (frame >= info->numFrames)
+        return 0;
+    numFrames = numFrames < (int)(info->numFrames - frame) ? numFrames : (int)(info->numFrames - frame);
+    if (wav_seek(file, info->dataOffset + (long long)frame * info->bytesPerFrame) != 0)
+        return 0;
+
+    while (done < numFrames)
+    {
+        int n = numFrames - done < framesPerRead ? numFrames - done : framesPerRead;
+        n     = (int)fread(bytes, info->bytesPerFrame, n, file);
+        if (n <= 0)
+            break;
+
+        const int      count = n * info->numChannels;
+        const uint8_t* p     = bytes;
+        float*         out   = samples + done * info->numChannels;
+        if (info->isFloat)
+            memcpy(out, bytes, count * sizeof(float));
+        else if (info->bitsPerSample == 16)
+            for (int i = 0; i < count; i++, p += 2)
+                out[i] = (float)(int16_t)wav_get16(p) * (1.0f / 32768.0f);
+        else
+            for (int i = 0; i < count; i++, p += 3)
+                out[i] = (float)((int32_t)(wav_get16(p) << 8 | (uint32_t)p[2] << 24) >> 8) * (1.0f / 8388608.0f);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdio.h>
+
+// Streams interleaved 32 bit float samples to a WAV file. The header sizes are patched in wav_close()
+// Reading takes 16 or 24 bit PCM or 32 bit float, in chunks from any frame, so long files can be streamed
+
+typedef struct WavWriter
+{
+    FILE*        file;
+    int          numChannels;
+    unsigned int numFrames;
+} WavWriter;
+
+// Returns 0 on success. On failure nothing is left open
+int  wav_open(WavWriter* wav, const char* path, int sampleRate, int numChannels);
+int  wav_write(WavWriter* wav, const float* samples, int numFrames);
+int  wav_close(WavWriter* wav);
+
+typedef struct WavInfo
+{
+    int          sampleRate;
+    int          numChannels;
+    int          bitsPerSample;
+    int          isFloat;
+    int          bytesPerFrame;
+    long long    dataOffset; // bytes from the start of the file
+    unsigned int numFrames;
+} WavInfo;
+
+// Parses the header. Returns 0 on success, non zero if it isn't a WAV file in one of the formats above
+int wav_read_info(FILE* file, WavInfo* info);
+// Reads up to numFrames from 'frame' on, converted to interleaved floats. Returns the number of frames read
+int wav_read_frames(FILE* file, const WavInfo* info, unsigned int frame, float* samples, int numFrames);
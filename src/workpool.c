@@ -0,0 +1,197 @@
+#if defined(__linux__)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+#include "workpool.h"
+#include "simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define WORKPOOL_TASK_BITS 16
+#define WORKPOOL_TASK_MASK ((1 << WORKPOOL_TASK_BITS) - 1)
+#define WORKPOOL_GEN_MASK 0x7fff
+
+static inline void workpool_pause(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(_MSC_VER)
+    __yield();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static int64_t workpool_now_us(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER        now;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (int64_t)((double)now.QuadPart * 1e6 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+int workpool_num_cores(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// Keeps the worker on one core, so its cache stays warm between callbacks. macOS has no API for this
+static void workpool_pin(int core)
+{
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core;
+#endif
+}
+
+// Claims & runs tasks of job 'gen' until there are none left
+static void workpool_work(WorkPool* pool, int gen)
+{
+    for (;;)
+    {
+        int next = thread_atomic_int_load(&pool->next);
+        int task = next & WORKPOOL_TASK_MASK;
+        if ((next >> WORKPOOL_TASK_BITS) != gen || task >= pool->numTasks)
+            return;
+        if (thread_atomic_int_compare_and_swap(&pool->next, next, next + 1) != next)
+            continue;
+
+        // The job can't finish, or be replaced, before this task is done
+        pool->task(pool->userdata, task);
+        thread_atomic_int_inc(&pool->done);
+    }
+}
+
+static int workpool_thread(void* userdata)
+{
+    WorkPoolWorker* worker    = userdata;
+    WorkPool*       pool      = worker->pool;
+    int             lastGen   = 0;
+    int64_t         idleSince = workpool_now_us();
+
+    // Core 0 is left for the audio & UI threads
+    workpool_pin((worker->index + 1) % workpool_num_cores());
+    thread_set_high_priority();
+    // Workers run DSP, so they need the same floating point mode as the audio thread
+    simd_flush_denormals();
+
+    while (thread_atomic_int_load(&pool->exit) == 0)
+    {
+        int gen = thread_atomic_int_load(&pool->next) >> WORKPOOL_TASK_BITS;
+        if (gen != lastGen)
+        {
+            workpool_work(pool, gen);
+            lastGen   = gen;
+            idleSince = workpool_now_us();
+            continue;
+        }
+
+        if (workpool_now_us() - idleSince < thread_atomic_int_load(&pool->spinUs))
+        {
+            workpool_pause();
+            continue;
+        }
+
+        // Flag first, then check again. Either we see the new job, or the caller sees the flag & raises the signal.
+        // Timing out goes straight back to sleep, only a job restarts the spinning
+        thread_atomic_int_store(&pool->sleeping[worker->index], 1);
+        if ((thread_atomic_int_load(&pool->next) >> WORKPOOL_TASK_BITS) == lastGen)
+            thread_signal_wait(&pool->wake[worker->index], 100);
+        thread_atomic_int_store(&pool->sleeping[worker->index], 0);
+    }
+    return 0;
+}
+
+void workpool_init(WorkPool* pool, int numWorkers)
+{
+    memset(pool, 0, sizeof(*pool));
+    numWorkers       = numWorkers < WORKPOOL_MAX_WORKERS ? numWorkers : WORKPOOL_MAX_WORKERS;
+    pool->numWorkers = numWorkers > 0 ? numWorkers : 0;
+    thread_atomic_int_store(&pool->spinUs, 2000);
+
+    for (int i = 0; i < pool->numWorkers; i++)
+    {
+        pool->workers[i].pool  = pool;
+        pool->workers[i].index = i;
+        thread_signal_init(&pool->wake[i]);
+        pool->threads[i] = thread_create(workpool_thread, &pool->workers[i], THREAD_STACK_SIZE_DEFAULT);
+    }
+}
+
+void workpool_shutdown(WorkPool* pool)
+{
+    thread_atomic_int_store(&pool->exit, 1);
+    for (int i = 0; i < pool->numWorkers; i++)
+    {
+        thread_signal_raise(&pool->wake[i]);
+        thread_join(pool->threads[i]);
+        thread_destroy(pool->threads[i]);
+        thread_signal_term(&pool->wake[i]);
+    }
+    pool->numWorkers = 0;
+}
+
+void workpool_set_spin(WorkPool* pool, int microseconds) { thread_atomic_int_store(&pool->spinUs, microseconds); }
+
+void workpool_run(WorkPool* pool, WorkPoolTask task, void* userdata, int numTasks)
+{
+    if (pool->numWorkers == 0 || numTasks <= 1)
+    {
+        for (int i = 0; i < numTasks; i++)
+            task(userdata, i);
+        return;
+    }
+
+    pool->task       = task;
+    pool->userdata   = userdata;
+    pool->numTasks   = numTasks;
+    // Generation 0 is what workers start on, so it's never used for a job
+    pool->generation = (pool->generation & WORKPOOL_GEN_MASK) + 1;
+    pool->generation = pool->generation > WORKPOOL_GEN_MASK ? 1 : pool->generation;
+    thread_atomic_int_store(&pool->done, 0);
+    // Publishes the job
+    thread_atomic_int_store(&pool->next, pool->generation << WORKPOOL_TASK_BITS);
+
+    for (int i = 0; i < pool->numWorkers; i++)
+        if (thread_atomic_int_load(&pool->sleeping[i]))
+            thread_signal_raise(&pool->wake[i]);
+
+    workpool_work(pool, pool->generation);
+    // Only tasks that have already started are left
+    while (thread_atomic_int_load(&pool->done) < numTasks)
+        workpool_pause();
+}
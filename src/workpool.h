@@ -0,0 +1,50 @@
+#pragma once
+#include "thread.h"
+
+// Small pool of worker threads for splitting the audio callback across cores.
+// A job is split into independent tasks. Threads claim tasks one at a time from a shared counter, so when a worker
+// is busy or descheduled the others, including the calling thread, steal its share. The caller always works too and
+// only waits for tasks that have already started, never for a sleeping worker to wake up.
+// After a job, workers spin for about one callback so the next one finds them awake, then sleep on a signal.
+
+#define WORKPOOL_MAX_WORKERS 8
+
+typedef void (*WorkPoolTask)(void* userdata, int task);
+
+typedef struct WorkPoolWorker
+{
+    struct WorkPool* pool;
+    int              index;
+} WorkPoolWorker;
+
+typedef struct WorkPool
+{
+    int            numWorkers;
+    thread_ptr_t   threads[WORKPOOL_MAX_WORKERS];
+    WorkPoolWorker workers[WORKPOOL_MAX_WORKERS];
+    // Workers flag themselves before sleeping, the caller only raises their signal if set
+    thread_signal_t     wake[WORKPOOL_MAX_WORKERS];
+    thread_atomic_int_t sleeping[WORKPOOL_MAX_WORKERS];
+    thread_atomic_int_t spinUs;
+    thread_atomic_int_t exit;
+
+    // Current job. Written by the caller before the job is published
+    WorkPoolTask task;
+    void*        userdata;
+    int          numTasks;
+    int          generation;
+    // Job generation in the high bits, next unclaimed task in the low bits.
+    // Claims are tagged, so a slow worker can't take a task from the following job
+    thread_atomic_int_t next;
+    thread_atomic_int_t done;
+} WorkPool;
+
+// Logical cores available to the process
+int workpool_num_cores(void);
+// Starts numWorkers threads, each pinned to its own core where the OS allows. 0 runs everything on the caller
+void workpool_init(WorkPool* pool, int numWorkers);
+void workpool_shutdown(WorkPool* pool);
+// How long idle workers spin before sleeping. Set it to the audio callback's period
+void workpool_set_spin(WorkPool* pool, int microseconds);
+// Runs task(userdata, 0 ... numTasks - 1) across the pool & the calling thread. Returns when all are finished
+void workpool_run(WorkPool* pool, WorkPoolTask task, void* userdata, int numTasks);
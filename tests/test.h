@@ -0,0 +1,48 @@
+#pragma once
+// Helpers shared by the tests.
+// A failed check prints what failed on stderr & the test carries on, so one run reports every failure. main returns
+// test_finish(), which ctest sees as the test's result.
+#include "synth.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_SAMPLE_RATE 48000
+#define TEST_NUM_CHANNELS 2
+#define TEST_BLOCK_FRAMES 256
+
+static Synth gTestSynth;
+static float gTestBuffer[TEST_BLOCK_FRAMES * TEST_NUM_CHANNELS];
+static int   gTestFailures;
+
+static inline void test_check(int ok, const char* what)
+{
+    if (! ok)
+    {
+        fprintf(stderr, "FAIL: %s\n", what);
+        gTestFailures++;
+    }
+}
+
+static inline int test_finish(const char* name)
+{
+    if (gTestFailures)
+        return EXIT_FAILURE;
+    printf("%s passed\n", name);
+    return EXIT_SUCCESS;
+}
+
+// Runs gTestSynth for about 'seconds', stereo. Returns non zero if every sample it output was finite
+static inline int test_render(float seconds)
+{
+    int finite = 1;
+
+    for (int n = (int)(seconds * TEST_SAMPLE_RATE / TEST_BLOCK_FRAMES); n > 0; n--)
+    {
+        synth_process(&gTestSynth, NULL, 0, gTestBuffer, TEST_BLOCK_FRAMES, TEST_NUM_CHANNELS);
+        for (int i = 0; i < TEST_BLOCK_FRAMES * TEST_NUM_CHANNELS; i++)
+            finite &= isfinite(gTestBuffer[i]) != 0;
+    }
+    return finite;
+}
@@ -0,0 +1,40 @@
+// Amp envelope stages, through the synth.
+// A released voice must keep releasing when the sustain level changes, even when its release coefficients are the
+// same as the decay ones (a sustain of 0 & decay as long as release). It used to be taken for a held note, sent to
+// the new sustain level & never freed.
+#include "test.h"
+
+static void start(float sustain)
+{
+    synth_init(&gTestSynth, TEST_SAMPLE_RATE);
+    gTestSynth.ampEnvelope = (AdsrParams){.attack = 0.005f, .decay = 0.3f, .sustain = sustain, .release = 0.3f};
+    synth_note_on(&gTestSynth, 60, 100);
+    test_render(0.1f);
+}
+
+int main(void)
+{
+    // Released during the decay, then the sustain level changes
+    start(0.0f);
+    test_check(adsr_stage(&gTestSynth.voices.amp, 0) == ADSR_DECAY, "voice decays after the attack");
+    synth_note_off(&gTestSynth, 60);
+    test_render(0.05f);
+    test_check(adsr_stage(&gTestSynth.voices.amp, 0) == ADSR_RELEASE, "voice releases after note off");
+    gTestSynth.ampEnvelope.sustain = 0.5f;
+    test_render(4.0f);
+    test_check(gTestSynth.voices.numActive == 0, "released voice is freed after the sustain level changes");
+
+    // Held notes do move to the new sustain level
+    start(0.0f);
+    gTestSynth.ampEnvelope.sustain = 0.5f;
+    test_render(4.0f);
+    test_check(gTestSynth.voices.numActive == 1, "held voice keeps playing");
+    test_check(fabsf(gTestSynth.voices.amp.level[0] - 0.5f) < 0.01f, "held voice is at the new sustain");
+
+    // Decaying to a sustain of 0 finishes the voice without a note off
+    start(0.0f);
+    test_render(4.0f);
+    test_check(gTestSynth.voices.numActive == 0, "voice that decayed to a sustain of 0 is freed");
+
+    return test_finish("test_adsr");
+}
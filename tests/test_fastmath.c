@@ -0,0 +1,96 @@
+// Accuracy of the fast math approximations, scalar & SIMD.
+// Each function is swept over its documented range and compared with the double precision libm result. It must
+// stay within the bound documented in fastmath.h. bench_fastmath times the same kernels.
+#include "fastmath.h"
+#include "test.h"
+
+#define SWEEP_SIZE (1 << 20)
+
+static SIMD_ALIGNED float gIn[SWEEP_SIZE];
+static SIMD_ALIGNED float gOut[SWEEP_SIZE];
+
+typedef void (*Kernel)(const float* in, float* out, int n);
+
+#define DEFINE_KERNELS(NAME, FAST)                                                                                    \
+    static void NAME##_scalar(const float* in, float* out, int n)                                                     \
+    {                                                                                                                 \
+        for (int i = 0; i < n; i++)                                                                                   \
+            out[i] = FAST(in[i]);                                                                                     \
+    }                                                                                                                 \
+    static void NAME##_lanes(const float* in, float* out, int n)                                                      \
+    {                                                                                                                 \
+        for (int i = 0; i < n; i += SIMD_WIDTH)                                                                       \
+            simd_store(&out[i], FAST##_lanes(simd_load(&in[i])));                                                     \
+    }
+
+static double ref_db_to_gain(double db) { return pow(10.0, db / 20.0); }
+static double ref_gain_to_db(double g) { return 20.0 * log10(g); }
+
+DEFINE_KERNELS(exp2, fast_exp2)
+DEFINE_KERNELS(log2, fast_log2)
+DEFINE_KERNELS(tan, fast_tan)
+DEFINE_KERNELS(db_to_gain, fast_db_to_gain)
+DEFINE_KERNELS(gain_to_db, fast_gain_to_db)
+
+typedef struct MathFunc
+{
+    const char* name;
+    double      lo, hi;
+    int         logSweep; // sweep lo to hi as powers of 2
+    int         relative; // relative error, or absolute below 1 & relative above
+    double      bound;    // as documented in fastmath.h
+    double (*reference)(double);
+    Kernel kernels[2];
+} MathFunc;
+
+static const char* gKernelNames[2] = {"scalar", SIMD_NAME};
+
+static const MathFunc gFuncs[] = {
+    {"exp2", -126, 127, 0, 1, 3e-7, exp2, {exp2_scalar, exp2_lanes}},
+    {"log2", -126, 127, 1, 0, 5e-7, log2, {log2_scalar, log2_lanes}},
+    {"tan", 0, 0.49 * 3.141592653589793, 0, 1, 2e-6, tan, {tan_scalar, tan_lanes}},
+    {"db_to_gain", -120, 40, 0, 1, 1e-6, ref_db_to_gain, {db_to_gain_scalar, db_to_gain_lanes}},
+    {"gain_to_db", -126, 127, 1, 0, 3e-6, ref_gain_to_db, {gain_to_db_scalar, gain_to_db_lanes}},
+};
+
+#define COUNT(arr) (int)(sizeof(arr) / sizeof(arr[0]))
+
+static double max_error(const MathFunc* func, Kernel kernel)
+{
+    double worst = 0;
+
+    for (int i = 0; i < SWEEP_SIZE; i++)
+    {
+        double u = func->lo + (func->hi - func->lo) * i / (SWEEP_SIZE - 1);
+        gIn[i]   = (float)(func->logSweep ? exp2(u) : u);
+    }
+    kernel(gIn, gOut, SWEEP_SIZE);
+    for (int i = 0; i < SWEEP_SIZE; i++)
+    {
+        // Compared with the exact result for the float input, so input rounding isn't counted
+        double want = func->reference(gIn[i]);
+        double err  = fabs(gOut[i] - want);
+        if (func->relative || fabs(want) > 1)
+            err /= fabs(want);
+        worst = err > worst ? err : worst;
+    }
+    return worst;
+}
+
+int main(void)
+{
+    for (int f = 0; f < COUNT(gFuncs); f++)
+    {
+        const MathFunc* func = &gFuncs[f];
+        for (int k = 0; k < COUNT(gKernelNames); k++)
+        {
+            double err = max_error(func, func->kernels[k]);
+            char   text[96];
+
+            snprintf(text, sizeof(text), "%s %s: %s error %.3g is above %.0e", func->name, gKernelNames[k],
+                     func->relative ? "relative" : "mixed", err, func->bound);
+            test_check(err <= func->bound, text);
+        }
+    }
+    return test_finish("test_fastmath");
+}
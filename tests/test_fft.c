@@ -0,0 +1,138 @@
+// Accuracy of the FFTs in fft.h, complex & real, for every supported size.
+// Spectra of random input are compared with a double precision naive DFT, every bin up to NAIVE_ALL_BINS points
+// and a spread of NAIVE_SOME_BINS bins above, where checking all of them would take minutes. Inverse(forward(x))
+// is compared with N * x. Errors are relative to the largest value of the reference & must stay below ERROR_BOUND.
+// bench_fft times the same transforms.
+#include "fft.h"
+#include "test.h"
+
+#include <string.h>
+
+#define NAIVE_ALL_BINS 4096
+#define NAIVE_SOME_BINS 256
+#define ERROR_BOUND 1e-5
+
+static SIMD_ALIGNED float gIn[2][FFT_MAX_SIZE];
+static SIMD_ALIGNED float gRe[FFT_MAX_SIZE + SIMD_WIDTH];
+static SIMD_ALIGNED float gIm[FFT_MAX_SIZE + SIMD_WIDTH];
+static SIMD_ALIGNED float gOut[FFT_MAX_SIZE];
+
+static void fill_random(int n)
+{
+    unsigned state = 0x12345678u;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            state     ^= state << 13;
+            state     ^= state >> 17;
+            state     ^= state << 5;
+            gIn[c][i] = (float)state / 4294967296.0f * 2.0f - 1.0f;
+        }
+    }
+}
+
+// Bin k of the DFT of gIn[0] + i gIn[1], or of gIn[0] alone when 'real'
+static void naive_bin(int n, int k, int real, double* re, double* im)
+{
+    static const double pi = 3.14159265358979323846;
+
+    double sr = 0, si = 0;
+    for (int i = 0; i < n; i++)
+    {
+        // k * i wraps, which keeps the angle small & accurate
+        double angle = -2.0 * pi * (double)(((long long)k * i) % n) / n;
+        double xr    = gIn[0][i];
+        double xi    = real ? 0.0 : gIn[1][i];
+        sr           += xr * cos(angle) - xi * sin(angle);
+        si           += xr * sin(angle) + xi * cos(angle);
+    }
+    *re = sr;
+    *im = si;
+}
+
+// gRe & gIm hold numBins bins of the transform under test
+static double spectrum_error(int n, int numBins, int real)
+{
+    int    step  = numBins <= NAIVE_ALL_BINS ? 1 : numBins / NAIVE_SOME_BINS;
+    double worst = 0, peak = 0;
+
+    for (int k = 0; k < numBins; k += step)
+    {
+        // Odd offsets so the spread doesn't only visit multiples of a power of two
+        int    bin = step > 1 ? (k + k / step % 7) % numBins : k;
+        double re, im;
+        naive_bin(n, bin, real, &re, &im);
+        double err = hypot(gRe[bin] - re, gIm[bin] - im);
+        double mag = hypot(re, im);
+        worst      = err > worst ? err : worst;
+        peak       = mag > peak ? mag : peak;
+    }
+    return worst / peak;
+}
+
+// 'out' should be n * 'in'
+static double roundtrip_error(const float* in, const float* out, int n)
+{
+    double worst = 0, peak = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double err = fabs(out[i] - (double)n * in[i]);
+        double mag = fabs((double)n * in[i]);
+        worst      = err > worst ? err : worst;
+        peak       = mag > peak ? mag : peak;
+    }
+    return worst / peak;
+}
+
+static void check_error(const char* transform, int n, const char* what, double error)
+{
+    char text[96];
+
+    snprintf(text, sizeof(text), "%s FFT of %d points: %s error %.3g", transform, n, what, error);
+    test_check(error <= ERROR_BOUND, text);
+}
+
+static void check_complex(int n)
+{
+    FftPlan plan;
+
+    if (fft_plan_init(&plan, n) != 0)
+    {
+        test_check(0, "complex plan allocates");
+        return;
+    }
+    memcpy(gRe, gIn[0], n * sizeof(float));
+    memcpy(gIm, gIn[1], n * sizeof(float));
+    fft_forward(&plan, gRe, gIm);
+    check_error("complex", n, "spectrum", spectrum_error(n, n, 0));
+    fft_inverse(&plan, gRe, gIm);
+    check_error("complex", n, "round trip", fmax(roundtrip_error(gIn[0], gRe, n), roundtrip_error(gIn[1], gIm, n)));
+    fft_plan_free(&plan);
+}
+
+static void check_real(int n)
+{
+    FftRealPlan plan;
+
+    if (fft_real_plan_init(&plan, n) != 0)
+    {
+        test_check(0, "real plan allocates");
+        return;
+    }
+    fft_real_forward(&plan, gIn[0], gRe, gIm);
+    check_error("real", n, "spectrum", spectrum_error(n, n / 2 + 1, 1));
+    fft_real_inverse(&plan, gRe, gIm, gOut);
+    check_error("real", n, "round trip", roundtrip_error(gIn[0], gOut, n));
+    fft_real_plan_free(&plan);
+}
+
+int main(void)
+{
+    fill_random(FFT_MAX_SIZE);
+    for (int n = FFT_MIN_SIZE; n <= FFT_MAX_SIZE; n *= 2)
+        check_complex(n);
+    for (int n = FFT_MIN_SIZE; n <= FFT_MAX_SIZE; n *= 2)
+        check_real(n);
+    return test_finish("test_fft");
+}
@@ -0,0 +1,131 @@
+// Preset encoding & decoding.
+// Factory presets survive a round trip unchanged. Broken files are rejected, & finite but out of range values are
+// clamped to the UI's ranges, so a file can't hand the audio thread values it turns into NaN (a detune of 1e6 used
+// to silence the output, the delay & the reverb for good).
+#include "test.h"
+
+#include <string.h>
+
+static SynthPatch gPatch;
+static Delay      gDelay;
+
+static int in_range(float x, float min, float max) { return x >= min && x <= max; }
+
+static int envelope_in_range(float attack, float decay, float sustain, float release)
+{
+    return in_range(attack, 0, PRESET_ATTACK_MAX) && in_range(decay, 0, PRESET_DECAY_MAX) && in_range(sustain, 0, 1) &&
+           in_range(release, 0, PRESET_RELEASE_MAX);
+}
+
+static void check_round_trip(void)
+{
+    for (int i = 0; i < PRESET_NUM_FACTORY; i++)
+    {
+        SynthPreset preset, decoded;
+        uint8_t     data[PRESET_MAX_BYTES];
+        int         size;
+
+        preset_factory(&preset, i);
+        size = preset_encode(&preset, data);
+        test_check(size <= PRESET_MAX_BYTES, "encoded preset fits");
+        test_check(preset_decode(&decoded, data, size) == 0, "factory preset decodes");
+        test_check(memcmp(&preset, &decoded, sizeof(preset)) == 0, "factory preset round trips");
+        test_check(preset_decode(&decoded, data, size - 1) != 0, "truncated preset is rejected");
+        data[4] = PRESET_VERSION + 1;
+        test_check(preset_decode(&decoded, data, size) != 0, "newer version is rejected");
+    }
+}
+
+// Every float field as large as it gets, the wrong way or the right way
+static void make_extreme(SynthPreset* p, float big)
+{
+    preset_factory(p, 0);
+    p->gaindB      = big;
+    p->cutoff      = big;
+    p->crossover   = -big;
+    p->ampEnvelope = (AdsrParams){.attack = big, .decay = -big, .sustain = big, .release = big};
+    p->unison      = SYNTH_MAX_UNISON;
+    p->detune      = big;
+    p->unisonWidth = -big;
+    p->lfos[0]     = (Lfo){.shape = LFO_SINE, .rateHz = big};
+    p->lfos[1]     = (Lfo){.shape = LFO_SQUARE, .rateHz = -big};
+    p->envelope    = (ModEnvelope){.attack = -big, .decay = big, .sustain = -big, .release = big};
+    p->effects     = PRESET_DELAY | PRESET_REVERB;
+    p->delayType   = DELAY_FLANGER;
+    p->delayMix    = big;
+    p->reverbWet   = big;
+    modmatrix_add(&p->mod, MOD_SRC_LFO1, MOD_DST_PITCH, big);
+    modmatrix_add(&p->mod, MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, -big);
+    modmatrix_add(&p->mod, MOD_SRC_VELOCITY, MOD_DST_GAIN, big);
+}
+
+static void check_extreme(float big)
+{
+    SynthPreset preset, p;
+    uint8_t     data[PRESET_MAX_BYTES];
+
+    make_extreme(&preset, big);
+    test_check(preset_decode(&p, data, preset_encode(&preset, data)) == 0, "extreme preset decodes");
+    test_check(in_range(p.gaindB, PRESET_GAIN_DB_MIN, PRESET_GAIN_DB_MAX), "gain is clamped");
+    test_check(in_range(p.cutoff, 0, 1) && in_range(p.crossover, 0, 1), "cutoffs are clamped");
+    test_check(envelope_in_range(p.ampEnvelope.attack, p.ampEnvelope.decay, p.ampEnvelope.sustain,
+                                 p.ampEnvelope.release),
+               "amp envelope is clamped");
+    test_check(in_range(p.detune, 0, PRESET_DETUNE_MAX) && in_range(p.unisonWidth, 0, 1), "unison is clamped");
+    for (int i = 0; i < MOD_NUM_LFOS; i++)
+        test_check(in_range(p.lfos[i].rateHz, PRESET_LFO_RATE_MIN, PRESET_LFO_RATE_MAX), "LFO rate is clamped");
+    test_check(envelope_in_range(p.envelope.attack, p.envelope.decay, p.envelope.sustain, p.envelope.release),
+               "mod envelope is clamped");
+    test_check(in_range(p.mod.slots[0].amount, -PRESET_MOD_PITCH_MAX, PRESET_MOD_PITCH_MAX) &&
+                   in_range(p.mod.slots[1].amount, -PRESET_MOD_CUTOFF_MAX, PRESET_MOD_CUTOFF_MAX) &&
+                   in_range(p.mod.slots[2].amount, -PRESET_MOD_GAIN_MAX, PRESET_MOD_GAIN_MAX),
+               "mod amounts are clamped");
+    test_check(in_range(p.delayMix, 0, 1) && in_range(p.reverbWet, 0, 1), "effect levels are clamped");
+
+    // Played through the synth & the delay's feedback
+    synth_init(&gTestSynth, TEST_SAMPLE_RATE);
+    synth_set_delay(&gTestSynth, &gDelay);
+    synth_patch_build(&gTestSynth, &gPatch, &p);
+    synth_set_patch(&gTestSynth, &gPatch);
+    synth_note_on(&gTestSynth, 60, 127);
+    synth_note_on(&gTestSynth, 67, 127);
+    test_check(test_render(1.0f), "extreme preset renders finite audio");
+}
+
+// Routes with no amount, as older builds of the app saved them, are dropped on load
+static void check_empty_routes(void)
+{
+    SynthPreset preset, p;
+    uint8_t     data[PRESET_MAX_BYTES];
+
+    preset_factory(&preset, 0);
+    modmatrix_clear(&preset.mod);
+    preset.mod.slots[0] = (ModSlot){MOD_SRC_LFO1, MOD_DST_PITCH, 0.0f};
+    preset.mod.slots[1] = (ModSlot){MOD_SRC_ENVELOPE, MOD_DST_CUTOFF, 2.0f};
+    preset.mod.slots[2] = (ModSlot){MOD_SRC_MODWHEEL, MOD_DST_CUTOFF, 0.0f};
+    preset.mod.numSlots = 3;
+    test_check(preset_decode(&p, data, preset_encode(&preset, data)) == 0, "preset with empty routes decodes");
+    test_check(p.mod.numSlots == 1 && p.mod.slots[0].source == MOD_SRC_ENVELOPE && p.mod.slots[0].amount == 2.0f,
+               "empty routes are dropped");
+
+    modmatrix_add(&p.mod, MOD_SRC_LFO2, MOD_DST_GAIN, 1.0f);
+    modmatrix_remove(&p.mod, 0);
+    modmatrix_clear(&preset.mod);
+    modmatrix_add(&preset.mod, MOD_SRC_LFO2, MOD_DST_GAIN, 1.0f);
+    test_check(memcmp(&p.mod, &preset.mod, sizeof(p.mod)) == 0, "removed route leaves the matrix as if never added");
+}
+
+int main(void)
+{
+    if (delay_init(&gDelay, TEST_NUM_CHANNELS, TEST_SAMPLE_RATE, 1.0f) != 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+    check_round_trip();
+    check_empty_routes();
+    check_extreme(1e6f);
+    check_extreme(3e38f);
+    delay_free(&gDelay);
+    return test_finish("test_preset");
+}